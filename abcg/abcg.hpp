@@ -16,8 +16,14 @@
 #include "abcgApplication.hpp"
 #include "abcgException.hpp"
 #include "abcgExternal.hpp"
+#include "abcgMappedFile.hpp"
+#include "abcgMeshCache.hpp"
+#include "abcgMeshOptimizer.hpp"
+#include "abcgMeshSimplifier.hpp"
+#include "abcgObjModel.hpp"
 #include "abcgTrackball.hpp"
 #include "abcgUtil.hpp"
+#include "abcgVertexLayout.hpp"
 #include "abcgWindow.hpp"
 
 #endif
\ No newline at end of file
@@ -11,10 +11,315 @@
 #include "abcgImage.hpp"
 
 #include <cppitertools/itertools.hpp>
+#include <fmt/core.h>
 #include <gsl/gsl>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
 #include <span>
-#include <vector>
+#include <string>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+#include "abcgException.hpp"
+#include "abcgThreadPool.hpp"
+
+// Row kernels of flipHorizontally and flipVertically. Each kernel processes
+// blocks of pixels with the widest instruction set enabled at compile time,
+// and the remaining pixels with scalar code.
+namespace {
+// Swaps the pixels pointed to by lhs and rhs
+template <std::size_t BytesPerPixel>
+void swapPixel(std::byte *lhs, std::byte *rhs) {
+  std::array<std::byte, BytesPerPixel> pixel{};
+  std::memcpy(pixel.data(), lhs, BytesPerPixel);
+  std::memcpy(lhs, rhs, BytesPerPixel);
+  std::memcpy(rhs, pixel.data(), BytesPerPixel);
+}
+
+// Reverses blocks of RGBA pixels from both ends of [first, last), and moves
+// first and last to the range that is left to reverse
+void reverseBlocksRGBA(std::byte *&first, std::byte *&last) {
+#if defined(__AVX2__)
+  // 8 pixels per block
+  auto const reverse{_mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)};
+  while (last - first >= 64) {
+    last -= 32;
+    auto *const lhs{reinterpret_cast<__m256i *>(first)};
+    auto *const rhs{reinterpret_cast<__m256i *>(last)};
+    auto const left{_mm256_loadu_si256(lhs)};
+    auto const right{_mm256_loadu_si256(rhs)};
+    _mm256_storeu_si256(lhs, _mm256_permutevar8x32_epi32(right, reverse));
+    _mm256_storeu_si256(rhs, _mm256_permutevar8x32_epi32(left, reverse));
+    first += 32;
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  // 4 pixels per block
+  while (last - first >= 32) {
+    last -= 16;
+    auto *const lhs{reinterpret_cast<__m128i *>(first)};
+    auto *const rhs{reinterpret_cast<__m128i *>(last)};
+    auto const left{_mm_loadu_si128(lhs)};
+    auto const right{_mm_loadu_si128(rhs)};
+    _mm_storeu_si128(lhs, _mm_shuffle_epi32(right, _MM_SHUFFLE(0, 1, 2, 3)));
+    _mm_storeu_si128(rhs, _mm_shuffle_epi32(left, _MM_SHUFFLE(0, 1, 2, 3)));
+    first += 16;
+  }
+#elif defined(__ARM_NEON)
+  // 4 pixels per block
+  auto const reverse{[](uint32x4_t pixels) {
+    auto const reversedPairs{vrev64q_u32(pixels)};
+    return vcombine_u32(vget_high_u32(reversedPairs),
+                        vget_low_u32(reversedPairs));
+  }};
+  while (last - first >= 32) {
+    last -= 16;
+    auto *const lhs{reinterpret_cast<std::uint32_t *>(first)};
+    auto *const rhs{reinterpret_cast<std::uint32_t *>(last)};
+    auto const left{vld1q_u32(lhs)};
+    auto const right{vld1q_u32(rhs)};
+    vst1q_u32(lhs, reverse(right));
+    vst1q_u32(rhs, reverse(left));
+    first += 16;
+  }
+#elif defined(__wasm_simd128__)
+  // 4 pixels per block
+  while (last - first >= 32) {
+    last -= 16;
+    auto const left{wasm_v128_load(first)};
+    auto const right{wasm_v128_load(last)};
+    wasm_v128_store(first, wasm_i32x4_shuffle(right, right, 3, 2, 1, 0));
+    wasm_v128_store(last, wasm_i32x4_shuffle(left, left, 3, 2, 1, 0));
+    first += 16;
+  }
+#else
+  static_cast<void>(first);
+  static_cast<void>(last);
+#endif
+}
+
+// Reverses blocks of RGB pixels from both ends of [first, last), and moves
+// first and last to the range that is left to reverse
+void reverseBlocksRGB(std::byte *&first, std::byte *&last) {
+#if defined(__SSSE3__) || defined(__AVX2__)
+  // 4 pixels (12 bytes) per block. The left block is loaded with the 4 bytes
+  // that follow it, and the right block with the 4 bytes that precede it.
+  auto const reverseLeft{
+      _mm_setr_epi8(9, 10, 11, 6, 7, 8, 3, 4, 5, 0, 1, 2, -1, -1, -1, -1)};
+  auto const reverseRight{
+      _mm_setr_epi8(13, 14, 15, 10, 11, 12, 7, 8, 9, 4, 5, 6, -1, -1, -1, -1)};
+  auto const store{[](std::byte *destination, __m128i pixels) {
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(destination), pixels);
+    auto const tail{_mm_cvtsi128_si32(_mm_srli_si128(pixels, 8))};
+    std::memcpy(destination + 8, &tail, 4);
+  }};
+  while (last - first >= 24) {
+    last -= 12;
+    auto const left{_mm_loadu_si128(reinterpret_cast<__m128i *>(first))};
+    auto const right{_mm_loadu_si128(reinterpret_cast<__m128i *>(last - 4))};
+    store(first, _mm_shuffle_epi8(right, reverseRight));
+    store(last, _mm_shuffle_epi8(left, reverseLeft));
+    first += 12;
+  }
+#elif defined(__ARM_NEON)
+  // 8 pixels (24 bytes) per block, deinterleaved into channels
+  auto const reverse{[](uint8x8x3_t pixels) {
+    pixels.val[0] = vrev64_u8(pixels.val[0]);
+    pixels.val[1] = vrev64_u8(pixels.val[1]);
+    pixels.val[2] = vrev64_u8(pixels.val[2]);
+    return pixels;
+  }};
+  while (last - first >= 48) {
+    last -= 24;
+    auto *const lhs{reinterpret_cast<std::uint8_t *>(first)};
+    auto *const rhs{reinterpret_cast<std::uint8_t *>(last)};
+    auto const left{vld3_u8(lhs)};
+    auto const right{vld3_u8(rhs)};
+    vst3_u8(lhs, reverse(right));
+    vst3_u8(rhs, reverse(left));
+    first += 24;
+  }
+#elif defined(__wasm_simd128__)
+  // 4 pixels (12 bytes) per block, loaded as in the SSSE3 path
+  auto const store{[](std::byte *destination, v128_t pixels) {
+    wasm_v128_store64_lane(destination, pixels, 0);
+    wasm_v128_store32_lane(destination + 8, pixels, 2);
+  }};
+  while (last - first >= 24) {
+    last -= 12;
+    auto const left{wasm_v128_load(first)};
+    auto const right{wasm_v128_load(last - 4)};
+    store(first, wasm_i8x16_shuffle(right, right, 13, 14, 15, 10, 11, 12, 7,
+                                    8, 9, 4, 5, 6, 0, 0, 0, 0));
+    store(last, wasm_i8x16_shuffle(left, left, 9, 10, 11, 6, 7, 8, 3, 4, 5, 0,
+                                   1, 2, 0, 0, 0, 0));
+    first += 12;
+  }
+#else
+  static_cast<void>(first);
+  static_cast<void>(last);
+#endif
+}
+
+// Reverses the order of the pixels of a row, in place
+template <std::size_t BytesPerPixel> void reverseRow(std::span<std::byte> row) {
+  auto *first{row.data()};
+  auto *last{row.data() + row.size()};
+  if constexpr (BytesPerPixel == 4) {
+    reverseBlocksRGBA(first, last);
+  } else {
+    reverseBlocksRGB(first, last);
+  }
+  while (last - first >= gsl::narrow<std::ptrdiff_t>(2 * BytesPerPixel)) {
+    last -= BytesPerPixel;
+    swapPixel<BytesPerPixel>(first, last);
+    first += BytesPerPixel;
+  }
+}
+
+// Swaps the contents of two rows of the same size
+void swapRows(std::span<std::byte> lhs, std::span<std::byte> rhs) {
+  auto *first{lhs.data()};
+  auto *second{rhs.data()};
+  auto *const end{lhs.data() + lhs.size()};
+#if defined(__AVX2__)
+  for (; end - first >= 32; first += 32, second += 32) {
+    auto *const lhsBlock{reinterpret_cast<__m256i *>(first)};
+    auto *const rhsBlock{reinterpret_cast<__m256i *>(second)};
+    auto const left{_mm256_loadu_si256(lhsBlock)};
+    _mm256_storeu_si256(lhsBlock, _mm256_loadu_si256(rhsBlock));
+    _mm256_storeu_si256(rhsBlock, left);
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  for (; end - first >= 16; first += 16, second += 16) {
+    auto *const lhsBlock{reinterpret_cast<__m128i *>(first)};
+    auto *const rhsBlock{reinterpret_cast<__m128i *>(second)};
+    auto const left{_mm_loadu_si128(lhsBlock)};
+    _mm_storeu_si128(lhsBlock, _mm_loadu_si128(rhsBlock));
+    _mm_storeu_si128(rhsBlock, left);
+  }
+#elif defined(__ARM_NEON)
+  for (; end - first >= 16; first += 16, second += 16) {
+    auto *const lhsBlock{reinterpret_cast<std::uint8_t *>(first)};
+    auto *const rhsBlock{reinterpret_cast<std::uint8_t *>(second)};
+    auto const left{vld1q_u8(lhsBlock)};
+    vst1q_u8(lhsBlock, vld1q_u8(rhsBlock));
+    vst1q_u8(rhsBlock, left);
+  }
+#elif defined(__wasm_simd128__)
+  for (; end - first >= 16; first += 16, second += 16) {
+    auto const left{wasm_v128_load(first)};
+    wasm_v128_store(first, wasm_v128_load(second));
+    wasm_v128_store(second, left);
+  }
+#endif
+  std::swap_ranges(first, end, second);
+}
+
+// Reverses the rows in [first, last) of a surface
+void flipRowsHorizontally(SDL_Surface &surface, std::size_t first,
+                          std::size_t last) {
+  auto const widthInBytes{
+      gsl::narrow<std::size_t>(surface.w * surface.format->BytesPerPixel)};
+  auto const pitch{gsl::narrow<std::size_t>(surface.pitch)};
+  std::span const pixels{static_cast<std::byte *>(surface.pixels),
+                         pitch * gsl::narrow<std::size_t>(surface.h)};
+
+  for (auto const rowIndex : iter::range(first, last)) {
+    auto const row{pixels.subspan(rowIndex * pitch, widthInBytes)};
+    if (surface.format->BytesPerPixel == 4) {
+      reverseRow<4>(row);
+    } else {
+      reverseRow<3>(row);
+    }
+  }
+}
+
+// Swaps the rows in [first, last) of a surface with the rows at the same
+// distance from the bottom
+void swapRowsVertically(SDL_Surface &surface, std::size_t first,
+                        std::size_t last) {
+  auto const widthInBytes{
+      gsl::narrow<std::size_t>(surface.w * surface.format->BytesPerPixel)};
+  auto const pitch{gsl::narrow<std::size_t>(surface.pitch)};
+  auto const height{gsl::narrow<std::size_t>(surface.h)};
+  std::span const pixels{static_cast<std::byte *>(surface.pixels),
+                         pitch * height};
+
+  for (auto const rowIndex : iter::range(first, last)) {
+    swapRows(pixels.subspan(rowIndex * pitch, widthInBytes),
+             pixels.subspan((height - rowIndex - 1) * pitch, widthInBytes));
+  }
+}
+
+// Returns the minimum number of rows processed by a task, so that small
+// images are not split across threads
+[[nodiscard]] std::size_t getMinBatchRows(SDL_Surface const &surface) {
+  auto constexpr minBatchBytes{std::size_t{1} << 20};
+  return std::max<std::size_t>(
+      minBatchBytes / std::max(gsl::narrow<std::size_t>(surface.pitch),
+                               std::size_t{1}),
+      1);
+}
+} // namespace
+
+/**
+ * @brief Loads an image from a filesystem path.
+ *
+ * This function can be called from any thread.
+ *
+ * @param path Path to the image file (PNG or JPEG).
+ *
+ * @throw abcg::RuntimeError if the image could not be loaded.
+ *
+ * @return Surface of the image, in the pixel format of the file.
+ */
+abcg::SurfacePtr abcg::loadImage(std::string_view path) {
+  // IMG_Load requires a null-terminated string
+  SurfacePtr surface{IMG_Load(std::string{path}.c_str())};
+  if (!surface) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to load texture file {}", path));
+  }
+  return surface;
+}
+
+/**
+ * @brief Converts an image to another pixel format.
+ *
+ * This function can be called from any thread.
+ *
+ * @param surface Surface of the image.
+ * @param pixelFormat SDL pixel format of the converted image, such as
+ * `SDL_PIXELFORMAT_RGBA32`.
+ *
+ * @throw abcg::RuntimeError if the image could not be converted.
+ *
+ * @return Surface of the converted image.
+ */
+abcg::SurfacePtr abcg::convertImage(SDL_Surface const &surface,
+                                    Uint32 pixelFormat) {
+  // SDL_ConvertSurfaceFormat does not modify the source surface
+  SurfacePtr formattedSurface{SDL_ConvertSurfaceFormat(
+      const_cast<SDL_Surface *>(&surface), pixelFormat, 0)};
+  if (!formattedSurface) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to convert image: {}", SDL_GetError()));
+  }
+  return formattedSurface;
+}
 
 /**
  * @brief Flips an image horizontally.
@@ -24,35 +329,28 @@
  * @param surface SDL surface of a RGB or RGBA image.
  */
 void abcg::flipHorizontally(SDL_Surface &surface) {
-  auto const bytesPerPixel{gsl::narrow<int>(surface.format->BytesPerPixel)};
-  auto const widthInBytes{gsl::narrow<std::size_t>(surface.w * bytesPerPixel)};
-  auto const height{gsl::narrow<std::size_t>(surface.h)};
-  std::span const pixels{static_cast<std::byte *>(surface.pixels),
-                         widthInBytes * height};
-
-  // Temporary row of pixels for the swap
-  std::vector<std::byte> pixelRow(gsl::narrow<std::size_t>(widthInBytes), {});
-
   SDL_LockSurface(&surface);
+  flipRowsHorizontally(surface, 0, gsl::narrow<std::size_t>(surface.h));
+  SDL_UnlockSurface(&surface);
+}
 
-  // For each row
-  for (auto const rowIndex : iter::range(height)) {
-    auto const rowStart{widthInBytes * rowIndex};
-    auto const rowEnd{rowStart + widthInBytes};
-    // For each pixel (RGB/RGA) of current row
-    auto srcBegin{pixels.begin() + gsl::narrow<long>(rowEnd)};
-    auto dstBegin{pixelRow.begin()};
-    for ([[maybe_unused]] auto const pixelIndex : iter::range(surface.w)) {
-      srcBegin -= bytesPerPixel;
-      std::copy(srcBegin, srcBegin + bytesPerPixel, dstBegin);
-      dstBegin += bytesPerPixel;
-    }
-    // std::ranges::copy(pixelRow, pixels.subspan(rowStart).begin());
-    std::copy(pixelRow.begin(),
-              pixelRow.begin() + gsl::narrow<long>(widthInBytes),
-              pixels.subspan(rowStart).begin());
-  }
-
+/**
+ * @brief Flips an image horizontally using worker threads.
+ *
+ * Rows are reversed in parallel by the worker threads of `threadPool` and the
+ * calling thread. Small images are flipped by the calling thread only.
+ *
+ * @param surface SDL surface of a RGB or RGBA image.
+ * @param threadPool Pool of worker threads.
+ */
+void abcg::flipHorizontally(SDL_Surface &surface, ThreadPool &threadPool) {
+  SDL_LockSurface(&surface);
+  threadPool.parallelFor(
+      gsl::narrow<std::size_t>(surface.h),
+      [&surface](std::size_t first, std::size_t last) {
+        flipRowsHorizontally(surface, first, last);
+      },
+      getMinBatchRows(surface));
   SDL_UnlockSurface(&surface);
 }
 
@@ -64,39 +362,28 @@ void abcg::flipHorizontally(SDL_Surface &surface) {
  * @param surface SDL surface of a RGB or RGBA image.
  */
 void abcg::flipVertically(SDL_Surface &surface) {
-  auto const bytesPerPixel{gsl::narrow<int>(surface.format->BytesPerPixel)};
-  auto const widthInBytes{gsl::narrow<std::size_t>(surface.w * bytesPerPixel)};
-  auto const height{gsl::narrow<std::size_t>(surface.h)};
-  std::span const pixels{static_cast<std::byte *>(surface.pixels),
-                         gsl::narrow<std::size_t>(widthInBytes * height)};
-
-  // Temporary row of pixels for the swap
-  std::vector<std::byte> pixelRow(widthInBytes, std::byte{});
-
   SDL_LockSurface(&surface);
+  swapRowsVertically(surface, 0, gsl::narrow<std::size_t>(surface.h / 2));
+  SDL_UnlockSurface(&surface);
+}
 
-  // If height is odd, won't swap the middle row
-  for (auto const halfHeight{height / 2};
-       auto const rowIndex : iter::range(halfHeight)) {
-    auto const rowStartFromTop{widthInBytes * rowIndex};
-    auto const rowStartFromBottom{widthInBytes * (height - rowIndex - 1)};
-
-    auto const &topSpan{pixels.subspan(rowStartFromTop)};
-    auto const &bottomSpan{pixels.subspan(rowStartFromBottom)};
-
-    // std::ranges::copy(topSpan.subspan(0, widthInBytes), pixelRow.begin());
-    // std::ranges::copy(bottomSpan.subspan(0, widthInBytes), topSpan.begin());
-    // std::ranges::copy(pixelRow, bottomSpan.begin());
-    std::copy(topSpan.begin(),
-              topSpan.begin() + gsl::narrow<long>(widthInBytes),
-              pixelRow.begin());
-    std::copy(bottomSpan.begin(),
-              bottomSpan.begin() + gsl::narrow<long>(widthInBytes),
-              topSpan.begin());
-    std::copy(pixelRow.begin(),
-              pixelRow.begin() + gsl::narrow<long>(widthInBytes),
-              bottomSpan.begin());
-  }
-
+/**
+ * @brief Flips an image vertically using worker threads.
+ *
+ * Pairs of rows are swapped in parallel by the worker threads of
+ * `threadPool` and the calling thread. Small images are flipped by the
+ * calling thread only.
+ *
+ * @param surface SDL surface of a RGB or RGBA image.
+ * @param threadPool Pool of worker threads.
+ */
+void abcg::flipVertically(SDL_Surface &surface, ThreadPool &threadPool) {
+  SDL_LockSurface(&surface);
+  threadPool.parallelFor(
+      gsl::narrow<std::size_t>(surface.h / 2),
+      [&surface](std::size_t first, std::size_t last) {
+        swapRowsVertically(surface, first, last);
+      },
+      getMinBatchRows(surface));
   SDL_UnlockSurface(&surface);
-}
\ No newline at end of file
+}
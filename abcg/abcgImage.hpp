@@ -13,9 +13,32 @@
 
 #include <SDL_image.h>
 
+#include <memory>
+#include <string_view>
+
 namespace abcg {
+struct SurfaceDeleter;
+class ThreadPool;
+
+/** @brief Owning pointer to an SDL surface. */
+using SurfacePtr = std::unique_ptr<SDL_Surface, SurfaceDeleter>;
+
+[[nodiscard]] SurfacePtr loadImage(std::string_view path);
+[[nodiscard]] SurfacePtr convertImage(SDL_Surface const &surface,
+                                      Uint32 pixelFormat);
 void flipHorizontally(SDL_Surface &surface);
+void flipHorizontally(SDL_Surface &surface, ThreadPool &threadPool);
 void flipVertically(SDL_Surface &surface);
+void flipVertically(SDL_Surface &surface, ThreadPool &threadPool);
 } // namespace abcg
 
+/**
+ * @brief Deleter of abcg::SurfacePtr.
+ */
+struct abcg::SurfaceDeleter {
+  void operator()(SDL_Surface *surface) const noexcept {
+    SDL_FreeSurface(surface);
+  }
+};
+
 #endif
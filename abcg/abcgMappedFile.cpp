@@ -0,0 +1,167 @@
+/**
+ * @file abcgMappedFile.cpp
+ * @brief Definition of abcg::MappedFile members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgMappedFile.hpp"
+
+#include <fmt/core.h>
+#include <gsl/gsl>
+
+#include <string>
+#include <utility>
+
+#if defined(WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "abcgException.hpp"
+
+/**
+ * @brief Maps a file into memory.
+ *
+ * @param path Path to the file.
+ *
+ * @throw abcg::RuntimeError if the file could not be opened or mapped.
+ */
+abcg::MappedFile::MappedFile(std::string_view path) {
+  // The system functions require a null-terminated string
+  std::string const pathString{path};
+  auto const fail{[&path] {
+    throw abcg::RuntimeError(fmt::format("Failed to map file {}", path));
+  }};
+
+#if defined(WIN32)
+  auto *const file{CreateFileA(pathString.c_str(), GENERIC_READ,
+                               FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL, nullptr)};
+  if (file == INVALID_HANDLE_VALUE) {
+    fail();
+  }
+  auto const closeFile{gsl::finally([file] { CloseHandle(file); })};
+
+  LARGE_INTEGER fileSize{};
+  if (GetFileSizeEx(file, &fileSize) == 0) {
+    fail();
+  }
+  m_size = gsl::narrow<std::size_t>(fileSize.QuadPart);
+
+  // Empty files cannot be mapped
+  if (m_size > 0) {
+    auto *const mapping{
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+    if (mapping == nullptr) {
+      fail();
+    }
+    // The view keeps a reference to the mapping
+    auto const closeMapping{gsl::finally([mapping] { CloseHandle(mapping); })};
+    m_data = static_cast<std::byte const *>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr) {
+      fail();
+    }
+  }
+#else
+  auto const file{open(pathString.c_str(), O_RDONLY)};
+  if (file < 0) {
+    fail();
+  }
+  auto const closeFile{gsl::finally([file] { ::close(file); })};
+
+  struct stat status {};
+  if (fstat(file, &status) != 0) {
+    fail();
+  }
+  m_size = gsl::narrow<std::size_t>(status.st_size);
+
+  // Empty files cannot be mapped
+  if (m_size > 0) {
+    auto *const data{mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0)};
+    if (data == MAP_FAILED) {
+      fail();
+    }
+    m_data = static_cast<std::byte const *>(data);
+  }
+#endif
+
+  m_open = true;
+}
+
+/**
+ * @brief Move constructor.
+ *
+ * @param other Mapped file to be moved. It is left closed.
+ */
+abcg::MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_data{std::exchange(other.m_data, nullptr)},
+      m_size{std::exchange(other.m_size, 0)},
+      m_open{std::exchange(other.m_open, false)} {}
+
+/**
+ * @brief Move assignment operator.
+ *
+ * @param other Mapped file to be moved. It is left closed.
+ *
+ * @return Reference to this object.
+ */
+abcg::MappedFile &abcg::MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_open = std::exchange(other.m_open, false);
+  }
+  return *this;
+}
+
+/**
+ * @brief Destructor. Unmaps the file.
+ */
+abcg::MappedFile::~MappedFile() { close(); }
+
+/**
+ * @brief Returns the contents of the file.
+ *
+ * @return View of the bytes of the file. The view is empty if the file is
+ * empty or not open.
+ */
+std::span<std::byte const> abcg::MappedFile::getData() const noexcept {
+  return {m_data, m_size};
+}
+
+/**
+ * @brief Returns whether a file is mapped.
+ *
+ * @return `true` if the object refers to a file; `false` if it is
+ * default-constructed or was moved from.
+ */
+bool abcg::MappedFile::isOpen() const noexcept { return m_open; }
+
+void abcg::MappedFile::close() noexcept {
+  if (m_data != nullptr) {
+#if defined(WIN32)
+    UnmapViewOfFile(m_data);
+#else
+    munmap(const_cast<std::byte *>(m_data), m_size);
+#endif
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_open = false;
+}
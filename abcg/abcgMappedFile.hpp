@@ -0,0 +1,52 @@
+/**
+ * @file abcgMappedFile.hpp
+ * @brief Header file of abcg::MappedFile.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MAPPED_FILE_HPP_
+#define ABCG_MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+namespace abcg {
+class MappedFile;
+} // namespace abcg
+
+/**
+ * @brief Read-only view of a file mapped into memory.
+ *
+ * The contents of the file are paged in on demand by the operating system
+ * instead of being read up front. The mapping is released when the object is
+ * destroyed.
+ *
+ * @remark Objects of this type cannot be copied or copy-constructed.
+ */
+class abcg::MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(std::string_view path);
+  MappedFile(MappedFile const &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile const &) = delete;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  ~MappedFile();
+
+  [[nodiscard]] std::span<std::byte const> getData() const noexcept;
+  [[nodiscard]] bool isOpen() const noexcept;
+
+private:
+  void close() noexcept;
+
+  std::byte const *m_data{};
+  std::size_t m_size{};
+  bool m_open{};
+};
+
+#endif
@@ -0,0 +1,326 @@
+/**
+ * @file abcgMeshCache.cpp
+ * @brief Definition of abcg::MeshCache members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgMeshCache.hpp"
+
+#include <cppitertools/itertools.hpp>
+#include <fmt/core.h>
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "abcgException.hpp"
+#include "abcgThreadPool.hpp"
+#include "abcgUtil.hpp"
+
+namespace {
+// Header of a mesh cache file. The file is laid out as the header, followed by
+// `vertexCount` vertices of `vertexSize` bytes, followed by `indexCount`
+// 32-bit indices, followed by `lodCount` levels of detail. Each array starts
+// at a multiple of arrayAlignment.
+struct MeshCacheHeader {
+  std::array<char, 8> magic{'A', 'B', 'C', 'G', 'M', 'E', 'S', 'H'};
+  std::uint32_t version{abcg::MeshCache::version};
+  std::uint32_t vertexSize{};
+  std::uint64_t sourceSize{};
+  std::uint64_t sourceHash{};
+  std::uint64_t vertexCount{};
+  std::uint64_t indexCount{};
+  std::uint64_t lodCount{};
+  std::array<float, 3> boundsCenter{};
+  float boundsRadius{};
+};
+
+// Level of detail as stored in the file. Unlike abcg::MeshLod, its size does
+// not depend on the platform.
+struct MeshCacheLod {
+  std::uint64_t firstIndex{};
+  std::uint64_t indexCount{};
+  float error{};
+  std::uint32_t padding{};
+};
+
+constexpr std::size_t arrayAlignment{16};
+
+[[nodiscard]] std::size_t alignOffset(std::size_t offset) {
+  return (offset + arrayAlignment - 1) / arrayAlignment * arrayAlignment;
+}
+
+// Returns a hash of the contents of a model file. The file is hashed in chunks
+// of fixed size in parallel, and the hashes of the chunks are hashed in order,
+// so the result does not depend on the number of threads.
+[[nodiscard]] std::uint64_t hashSource(std::span<std::byte const> data) {
+  constexpr std::size_t chunkSize{std::size_t{1} << 20};
+  auto const chunkCount{(data.size() + chunkSize - 1) / chunkSize};
+  std::vector<std::uint64_t> chunkHashes(chunkCount);
+
+  abcg::getThreadPool().parallelFor(
+      chunkCount, [&](std::size_t first, std::size_t last) {
+        for (auto const index : iter::range(first, last)) {
+          auto const offset{index * chunkSize};
+          auto const chunk{
+              data.subspan(offset, std::min(chunkSize, data.size() - offset))};
+          chunkHashes.at(index) = abcg::hashFNV1a(
+              {reinterpret_cast<char const *>(chunk.data()), chunk.size()});
+        }
+      });
+
+  auto const bytes{std::as_bytes(std::span{chunkHashes})};
+  return abcg::hashFNV1a(
+      {reinterpret_cast<char const *>(bytes.data()), bytes.size()});
+}
+} // namespace
+
+/**
+ * @brief Loads the cache of a model file.
+ *
+ * The cache is used only if it has the current version and vertex size, and
+ * if the size and hash of the model file match the ones stored in the cache.
+ *
+ * @param sourcePath Path to the model file.
+ * @param vertexSize Size of a vertex, in bytes.
+ *
+ * @return `true` if the cache was loaded; `false` if there is no valid cache
+ * for the model file.
+ */
+bool abcg::MeshCache::load(std::string_view sourcePath,
+                           std::size_t vertexSize) {
+  m_file = {};
+  m_vertices = {};
+  m_indices = {};
+  m_lods.clear();
+  m_bounds = {};
+
+  auto const cachePath{getCachePath(sourcePath)};
+  std::error_code errorCode;
+  if (vertexSize == 0 || !std::filesystem::exists(cachePath, errorCode)) {
+    return false;
+  }
+
+  try {
+    MappedFile file{cachePath};
+    auto const data{file.getData()};
+
+    MeshCacheHeader header{};
+    MeshCacheHeader const expected{};
+    if (data.size() < sizeof(header)) {
+      return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != expected.magic || header.version != expected.version ||
+        header.vertexSize != vertexSize) {
+      return false;
+    }
+
+    // Check that the arrays fit in the file
+    if (header.vertexCount > data.size() / vertexSize ||
+        header.indexCount > data.size() / sizeof(std::uint32_t) ||
+        header.lodCount > data.size() / sizeof(MeshCacheLod)) {
+      return false;
+    }
+    auto const vertexOffset{alignOffset(sizeof(header))};
+    auto const vertexBytes{gsl::narrow<std::size_t>(header.vertexCount) *
+                           vertexSize};
+    auto const indexOffset{alignOffset(vertexOffset + vertexBytes)};
+    auto const indexCount{gsl::narrow<std::size_t>(header.indexCount)};
+    auto const lodOffset{
+        alignOffset(indexOffset + indexCount * sizeof(std::uint32_t))};
+    auto const lodCount{gsl::narrow<std::size_t>(header.lodCount)};
+    if (lodOffset + lodCount * sizeof(MeshCacheLod) > data.size()) {
+      return false;
+    }
+
+    // Check that the levels of detail lie within the index array
+    std::vector<MeshLod> lods(lodCount);
+    for (auto const index : iter::range(lodCount)) {
+      MeshCacheLod lod{};
+      std::memcpy(&lod,
+                  data.subspan(lodOffset + index * sizeof(MeshCacheLod)).data(),
+                  sizeof(lod));
+      if (lod.firstIndex > indexCount ||
+          lod.indexCount > indexCount - lod.firstIndex) {
+        return false;
+      }
+      lods.at(index) = {.firstIndex = gsl::narrow<std::size_t>(lod.firstIndex),
+                        .indexCount = gsl::narrow<std::size_t>(lod.indexCount),
+                        .error = lod.error};
+    }
+
+    // The cache is stale if the model file changed
+    MappedFile const source{sourcePath};
+    auto const sourceData{source.getData()};
+    if (sourceData.size() != header.sourceSize ||
+        hashSource(sourceData) != header.sourceHash) {
+      return false;
+    }
+
+    m_vertices = data.subspan(vertexOffset, vertexBytes);
+    m_indices = {reinterpret_cast<std::uint32_t const *>(
+                     data.subspan(indexOffset).data()),
+                 indexCount};
+    m_lods = std::move(lods);
+    m_bounds = {.center = {header.boundsCenter[0], header.boundsCenter[1],
+                           header.boundsCenter[2]},
+                .radius = header.boundsRadius};
+    // The mapping is moved, so the views remain valid
+    m_file = std::move(file);
+  } catch (abcg::Exception const &) {
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Writes the cache of a model file.
+ *
+ * The cache is written to a temporary file that is then renamed, so that a
+ * partially written cache is never loaded. The arrays held by this object are
+ * not changed.
+ *
+ * @param sourcePath Path to the model file.
+ * @param vertices Bytes of the vertex array.
+ * @param vertexSize Size of a vertex, in bytes.
+ * @param indices Index array. If `lods` is not empty, the concatenated index
+ * array of the levels of detail.
+ * @param lods Levels of detail within `indices`, if any.
+ * @param bounds Bounding sphere of the mesh.
+ *
+ * @throw abcg::RuntimeError if the model file could not be read, or if the
+ * cache could not be written.
+ */
+void abcg::MeshCache::save(std::string_view sourcePath,
+                           std::span<std::byte const> vertices,
+                           std::size_t vertexSize,
+                           std::span<std::uint32_t const> indices,
+                           std::span<MeshLod const> lods,
+                           BoundingSphere const &bounds) {
+  if (vertexSize == 0 || vertices.size() % vertexSize != 0) {
+    throw abcg::RuntimeError("Invalid vertex size");
+  }
+
+  std::vector<MeshCacheLod> cachedLods;
+  cachedLods.reserve(lods.size());
+  for (auto const &lod : lods) {
+    if (lod.firstIndex > indices.size() ||
+        lod.indexCount > indices.size() - lod.firstIndex) {
+      throw abcg::RuntimeError("Invalid level of detail");
+    }
+    cachedLods.push_back({.firstIndex = lod.firstIndex,
+                          .indexCount = lod.indexCount,
+                          .error = lod.error});
+  }
+
+  MappedFile const source{sourcePath};
+  auto const sourceData{source.getData()};
+  MeshCacheHeader const header{
+      .vertexSize = gsl::narrow<std::uint32_t>(vertexSize),
+      .sourceSize = sourceData.size(),
+      .sourceHash = hashSource(sourceData),
+      .vertexCount = vertices.size() / vertexSize,
+      .indexCount = indices.size(),
+      .lodCount = lods.size(),
+      .boundsCenter = {bounds.center.x, bounds.center.y, bounds.center.z},
+      .boundsRadius = bounds.radius};
+
+  // Write to a temporary file first so that readers never see a partial cache
+  std::filesystem::path const path{getCachePath(sourcePath)};
+  auto tempPath{path};
+  tempPath += ".tmp";
+  std::error_code errorCode;
+  {
+    std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+    auto const write{[&stream](std::span<std::byte const> bytes) {
+      stream.write(reinterpret_cast<char const *>(bytes.data()),
+                   gsl::narrow<std::streamsize>(bytes.size()));
+    }};
+    auto const pad{[&stream, &write] {
+      std::array<std::byte, arrayAlignment> const padding{};
+      auto const offset{
+          gsl::narrow<std::size_t>(std::streamoff{stream.tellp()})};
+      write(std::span{padding}.first(alignOffset(offset) - offset));
+    }};
+
+    write(std::as_bytes(std::span{&header, 1}));
+    pad();
+    write(vertices);
+    pad();
+    write(std::as_bytes(indices));
+    pad();
+    write(std::as_bytes(std::span{cachedLods}));
+    if (!stream) {
+      stream.close();
+      std::filesystem::remove(tempPath, errorCode);
+      throw abcg::RuntimeError(
+          fmt::format("Failed to write mesh cache {}", path.string()));
+    }
+  }
+  std::filesystem::rename(tempPath, path, errorCode);
+  if (errorCode) {
+    std::filesystem::remove(tempPath, errorCode);
+    throw abcg::RuntimeError(
+        fmt::format("Failed to write mesh cache {}", path.string()));
+  }
+}
+
+/**
+ * @brief Returns the bytes of the cached vertex array.
+ *
+ * @return View of the vertex array. The view is empty if no cache is loaded.
+ */
+std::span<std::byte const> abcg::MeshCache::getVertexData() const noexcept {
+  return m_vertices;
+}
+
+/**
+ * @brief Returns the cached index array.
+ *
+ * @return View of the indices. The view is empty if no cache is loaded.
+ */
+std::span<std::uint32_t const> abcg::MeshCache::getIndices() const noexcept {
+  return m_indices;
+}
+
+/**
+ * @brief Returns the cached levels of detail.
+ *
+ * @return View of the levels of detail within the index array. The view is
+ * empty if no cache is loaded, or if the cache has no levels of detail.
+ */
+std::span<abcg::MeshLod const> abcg::MeshCache::getLods() const noexcept {
+  return m_lods;
+}
+
+/**
+ * @brief Returns the cached bounding sphere.
+ *
+ * @return Bounding sphere of the mesh. The sphere has radius 0 if the cache
+ * has no levels of detail.
+ */
+abcg::BoundingSphere const &abcg::MeshCache::getBounds() const noexcept {
+  return m_bounds;
+}
+
+/**
+ * @brief Returns the path of the cache of a model file.
+ *
+ * @param sourcePath Path to the model file.
+ *
+ * @return Path of the model file with the extension `.abcgmesh` appended.
+ */
+std::string abcg::MeshCache::getCachePath(std::string_view sourcePath) {
+  return std::string{sourcePath} + ".abcgmesh";
+}
@@ -0,0 +1,156 @@
+/**
+ * @file abcgMeshCache.hpp
+ * @brief Header file of abcg::MeshCache.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MESH_CACHE_HPP_
+#define ABCG_MESH_CACHE_HPP_
+
+#include "abcgMappedFile.hpp"
+#include "abcgMeshSimplifier.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace abcg {
+class MeshCache;
+} // namespace abcg
+
+/**
+ * @brief Binary cache of the vertex and index arrays of a mesh loaded from a
+ * model file.
+ *
+ * The cache of a model file is stored next to it, with the extension
+ * `.abcgmesh` appended to its name. The cache contains a versioned header, the
+ * vertex array and the index array, in the layout used by vertex and index
+ * buffers. It also stores the size and a hash of the model file, so that the
+ * cache is ignored once the model file changes.
+ *
+ * The cache can also store the levels of detail and the bounding sphere of a
+ * abcg::MeshLodChain. In this case, the index array is the concatenated index
+ * array of the chain, so that the levels need not be generated again.
+ *
+ * A cache hit maps the cache file into memory. The arrays returned by
+ * abcg::MeshCache::getVertices and abcg::MeshCache::getIndices point to the
+ * mapped file and can be passed directly to functions such as
+ * `glBufferData`, without parsing.
+ *
+ * Typical usage:
+ *
+ * @code
+ * abcg::MeshCache cache;
+ * if (!cache.load<Vertex>(path)) {
+ *   // Parse the model file into vertices and indices
+ *   auto const chain{abcg::generateMeshLods<Vertex>(vertices, indices, {})};
+ *   cache.save<Vertex>(path, vertices, chain);
+ * }
+ * @endcode
+ *
+ * @remark Objects of this type cannot be copied or copy-constructed.
+ */
+class abcg::MeshCache {
+public:
+  /**
+   * @brief Version of the cache format. Caches of other versions are
+   * ignored.
+   *
+   * Incremented whenever the layout of the cache, or the processing that
+   * produces the cached arrays, changes:
+   *
+   * - 1: Vertices and indices in the order of the model file;
+   * - 2: Vertices and indices reordered by abcg::optimizeMesh;
+   * - 3: Levels of detail and bounding sphere of abcg::MeshLodChain.
+   */
+  static constexpr std::uint32_t version{3};
+
+  [[nodiscard]] bool load(std::string_view sourcePath,
+                          std::size_t vertexSize);
+  void save(std::string_view sourcePath, std::span<std::byte const> vertices,
+            std::size_t vertexSize, std::span<std::uint32_t const> indices,
+            std::span<MeshLod const> lods = {},
+            BoundingSphere const &bounds = {});
+
+  /**
+   * @brief Loads the cache of a model file for vertices of type `Vertex`.
+   *
+   * @param sourcePath Path to the model file.
+   *
+   * @return `true` on a cache hit; `false` otherwise.
+   */
+  template <typename Vertex>
+  [[nodiscard]] bool load(std::string_view sourcePath) {
+    static_assert(std::is_trivially_copyable_v<Vertex>);
+    return load(sourcePath, sizeof(Vertex));
+  }
+
+  /**
+   * @brief Writes the cache of a model file with vertices of type `Vertex`.
+   *
+   * @param sourcePath Path to the model file.
+   * @param vertices Vertex array.
+   * @param indices Index array.
+   *
+   * @throw abcg::RuntimeError if the cache could not be written.
+   */
+  template <typename Vertex>
+  void save(std::string_view sourcePath, std::span<Vertex const> vertices,
+            std::span<std::uint32_t const> indices) {
+    static_assert(std::is_trivially_copyable_v<Vertex>);
+    save(sourcePath, std::as_bytes(vertices), sizeof(Vertex), indices);
+  }
+
+  /**
+   * @brief Writes the cache of a model file with vertices of type `Vertex`
+   * and its levels of detail.
+   *
+   * @param sourcePath Path to the model file.
+   * @param vertices Vertex array.
+   * @param chain Levels of detail indexing `vertices`.
+   *
+   * @throw abcg::RuntimeError if the cache could not be written.
+   */
+  template <typename Vertex>
+  void save(std::string_view sourcePath, std::span<Vertex const> vertices,
+            MeshLodChain const &chain) {
+    static_assert(std::is_trivially_copyable_v<Vertex>);
+    save(sourcePath, std::as_bytes(vertices), sizeof(Vertex), chain.indices,
+         chain.lods, chain.bounds);
+  }
+
+  /**
+   * @brief Returns the cached vertex array.
+   *
+   * @return View of the vertices. The view is empty if no cache is loaded.
+   */
+  template <typename Vertex>
+  [[nodiscard]] std::span<Vertex const> getVertices() const noexcept {
+    static_assert(std::is_trivially_copyable_v<Vertex>);
+    return {reinterpret_cast<Vertex const *>(m_vertices.data()),
+            m_vertices.size() / sizeof(Vertex)};
+  }
+
+  [[nodiscard]] std::span<std::byte const> getVertexData() const noexcept;
+  [[nodiscard]] std::span<std::uint32_t const> getIndices() const noexcept;
+  [[nodiscard]] std::span<MeshLod const> getLods() const noexcept;
+  [[nodiscard]] BoundingSphere const &getBounds() const noexcept;
+
+  [[nodiscard]] static std::string getCachePath(std::string_view sourcePath);
+
+private:
+  MappedFile m_file;
+  std::span<std::byte const> m_vertices;
+  std::span<std::uint32_t const> m_indices;
+  std::vector<MeshLod> m_lods;
+  BoundingSphere m_bounds;
+};
+
+#endif
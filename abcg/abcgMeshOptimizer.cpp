@@ -0,0 +1,524 @@
+/**
+ * @file abcgMeshOptimizer.cpp
+ * @brief Definition of mesh optimization functions.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgMeshOptimizer.hpp"
+
+#include <cppitertools/itertools.hpp>
+#include <glm/geometric.hpp>
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "abcgException.hpp"
+
+namespace {
+// Size of the LRU cache modeled by the vertex cache optimization. Orderings
+// tuned for this size perform well on FIFO caches of 16 to 32 entries.
+constexpr std::size_t optimizerCacheSize{32};
+// Size of the FIFO cache used to find cluster boundaries for the overdraw
+// optimization
+constexpr std::size_t overdrawCacheSize{16};
+
+// Tom Forsyth's scoring function for linear-speed vertex cache optimization
+class ForsythScore {
+public:
+  ForsythScore() {
+    for (auto const position : iter::range(optimizerCacheSize)) {
+      if (position < 3) {
+        // The vertices of the last triangle get a fixed score, so that the
+        // next triangle does not always reuse the same edge
+        m_cacheScores.at(position) = lastTriangleScore;
+      } else {
+        auto const scale{1.0f - static_cast<float>(position - 3) /
+                                    static_cast<float>(optimizerCacheSize - 3)};
+        m_cacheScores.at(position) = std::pow(scale, cacheDecayPower);
+      }
+    }
+    for (auto const valence :
+         iter::range(std::size_t{1}, m_valenceScores.size())) {
+      m_valenceScores.at(valence) =
+          valenceBoostScale *
+          std::pow(static_cast<float>(valence), -valenceBoostPower);
+    }
+  }
+
+  // Returns the score of a vertex given its position in the cache (-1 if not
+  // cached) and the number of triangles not yet emitted that use it
+  [[nodiscard]] float operator()(int cachePosition,
+                                 std::size_t valence) const {
+    if (valence == 0) {
+      return -1.0f;
+    }
+    auto const cacheScore{
+        cachePosition < 0
+            ? 0.0f
+            : m_cacheScores.at(gsl::narrow<std::size_t>(cachePosition))};
+    auto const valenceScore{
+        valence < m_valenceScores.size()
+            ? m_valenceScores.at(valence)
+            : valenceBoostScale * std::pow(static_cast<float>(valence),
+                                           -valenceBoostPower)};
+    return cacheScore + valenceScore;
+  }
+
+private:
+  static constexpr float cacheDecayPower{1.5f};
+  static constexpr float lastTriangleScore{0.75f};
+  static constexpr float valenceBoostScale{2.0f};
+  static constexpr float valenceBoostPower{0.5f};
+
+  std::array<float, optimizerCacheSize> m_cacheScores{};
+  std::array<float, 32> m_valenceScores{};
+};
+
+// Simulates a FIFO post-transform vertex cache. A vertex is in the cache if
+// fewer than cacheSize misses happened since it was last transformed.
+class FifoCache {
+public:
+  FifoCache(std::size_t vertexCount, std::size_t cacheSize)
+      : m_timestamps(vertexCount, 0), m_cacheSize{cacheSize},
+        m_timestamp{cacheSize + 1} {}
+
+  // Returns the number of vertices of the triangle that were transformed
+  std::size_t access(std::span<std::uint32_t const, 3> triangle) {
+    std::size_t misses{};
+    for (auto const index : triangle) {
+      auto &timestamp{m_timestamps.at(index)};
+      if (m_timestamp - timestamp > m_cacheSize) {
+        timestamp = m_timestamp++;
+        ++misses;
+      }
+    }
+    return misses;
+  }
+
+  // Empties the cache
+  void flush() { m_timestamp += m_cacheSize + 1; }
+
+private:
+  std::vector<std::size_t> m_timestamps;
+  std::size_t m_cacheSize{};
+  std::size_t m_timestamp{};
+};
+
+[[nodiscard]] std::span<std::uint32_t const, 3>
+getTriangle(std::span<std::uint32_t const> indices, std::size_t triangle) {
+  return indices.subspan(triangle * 3).first<3>();
+}
+
+void validateIndices(std::span<std::uint32_t const> indices,
+                     std::size_t vertexCount) {
+  if (indices.size() % 3 != 0) {
+    throw abcg::RuntimeError("Index count must be a multiple of 3");
+  }
+  if (std::ranges::any_of(indices, [vertexCount](auto index) {
+        return index >= vertexCount;
+      })) {
+    throw abcg::RuntimeError("Index out of range");
+  }
+}
+
+[[nodiscard]] glm::vec3 getPosition(std::span<std::byte const> vertexData,
+                                    std::size_t vertexStride,
+                                    std::size_t positionOffset,
+                                    std::uint32_t index) {
+  glm::vec3 position{};
+  std::memcpy(&position,
+              vertexData.subspan(index * vertexStride + positionOffset).data(),
+              sizeof(position));
+  return position;
+}
+} // namespace
+
+/**
+ * @brief Computes vertex cache statistics of an index buffer.
+ *
+ * Simulates a FIFO post-transform vertex cache, which is what most GPUs
+ * implement, and counts the vertices that need to be transformed.
+ *
+ * @param indices Index array of a triangle list.
+ * @param vertexCount Number of vertices in the vertex array.
+ * @param cacheSize Number of entries of the simulated cache.
+ *
+ * @return Number of transformed vertices, average cache miss ratio (ACMR) and
+ * average transform to vertex ratio (ATVR).
+ *
+ * @throw abcg::RuntimeError if the index count is not a multiple of 3 or if an
+ * index is out of range.
+ */
+abcg::VertexCacheStatistics
+abcg::analyzeVertexCache(std::span<std::uint32_t const> indices,
+                         std::size_t vertexCount, std::size_t cacheSize) {
+  validateIndices(indices, vertexCount);
+
+  VertexCacheStatistics statistics{};
+  auto const triangleCount{indices.size() / 3};
+  if (triangleCount == 0) {
+    return statistics;
+  }
+
+  FifoCache cache{vertexCount, cacheSize};
+  for (auto const triangle : iter::range(triangleCount)) {
+    statistics.vertexTransforms += cache.access(getTriangle(indices, triangle));
+  }
+
+  std::vector<bool> referenced(vertexCount, false);
+  std::size_t referencedCount{};
+  for (auto const index : indices) {
+    if (!referenced.at(index)) {
+      referenced.at(index) = true;
+      ++referencedCount;
+    }
+  }
+
+  auto const transforms{static_cast<float>(statistics.vertexTransforms)};
+  statistics.acmr = transforms / static_cast<float>(triangleCount);
+  statistics.atvr = transforms / static_cast<float>(referencedCount);
+  return statistics;
+}
+
+/**
+ * @brief Reorders triangles to improve the post-transform vertex cache reuse.
+ *
+ * Implements Tom Forsyth's linear-speed vertex cache optimization: triangles
+ * are emitted greedily by a score that favors vertices recently used and
+ * vertices with few remaining triangles. The vertex order within each
+ * triangle is kept, so the winding does not change.
+ *
+ * @param indices Index array of a triangle list, reordered in place.
+ * @param vertexCount Number of vertices in the vertex array.
+ *
+ * @throw abcg::RuntimeError if the index count is not a multiple of 3 or if an
+ * index is out of range.
+ */
+void abcg::optimizeVertexCache(std::span<std::uint32_t> indices,
+                               std::size_t vertexCount) {
+  validateIndices(indices, vertexCount);
+
+  auto const triangleCount{indices.size() / 3};
+  if (triangleCount == 0) {
+    return;
+  }
+
+  // Build the vertex-triangle adjacency
+  std::vector<std::size_t> valences(vertexCount, 0);
+  for (auto const index : indices) {
+    ++valences.at(index);
+  }
+  std::vector<std::size_t> adjacencyOffsets(vertexCount + 1, 0);
+  std::partial_sum(valences.begin(), valences.end(),
+                   std::next(adjacencyOffsets.begin()));
+  std::vector<std::size_t> adjacency(indices.size());
+  {
+    auto fill{adjacencyOffsets};
+    for (auto const [position, index] : iter::enumerate(indices)) {
+      adjacency.at(fill.at(index)++) = position / 3;
+    }
+  }
+
+  ForsythScore const score;
+  std::vector<int> cachePositions(vertexCount, -1);
+  std::vector<float> vertexScores(vertexCount);
+  for (auto const vertex : iter::range(vertexCount)) {
+    vertexScores.at(vertex) = score(-1, valences.at(vertex));
+  }
+  std::vector<float> triangleScores(triangleCount);
+  std::vector<bool> emitted(triangleCount, false);
+  for (auto const triangle : iter::range(triangleCount)) {
+    auto &triangleScore{triangleScores.at(triangle)};
+    for (auto const index : getTriangle(indices, triangle)) {
+      triangleScore += vertexScores.at(index);
+    }
+  }
+
+  std::vector<std::uint32_t> const input(indices.begin(), indices.end());
+  std::vector<std::uint32_t> cache;
+  std::vector<std::uint32_t> nextCache;
+  cache.reserve(optimizerCacheSize + 3);
+  nextCache.reserve(optimizerCacheSize + 3);
+
+  std::size_t inputCursor{};
+  auto bestTriangle{std::numeric_limits<std::size_t>::max()};
+  for (auto const output : iter::range(triangleCount)) {
+    // When no cached vertex has pending triangles, continue with the next
+    // triangle of the input order
+    if (bestTriangle == std::numeric_limits<std::size_t>::max()) {
+      while (emitted.at(inputCursor)) {
+        ++inputCursor;
+      }
+      bestTriangle = inputCursor;
+    }
+
+    auto const triangle{getTriangle(input, bestTriangle)};
+    std::ranges::copy(triangle, indices.subspan(output * 3).begin());
+    emitted.at(bestTriangle) = true;
+
+    // Remove the triangle from the adjacency of its vertices
+    for (auto const index : triangle) {
+      auto const pending{std::span{adjacency}.subspan(
+          adjacencyOffsets.at(index), valences.at(index))};
+      std::iter_swap(std::ranges::find(pending, bestTriangle),
+                     std::prev(pending.end()));
+      --valences.at(index);
+    }
+
+    // Move the vertices of the triangle to the front of the LRU cache
+    nextCache.assign(triangle.begin(), triangle.end());
+    for (auto const index : cache) {
+      if (std::ranges::find(triangle, index) == triangle.end()) {
+        nextCache.push_back(index);
+      }
+    }
+    std::swap(cache, nextCache);
+
+    // Update the scores of the vertices that entered, moved within or left the
+    // cache, and of their remaining triangles
+    for (auto const [position, index] : iter::enumerate(cache)) {
+      cachePositions.at(index) = position < optimizerCacheSize
+                                     ? gsl::narrow<int>(position)
+                                     : -1;
+    }
+    for (auto const index : cache) {
+      auto const newScore{score(cachePositions.at(index), valences.at(index))};
+      auto const delta{newScore - vertexScores.at(index)};
+      vertexScores.at(index) = newScore;
+
+      auto const offset{adjacencyOffsets.at(index)};
+      for (auto const adjacent :
+           std::span{adjacency}.subspan(offset, valences.at(index))) {
+        triangleScores.at(adjacent) += delta;
+      }
+    }
+
+    // The next triangle is the best one that uses a cached vertex
+    bestTriangle = std::numeric_limits<std::size_t>::max();
+    auto bestScore{-1.0f};
+    for (auto const index : cache) {
+      auto const offset{adjacencyOffsets.at(index)};
+      for (auto const adjacent :
+           std::span{adjacency}.subspan(offset, valences.at(index))) {
+        if (triangleScores.at(adjacent) > bestScore) {
+          bestScore = triangleScores.at(adjacent);
+          bestTriangle = adjacent;
+        }
+      }
+    }
+
+    if (cache.size() > optimizerCacheSize) {
+      cache.resize(optimizerCacheSize);
+    }
+  }
+}
+
+/**
+ * @brief Reorders triangles to reduce overdraw while keeping most of the
+ * vertex cache efficiency.
+ *
+ * The index buffer, which should have been optimized with
+ * abcg::optimizeVertexCache, is split into clusters at points where the
+ * vertex cache efficiency would drop by less than `threshold`. The clusters
+ * are then sorted so that those facing away from the center of the mesh are
+ * drawn first. Clusters on the silhouette of convex parts tend to occlude the
+ * inner ones, so early depth testing rejects more fragments.
+ *
+ * @param indices Index array of a triangle list, reordered in place.
+ * @param vertexData Bytes of the vertex array.
+ * @param vertexStride Size of a vertex, in bytes.
+ * @param positionOffset Offset of the `glm::vec3` position within a vertex,
+ * in bytes.
+ * @param threshold Maximum ratio by which the ACMR of a cluster may exceed
+ * the ACMR of the original order. Higher values create more clusters.
+ *
+ * @throw abcg::RuntimeError if the index count is not a multiple of 3, if an
+ * index is out of range, or if the vertex layout is invalid.
+ */
+void abcg::optimizeOverdraw(std::span<std::uint32_t> indices,
+                            std::span<std::byte const> vertexData,
+                            std::size_t vertexStride,
+                            std::size_t positionOffset, float threshold) {
+  if (vertexStride == 0 || vertexData.size() % vertexStride != 0 ||
+      positionOffset + sizeof(glm::vec3) > vertexStride) {
+    throw abcg::RuntimeError("Invalid vertex layout");
+  }
+  auto const vertexCount{vertexData.size() / vertexStride};
+  validateIndices(indices, vertexCount);
+
+  auto const triangleCount{indices.size() / 3};
+  if (triangleCount == 0) {
+    return;
+  }
+
+  // Hard boundaries: triangles for which the whole cache was missed. Splitting
+  // there does not change the vertex cache efficiency.
+  std::vector<std::size_t> hardBoundaries;
+  FifoCache cache{vertexCount, overdrawCacheSize};
+  for (auto const triangle : iter::range(triangleCount)) {
+    if (cache.access(getTriangle(indices, triangle)) == 3 || triangle == 0) {
+      hardBoundaries.push_back(triangle);
+    }
+  }
+  hardBoundaries.push_back(triangleCount);
+
+  // Soft boundaries: split each hard cluster where the ACMR of the triangles
+  // since the last split is within the threshold of the cluster's ACMR
+  std::vector<std::size_t> boundaries;
+  for (auto const cluster : iter::range(hardBoundaries.size() - 1)) {
+    auto const first{hardBoundaries.at(cluster)};
+    auto const last{hardBoundaries.at(cluster + 1)};
+    cache.flush();
+    std::size_t clusterMisses{};
+    for (auto const triangle : iter::range(first, last)) {
+      clusterMisses += cache.access(getTriangle(indices, triangle));
+    }
+    auto const clusterThreshold{
+        threshold * static_cast<float>(clusterMisses) /
+        static_cast<float>(last - first)};
+
+    cache.flush();
+    auto start{first};
+    std::size_t misses{};
+    for (auto const triangle : iter::range(first, last)) {
+      misses += cache.access(getTriangle(indices, triangle));
+      auto const acmr{static_cast<float>(misses) /
+                      static_cast<float>(triangle + 1 - start)};
+      if (triangle + 1 == last || acmr <= clusterThreshold) {
+        boundaries.push_back(start);
+        start = triangle + 1;
+        misses = 0;
+        cache.flush();
+      }
+    }
+  }
+  boundaries.push_back(triangleCount);
+
+  // Area-weighted centroid and normal of each cluster and of the whole mesh
+  struct Cluster {
+    std::size_t first{};
+    std::size_t last{};
+    glm::vec3 centroid{};
+    glm::vec3 normal{};
+    float sortKey{};
+  };
+  std::vector<Cluster> clusters(boundaries.size() - 1);
+  glm::vec3 meshCentroid{};
+  auto meshArea{0.0f};
+  for (auto const [clusterIndex, cluster] : iter::enumerate(clusters)) {
+    cluster.first = boundaries.at(clusterIndex);
+    cluster.last = boundaries.at(clusterIndex + 1);
+    auto area{0.0f};
+    for (auto const triangle : iter::range(cluster.first, cluster.last)) {
+      std::array<glm::vec3, 3> positions{};
+      for (auto const [position, index] :
+           iter::zip(positions, getTriangle(indices, triangle))) {
+        position = getPosition(vertexData, vertexStride, positionOffset, index);
+      }
+      auto const normal{glm::cross(positions[1] - positions[0],
+                                   positions[2] - positions[0])};
+      auto const triangleArea{glm::length(normal)};
+      cluster.centroid +=
+          (positions[0] + positions[1] + positions[2]) * (triangleArea / 3.0f);
+      cluster.normal += normal;
+      area += triangleArea;
+    }
+    meshCentroid += cluster.centroid;
+    meshArea += area;
+    if (area > 0.0f) {
+      cluster.centroid /= area;
+    }
+  }
+  if (meshArea > 0.0f) {
+    meshCentroid /= meshArea;
+  }
+
+  for (auto &cluster : clusters) {
+    auto const length{glm::length(cluster.normal)};
+    if (length > 0.0f) {
+      cluster.sortKey =
+          glm::dot(cluster.centroid - meshCentroid, cluster.normal / length);
+    }
+  }
+
+  // Draw clusters facing outwards first
+  std::ranges::stable_sort(clusters, std::ranges::greater{}, &Cluster::sortKey);
+
+  std::vector<std::uint32_t> const input(indices.begin(), indices.end());
+  auto output{indices.begin()};
+  for (auto const &cluster : clusters) {
+    auto const first{gsl::narrow<std::ptrdiff_t>(cluster.first * 3)};
+    auto const last{gsl::narrow<std::ptrdiff_t>(cluster.last * 3)};
+    output = std::copy(std::next(input.begin(), first),
+                       std::next(input.begin(), last), output);
+  }
+}
+
+/**
+ * @brief Reorders vertices in order of first use by the index buffer, to
+ * improve the locality of vertex fetches.
+ *
+ * Should be called after the triangle order is final. The indices are
+ * remapped to the new vertex order.
+ *
+ * @param vertexData Bytes of the vertex array, reordered in place.
+ * @param vertexStride Size of a vertex, in bytes.
+ * @param indices Index array, remapped in place.
+ *
+ * @return Number of vertices referenced by the index buffer. Unreferenced
+ * vertices are moved after them, in their original order.
+ *
+ * @throw abcg::RuntimeError if an index is out of range or if the vertex
+ * stride is invalid.
+ */
+std::size_t abcg::optimizeVertexFetch(std::span<std::byte> vertexData,
+                                      std::size_t vertexStride,
+                                      std::span<std::uint32_t> indices) {
+  if (vertexStride == 0 || vertexData.size() % vertexStride != 0) {
+    throw abcg::RuntimeError("Invalid vertex layout");
+  }
+  auto const vertexCount{vertexData.size() / vertexStride};
+  if (std::ranges::any_of(indices, [vertexCount](auto index) {
+        return index >= vertexCount;
+      })) {
+    throw abcg::RuntimeError("Index out of range");
+  }
+
+  auto constexpr unmapped{std::numeric_limits<std::uint32_t>::max()};
+  std::vector<std::uint32_t> remap(vertexCount, unmapped);
+  std::uint32_t nextVertex{};
+  for (auto &index : indices) {
+    auto &newIndex{remap.at(index)};
+    if (newIndex == unmapped) {
+      newIndex = nextVertex++;
+    }
+    index = newIndex;
+  }
+  std::size_t const referencedCount{nextVertex};
+  for (auto &newIndex : remap) {
+    if (newIndex == unmapped) {
+      newIndex = nextVertex++;
+    }
+  }
+
+  std::vector<std::byte> const input(vertexData.begin(), vertexData.end());
+  for (auto const [oldIndex, newIndex] : iter::enumerate(remap)) {
+    std::memcpy(vertexData.subspan(newIndex * vertexStride).data(),
+                std::span{input}.subspan(oldIndex * vertexStride).data(),
+                vertexStride);
+  }
+
+  return referencedCount;
+}
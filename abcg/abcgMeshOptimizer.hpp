@@ -0,0 +1,110 @@
+/**
+ * @file abcgMeshOptimizer.hpp
+ * @brief Declaration of mesh optimization functions.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MESH_OPTIMIZER_HPP_
+#define ABCG_MESH_OPTIMIZER_HPP_
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+namespace abcg {
+struct VertexCacheStatistics;
+struct MeshOptimizationStatistics;
+
+[[nodiscard]] VertexCacheStatistics
+analyzeVertexCache(std::span<std::uint32_t const> indices,
+                   std::size_t vertexCount, std::size_t cacheSize = 16);
+void optimizeVertexCache(std::span<std::uint32_t> indices,
+                         std::size_t vertexCount);
+void optimizeOverdraw(std::span<std::uint32_t> indices,
+                      std::span<std::byte const> vertexData,
+                      std::size_t vertexStride, std::size_t positionOffset,
+                      float threshold = 1.05f);
+std::size_t optimizeVertexFetch(std::span<std::byte> vertexData,
+                                std::size_t vertexStride,
+                                std::span<std::uint32_t> indices);
+
+template <typename Vertex>
+MeshOptimizationStatistics optimizeMesh(std::span<Vertex> vertices,
+                                        std::span<std::uint32_t> indices,
+                                        float overdrawThreshold = 1.05f);
+} // namespace abcg
+
+/**
+ * @brief Post-transform vertex cache statistics of an index buffer, as
+ * computed by abcg::analyzeVertexCache.
+ */
+struct abcg::VertexCacheStatistics {
+  /** @brief Number of vertex shader invocations (cache misses). */
+  std::size_t vertexTransforms{};
+  /** @brief Average cache miss ratio: transforms per triangle. Ranges from
+   * 0.5 (best) to 3.0 (worst). */
+  float acmr{};
+  /** @brief Average transform to vertex ratio: transforms per referenced
+   * vertex. Ranges from 1.0 (best) to 6.0 (worst). */
+  float atvr{};
+};
+
+/**
+ * @brief Vertex cache statistics of a mesh before and after
+ * abcg::optimizeMesh.
+ */
+struct abcg::MeshOptimizationStatistics {
+  /** @brief Statistics of the original index buffer. */
+  VertexCacheStatistics before;
+  /** @brief Statistics of the optimized index buffer. */
+  VertexCacheStatistics after;
+};
+
+/**
+ * @brief Optimizes the triangle and vertex order of an indexed triangle mesh.
+ *
+ * Runs abcg::optimizeVertexCache, abcg::optimizeOverdraw and
+ * abcg::optimizeVertexFetch, in this order. The mesh is changed in place and
+ * renders the same triangles with the same winding.
+ *
+ * @tparam Vertex Trivially copyable vertex type with a `glm::vec3 position`
+ * member.
+ *
+ * @param vertices Vertex array. Vertices not referenced by any index are moved
+ * to the end of the array.
+ * @param indices Index array of a triangle list.
+ * @param overdrawThreshold Maximum ratio by which the vertex cache efficiency
+ * may degrade to reduce overdraw. 1.0 disables the overdraw optimization.
+ *
+ * @return Vertex cache statistics before and after the optimization.
+ */
+template <typename Vertex>
+abcg::MeshOptimizationStatistics
+abcg::optimizeMesh(std::span<Vertex> vertices,
+                   std::span<std::uint32_t> indices, float overdrawThreshold) {
+  static_assert(std::is_trivially_copyable_v<Vertex>);
+  static_assert(std::is_same_v<decltype(Vertex::position), glm::vec3>);
+
+  MeshOptimizationStatistics statistics{
+      .before = analyzeVertexCache(indices, vertices.size()), .after = {}};
+
+  optimizeVertexCache(indices, vertices.size());
+  if (overdrawThreshold > 1.0f) {
+    optimizeOverdraw(indices, std::as_bytes(vertices), sizeof(Vertex),
+                     offsetof(Vertex, position), overdrawThreshold);
+  }
+  optimizeVertexFetch(std::as_writable_bytes(vertices), sizeof(Vertex),
+                      indices);
+
+  statistics.after = analyzeVertexCache(indices, vertices.size());
+  return statistics;
+}
+
+#endif
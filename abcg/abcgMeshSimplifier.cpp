@@ -0,0 +1,688 @@
+/**
+ * @file abcgMeshSimplifier.cpp
+ * @brief Definition of mesh simplification and level of detail functions.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgMeshSimplifier.hpp"
+
+#include <cppitertools/itertools.hpp>
+#include <glm/geometric.hpp>
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <numeric>
+
+#include "abcgException.hpp"
+#include "abcgMeshOptimizer.hpp"
+
+namespace {
+// Quadric of squared distances to a set of planes, weighted by area:
+// Q(p) = p^T A p + 2 b.p + c, with A symmetric
+struct Quadric {
+  std::array<double, 6> a{}; // a00, a01, a02, a11, a12, a22
+  std::array<double, 3> b{};
+  double c{};
+  double weight{};
+
+  Quadric &operator+=(Quadric const &other) {
+    for (auto const index : iter::range(a.size())) {
+      a.at(index) += other.a.at(index);
+    }
+    for (auto const index : iter::range(b.size())) {
+      b.at(index) += other.b.at(index);
+    }
+    c += other.c;
+    weight += other.weight;
+    return *this;
+  }
+
+  // Adds the quadric of the squared value of the linear function
+  // f(p) = n.p + d, weighted by `scale`
+  void addLinear(glm::dvec3 const &n, double d, double scale) {
+    a[0] += scale * n.x * n.x;
+    a[1] += scale * n.x * n.y;
+    a[2] += scale * n.x * n.z;
+    a[3] += scale * n.y * n.y;
+    a[4] += scale * n.y * n.z;
+    a[5] += scale * n.z * n.z;
+    b[0] += scale * n.x * d;
+    b[1] += scale * n.y * d;
+    b[2] += scale * n.z * d;
+    c += scale * d * d;
+  }
+
+  [[nodiscard]] double evaluate(glm::dvec3 const &p) const {
+    auto const x{a[0] * p.x * p.x + a[3] * p.y * p.y + a[5] * p.z * p.z +
+                 2.0 * (a[1] * p.x * p.y + a[2] * p.x * p.z +
+                        a[4] * p.y * p.z)};
+    return x + 2.0 * (b[0] * p.x + b[1] * p.y + b[2] * p.z) + c;
+  }
+};
+
+// Part of an attribute quadric that depends on the attribute value s at the
+// collapse target. The parts that do not depend on s are accumulated in the
+// geometric quadric. For a linear attribute function f(p) = g.p + d over a
+// triangle of area w, the error (f(p) - s)^2 expands to
+// w (g.p + d)^2 - 2 s w (g.p + d) + s^2 w.
+struct AttributeQuadric {
+  glm::dvec3 gradient{}; // Sum of w g
+  double offset{};       // Sum of w d
+  double weight{};       // Sum of w
+
+  AttributeQuadric &operator+=(AttributeQuadric const &other) {
+    gradient += other.gradient;
+    offset += other.offset;
+    weight += other.weight;
+    return *this;
+  }
+
+  [[nodiscard]] double evaluate(glm::dvec3 const &p, double value) const {
+    return -2.0 * value * (glm::dot(gradient, p) + offset) +
+           value * value * weight;
+  }
+};
+
+struct Collapse {
+  std::uint32_t source{};
+  std::uint32_t target{};
+  double cost{};
+};
+
+// Iterative edge collapse simplifier. Vertices are only collapsed onto other
+// existing vertices, so the simplified meshes index the original vertex
+// array. Quadrics are kept between calls to simplify, so it can be called
+// with decreasing targets to produce a chain of levels of detail.
+class Simplifier {
+public:
+  Simplifier(std::span<std::uint32_t const> indices,
+             std::span<std::byte const> vertexData, std::size_t vertexStride,
+             std::size_t positionOffset,
+             std::span<abcg::SimplifyAttribute const> attributes);
+
+  void simplify(std::size_t targetIndexCount, float maxError);
+
+  [[nodiscard]] std::vector<std::uint32_t> const &getIndices() const {
+    return m_indices;
+  }
+  [[nodiscard]] float getError() const {
+    return gsl::narrow_cast<float>(std::sqrt(m_squaredError));
+  }
+
+private:
+  std::vector<std::uint32_t> m_indices;
+  std::vector<glm::dvec3> m_positions;
+  // Attribute values, scaled by their weights, attributeCount per vertex
+  std::vector<double> m_attributes;
+  std::size_t m_attributeCount{};
+  std::vector<Quadric> m_quadrics;
+  std::vector<AttributeQuadric> m_attributeQuadrics;
+  std::vector<bool> m_locked;
+  double m_squaredError{};
+
+  // Vertex-triangle adjacency of the current indices
+  std::vector<std::size_t> m_adjacencyOffsets;
+  std::vector<std::size_t> m_adjacency;
+
+  void buildAdjacency();
+  void lockBorders();
+  [[nodiscard]] std::span<std::size_t const>
+  getTriangles(std::uint32_t vertex) const;
+  [[nodiscard]] double getCollapseCost(std::uint32_t source,
+                                       std::uint32_t target) const;
+  [[nodiscard]] bool flipsTriangles(std::uint32_t source,
+                                    std::uint32_t target) const;
+  [[nodiscard]] bool keepsManifold(std::uint32_t source,
+                                   std::uint32_t target) const;
+};
+
+Simplifier::Simplifier(std::span<std::uint32_t const> indices,
+                       std::span<std::byte const> vertexData,
+                       std::size_t vertexStride, std::size_t positionOffset,
+                       std::span<abcg::SimplifyAttribute const> attributes)
+    : m_indices(indices.begin(), indices.end()) {
+  if (vertexStride == 0 || vertexData.size() % vertexStride != 0 ||
+      positionOffset + sizeof(glm::vec3) > vertexStride) {
+    throw abcg::RuntimeError("Invalid vertex layout");
+  }
+  for (auto const &attribute : attributes) {
+    if (attribute.offset + attribute.componentCount * sizeof(float) >
+        vertexStride) {
+      throw abcg::RuntimeError("Invalid vertex layout");
+    }
+    m_attributeCount += attribute.componentCount;
+  }
+
+  auto const vertexCount{vertexData.size() / vertexStride};
+  if (indices.size() % 3 != 0) {
+    throw abcg::RuntimeError("Index count must be a multiple of 3");
+  }
+  if (std::ranges::any_of(indices, [vertexCount](auto index) {
+        return index >= vertexCount;
+      })) {
+    throw abcg::RuntimeError("Index out of range");
+  }
+
+  m_positions.resize(vertexCount);
+  m_attributes.resize(vertexCount * m_attributeCount);
+  for (auto const vertex : iter::range(vertexCount)) {
+    auto const data{vertexData.subspan(vertex * vertexStride, vertexStride)};
+    glm::vec3 position{};
+    std::memcpy(&position, data.subspan(positionOffset).data(),
+                sizeof(position));
+    m_positions.at(vertex) = position;
+
+    auto component{vertex * m_attributeCount};
+    for (auto const &attribute : attributes) {
+      for (auto const index : iter::range(attribute.componentCount)) {
+        float value{};
+        std::memcpy(
+            &value,
+            data.subspan(attribute.offset + index * sizeof(float)).data(),
+            sizeof(value));
+        m_attributes.at(component++) =
+            static_cast<double>(value) * static_cast<double>(attribute.weight);
+      }
+    }
+  }
+
+  // Accumulate the plane and attribute quadrics of each triangle
+  m_quadrics.resize(vertexCount);
+  m_attributeQuadrics.resize(vertexCount * m_attributeCount);
+  for (auto const triangle : iter::range(m_indices.size() / 3)) {
+    std::array<std::uint32_t, 3> vertices{};
+    std::ranges::copy(std::span{m_indices}.subspan(triangle * 3, 3),
+                      vertices.begin());
+    auto const &p0{m_positions.at(vertices[0])};
+    auto const edge1{m_positions.at(vertices[1]) - p0};
+    auto const edge2{m_positions.at(vertices[2]) - p0};
+    auto const cross{glm::cross(edge1, edge2)};
+    auto const length{glm::length(cross)};
+    if (length <= 0.0) {
+      continue;
+    }
+    auto const area{length * 0.5};
+    auto const normal{cross / length};
+
+    Quadric quadric{};
+    quadric.addLinear(normal, -glm::dot(normal, p0), area);
+    quadric.weight = area;
+
+    // Gradient of each attribute over the triangle plane, from
+    // g.edge1 = s1 - s0 and g.edge2 = s2 - s0 with g in the plane
+    auto const d11{glm::dot(edge1, edge1)};
+    auto const d12{glm::dot(edge1, edge2)};
+    auto const d22{glm::dot(edge2, edge2)};
+    auto const determinant{d11 * d22 - d12 * d12};
+    std::vector<AttributeQuadric> attributeQuadrics(m_attributeCount);
+    if (determinant > 0.0) {
+      for (auto const index : iter::range(m_attributeCount)) {
+        auto const value{[&](std::size_t vertex) {
+          return m_attributes.at(vertices.at(vertex) * m_attributeCount +
+                                 index);
+        }};
+        auto const delta1{value(1) - value(0)};
+        auto const delta2{value(2) - value(0)};
+        auto const u{(delta1 * d22 - delta2 * d12) / determinant};
+        auto const v{(delta2 * d11 - delta1 * d12) / determinant};
+        auto const gradient{edge1 * u + edge2 * v};
+        auto const offset{value(0) - glm::dot(gradient, p0)};
+
+        quadric.addLinear(gradient, offset, area);
+        attributeQuadrics.at(index) = {.gradient = gradient * area,
+                                       .offset = offset * area,
+                                       .weight = area};
+      }
+    }
+
+    for (auto const vertex : vertices) {
+      m_quadrics.at(vertex) += quadric;
+      for (auto const index : iter::range(m_attributeCount)) {
+        m_attributeQuadrics.at(vertex * m_attributeCount + index) +=
+            attributeQuadrics.at(index);
+      }
+    }
+  }
+
+  buildAdjacency();
+  lockBorders();
+}
+
+void Simplifier::buildAdjacency() {
+  m_adjacencyOffsets.assign(m_positions.size() + 1, 0);
+  for (auto const index : m_indices) {
+    ++m_adjacencyOffsets.at(index + 1);
+  }
+  std::partial_sum(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end(),
+                   m_adjacencyOffsets.begin());
+  m_adjacency.resize(m_indices.size());
+  auto fill{m_adjacencyOffsets};
+  for (auto const [position, index] : iter::enumerate(m_indices)) {
+    m_adjacency.at(fill.at(index)++) = position / 3;
+  }
+}
+
+// Locks the vertices of edges used by a single triangle. This keeps open
+// boundaries and attribute seams (where vertices are split) in place.
+void Simplifier::lockBorders() {
+  m_locked.assign(m_positions.size(), false);
+  for (auto const triangle : iter::range(m_indices.size() / 3)) {
+    auto const vertices{std::span{m_indices}.subspan(triangle * 3, 3)};
+    for (auto const corner : iter::range(std::size_t{3})) {
+      auto const first{vertices[corner]};
+      auto const second{vertices[(corner + 1) % 3]};
+      auto const sharing{std::ranges::count_if(
+          getTriangles(first), [this, second](std::size_t other) {
+            auto const otherVertices{
+                std::span{m_indices}.subspan(other * 3, 3)};
+            return std::ranges::find(otherVertices, second) !=
+                   otherVertices.end();
+          })};
+      if (sharing < 2) {
+        m_locked.at(first) = true;
+        m_locked.at(second) = true;
+      }
+    }
+  }
+}
+
+std::span<std::size_t const>
+Simplifier::getTriangles(std::uint32_t vertex) const {
+  auto const first{m_adjacencyOffsets.at(vertex)};
+  return std::span{m_adjacency}.subspan(first,
+                                        m_adjacencyOffsets.at(vertex + 1) -
+                                            first);
+}
+
+double Simplifier::getCollapseCost(std::uint32_t source,
+                                   std::uint32_t target) const {
+  auto quadric{m_quadrics.at(source)};
+  quadric += m_quadrics.at(target);
+  auto const &position{m_positions.at(target)};
+  auto cost{quadric.evaluate(position)};
+
+  for (auto const index : iter::range(m_attributeCount)) {
+    auto attributeQuadric{
+        m_attributeQuadrics.at(source * m_attributeCount + index)};
+    attributeQuadric +=
+        m_attributeQuadrics.at(target * m_attributeCount + index);
+    cost += attributeQuadric.evaluate(
+        position, m_attributes.at(target * m_attributeCount + index));
+  }
+
+  // Normalize by area so that the cost is a mean squared distance
+  return quadric.weight > 0.0 ? std::max(cost, 0.0) / quadric.weight : 0.0;
+}
+
+// Returns true if moving source onto target flips, degenerates or turns by
+// more than about 75 degrees any triangle that is not removed by the collapse.
+// The margin also rejects the slivers that tend to flip in later collapses.
+bool Simplifier::flipsTriangles(std::uint32_t source,
+                                std::uint32_t target) const {
+  for (auto const triangle : getTriangles(source)) {
+    auto const vertices{std::span{m_indices}.subspan(triangle * 3, 3)};
+    if (std::ranges::find(vertices, target) != vertices.end()) {
+      continue;
+    }
+    std::array<glm::dvec3, 3> before{};
+    std::array<glm::dvec3, 3> after{};
+    for (auto const [corner, vertex] : iter::enumerate(vertices)) {
+      before.at(corner) = m_positions.at(vertex);
+      after.at(corner) = m_positions.at(vertex == source ? target : vertex);
+    }
+    auto const normalBefore{
+        glm::cross(before[1] - before[0], before[2] - before[0])};
+    auto const normalAfter{
+        glm::cross(after[1] - after[0], after[2] - after[0])};
+    if (glm::dot(normalBefore, normalAfter) <=
+        0.25 * glm::length(normalBefore) * glm::length(normalAfter)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if the collapse satisfies the link condition: the only
+// vertices adjacent to both source and target are the ones opposite to their
+// shared edge. Otherwise the collapse would fold the surface onto itself.
+bool Simplifier::keepsManifold(std::uint32_t source,
+                               std::uint32_t target) const {
+  std::vector<std::uint32_t> sourceNeighbors;
+  std::vector<std::uint32_t> opposite;
+  for (auto const triangle : getTriangles(source)) {
+    auto const vertices{std::span{m_indices}.subspan(triangle * 3, 3)};
+    auto const sharesEdge{std::ranges::find(vertices, target) !=
+                          vertices.end()};
+    for (auto const vertex : vertices) {
+      if (vertex != source && vertex != target) {
+        (sharesEdge ? opposite : sourceNeighbors).push_back(vertex);
+      }
+    }
+  }
+  for (auto const triangle : getTriangles(target)) {
+    auto const vertices{std::span{m_indices}.subspan(triangle * 3, 3)};
+    for (auto const vertex : vertices) {
+      if (std::ranges::find(opposite, vertex) == opposite.end() &&
+          std::ranges::find(sourceNeighbors, vertex) !=
+              sourceNeighbors.end()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void Simplifier::simplify(std::size_t targetIndexCount, float maxError) {
+  auto const maxSquaredError{static_cast<double>(maxError) *
+                             static_cast<double>(maxError)};
+  auto const vertexCount{gsl::narrow<std::uint32_t>(m_positions.size())};
+  std::vector<Collapse> collapses;
+  std::vector<bool> touched(vertexCount);
+  std::vector<std::uint32_t> remap(vertexCount);
+
+  while (m_indices.size() > targetIndexCount) {
+    // Cheapest collapse of each unlocked vertex onto one of its neighbors
+    collapses.clear();
+    for (auto const source : iter::range(vertexCount)) {
+      if (m_locked.at(source)) {
+        continue;
+      }
+      Collapse best{.source = source, .target = source, .cost = 0.0};
+      for (auto const triangle : getTriangles(source)) {
+        for (auto const target :
+             std::span{m_indices}.subspan(triangle * 3, 3)) {
+          if (target == source) {
+            continue;
+          }
+          auto const cost{getCollapseCost(source, target)};
+          if (best.target == source || cost < best.cost) {
+            best.target = target;
+            best.cost = cost;
+          }
+        }
+      }
+      if (best.target != source && best.cost <= maxSquaredError) {
+        collapses.push_back(best);
+      }
+    }
+    std::ranges::sort(collapses, {}, &Collapse::cost);
+
+    // Apply independent collapses, cheapest first, until enough triangles are
+    // removed. Collapses touching the neighborhood of an earlier one in this
+    // pass are deferred to the next pass.
+    auto const trianglesToRemove{(m_indices.size() - targetIndexCount + 2) /
+                                 3};
+    std::size_t removedTriangles{};
+    std::fill(touched.begin(), touched.end(), false);
+    std::iota(remap.begin(), remap.end(), 0);
+    for (auto const &collapse : collapses) {
+      if (removedTriangles >= trianglesToRemove) {
+        break;
+      }
+      if (touched.at(collapse.source) || touched.at(collapse.target) ||
+          !keepsManifold(collapse.source, collapse.target) ||
+          flipsTriangles(collapse.source, collapse.target)) {
+        continue;
+      }
+      remap.at(collapse.source) = collapse.target;
+      for (auto const triangle : getTriangles(collapse.source)) {
+        auto const vertices{std::span{m_indices}.subspan(triangle * 3, 3)};
+        for (auto const vertex : vertices) {
+          touched.at(vertex) = true;
+        }
+        if (std::ranges::find(vertices, collapse.target) != vertices.end()) {
+          ++removedTriangles;
+        }
+      }
+      m_quadrics.at(collapse.target) += m_quadrics.at(collapse.source);
+      for (auto const index : iter::range(m_attributeCount)) {
+        m_attributeQuadrics.at(collapse.target * m_attributeCount + index) +=
+            m_attributeQuadrics.at(collapse.source * m_attributeCount + index);
+      }
+      m_squaredError = std::max(m_squaredError, collapse.cost);
+    }
+    if (removedTriangles == 0) {
+      break;
+    }
+
+    // Remap the indices and drop the triangles that became degenerate
+    std::size_t output{};
+    for (auto const triangle : iter::range(m_indices.size() / 3)) {
+      std::array<std::uint32_t, 3> vertices{};
+      for (auto const corner : iter::range(std::size_t{3})) {
+        vertices.at(corner) = remap.at(m_indices.at(triangle * 3 + corner));
+      }
+      if (vertices[0] != vertices[1] && vertices[1] != vertices[2] &&
+          vertices[2] != vertices[0]) {
+        std::ranges::copy(vertices,
+                          std::next(m_indices.begin(),
+                                    gsl::narrow<std::ptrdiff_t>(output)));
+        output += 3;
+      }
+    }
+    m_indices.resize(output);
+    buildAdjacency();
+  }
+}
+} // namespace
+
+/**
+ * @brief Simplifies a triangle mesh by edge collapses guided by quadric error
+ * metrics.
+ *
+ * Each vertex accumulates the quadrics of the planes of its triangles, plus
+ * the quadrics of the linear variation of the given attributes over them.
+ * Edges are collapsed onto one of their endpoints, cheapest first, so the
+ * result indexes the original vertex array. Vertices on open boundaries and
+ * attribute seams are kept in place, and collapses that would flip a triangle
+ * are rejected.
+ *
+ * @param indices Index array of a triangle list.
+ * @param vertexData Bytes of the vertex array.
+ * @param vertexStride Size of a vertex, in bytes.
+ * @param positionOffset Offset of the `glm::vec3` position within a vertex,
+ * in bytes.
+ * @param attributes Vertex attributes to preserve, in addition to positions.
+ * @param targetIndexCount Number of indices to simplify to. The result may
+ * have more indices if the mesh cannot be simplified further.
+ *
+ * @return Indices of the simplified mesh and its error.
+ *
+ * @throw abcg::RuntimeError if the index count is not a multiple of 3, if an
+ * index is out of range, or if the vertex layout is invalid.
+ */
+abcg::SimplifiedMesh
+abcg::simplifyMesh(std::span<std::uint32_t const> indices,
+                   std::span<std::byte const> vertexData,
+                   std::size_t vertexStride, std::size_t positionOffset,
+                   std::span<SimplifyAttribute const> attributes,
+                   std::size_t targetIndexCount) {
+  Simplifier simplifier{indices, vertexData, vertexStride, positionOffset,
+                        attributes};
+  simplifier.simplify(targetIndexCount, std::numeric_limits<float>::max());
+  return {.indices = simplifier.getIndices(), .error = simplifier.getError()};
+}
+
+/**
+ * @brief Generates a chain of levels of detail of a triangle mesh.
+ *
+ * The first level is the original mesh. Each following level is simplified
+ * with abcg::simplifyMesh to `settings.reduction` times the triangle count of
+ * the previous one, continuing the same sequence of collapses so that the
+ * errors accumulate. The indices of each level are optimized with
+ * abcg::optimizeVertexCache. Generation stops early when the mesh cannot be
+ * simplified further or the error exceeds `settings.maxError`.
+ *
+ * @param indices Index array of a triangle list.
+ * @param vertexData Bytes of the vertex array.
+ * @param vertexStride Size of a vertex, in bytes.
+ * @param positionOffset Offset of the `glm::vec3` position within a vertex,
+ * in bytes.
+ * @param attributes Vertex attributes to preserve, in addition to positions.
+ * @param settings Number of levels, reduction ratio and maximum error.
+ *
+ * @return Levels of detail indexing the vertex array.
+ *
+ * @throw abcg::RuntimeError if the index count is not a multiple of 3, if an
+ * index is out of range, or if the vertex layout is invalid.
+ */
+abcg::MeshLodChain
+abcg::generateMeshLods(std::span<std::uint32_t const> indices,
+                       std::span<std::byte const> vertexData,
+                       std::size_t vertexStride, std::size_t positionOffset,
+                       std::span<SimplifyAttribute const> attributes,
+                       MeshLodSettings const &settings) {
+  Simplifier simplifier{indices, vertexData, vertexStride, positionOffset,
+                        attributes};
+
+  MeshLodChain chain{
+      .indices = {indices.begin(), indices.end()},
+      .lods = {{.firstIndex = 0, .indexCount = indices.size(), .error = 0.0f}},
+      .bounds =
+          computeBoundingSphere(vertexData, vertexStride, positionOffset)};
+
+  while (chain.lods.size() < settings.maxLodCount) {
+    auto const previousCount{chain.lods.back().indexCount};
+    auto const target{
+        static_cast<std::size_t>(static_cast<float>(previousCount / 3) *
+                                 settings.reduction) *
+        3};
+    simplifier.simplify(target, settings.maxError);
+
+    // Stop when the simplification no longer makes progress
+    auto const &lodIndices{simplifier.getIndices()};
+    if (lodIndices.empty() ||
+        static_cast<float>(lodIndices.size()) >
+            static_cast<float>(previousCount) *
+                std::midpoint(settings.reduction, 1.0f)) {
+      break;
+    }
+
+    MeshLod const lod{.firstIndex = chain.indices.size(),
+                      .indexCount = lodIndices.size(),
+                      .error = simplifier.getError()};
+    chain.indices.insert(chain.indices.end(), lodIndices.begin(),
+                         lodIndices.end());
+    optimizeVertexCache(std::span{chain.indices}.subspan(lod.firstIndex),
+                        vertexData.size() / vertexStride);
+    chain.lods.push_back(lod);
+  }
+
+  return chain;
+}
+
+/**
+ * @brief Computes a sphere that bounds the vertices of a mesh.
+ *
+ * Uses Ritter's algorithm, which gives a sphere up to about 5% larger than
+ * the minimal one.
+ *
+ * @param vertexData Bytes of the vertex array.
+ * @param vertexStride Size of a vertex, in bytes.
+ * @param positionOffset Offset of the `glm::vec3` position within a vertex,
+ * in bytes.
+ *
+ * @return Bounding sphere in object space.
+ */
+abcg::BoundingSphere
+abcg::computeBoundingSphere(std::span<std::byte const> vertexData,
+                            std::size_t vertexStride,
+                            std::size_t positionOffset) {
+  if (vertexStride == 0 || vertexData.size() < vertexStride) {
+    return {};
+  }
+  auto const vertexCount{vertexData.size() / vertexStride};
+  auto const position{[&](std::size_t vertex) {
+    glm::vec3 result{};
+    std::memcpy(
+        &result,
+        vertexData.subspan(vertex * vertexStride + positionOffset).data(),
+        sizeof(result));
+    return result;
+  }};
+  auto const farthestFrom{[&](glm::vec3 const &point) {
+    auto farthest{position(0)};
+    for (auto const vertex : iter::range(vertexCount)) {
+      auto const candidate{position(vertex)};
+      if (glm::distance(candidate, point) > glm::distance(farthest, point)) {
+        farthest = candidate;
+      }
+    }
+    return farthest;
+  }};
+
+  auto const first{farthestFrom(position(0))};
+  auto const second{farthestFrom(first)};
+  BoundingSphere sphere{.center = (first + second) * 0.5f,
+                        .radius = glm::distance(first, second) * 0.5f};
+  for (auto const vertex : iter::range(vertexCount)) {
+    auto const point{position(vertex)};
+    auto const distance{glm::distance(point, sphere.center)};
+    if (distance > sphere.radius) {
+      // Grow the sphere to enclose the point
+      auto const radius{(sphere.radius + distance) * 0.5f};
+      sphere.center += (point - sphere.center) * ((radius - sphere.radius) /
+                                                  distance);
+      sphere.radius = radius;
+    }
+  }
+  return sphere;
+}
+
+/**
+ * @brief Selects the coarsest level of detail whose error is not noticeable
+ * on the screen.
+ *
+ * The error of each level is projected to the screen at the point of the
+ * bounding sphere closest to the camera.
+ *
+ * @param lods Levels of detail, in order of decreasing detail.
+ * @param bounds Bounding sphere of the mesh.
+ * @param modelViewMatrix Model-view matrix of the mesh.
+ * @param projMatrix Projection matrix (perspective or orthographic).
+ * @param viewportHeight Height of the viewport, in pixels.
+ * @param maxPixelError Maximum projected error, in pixels.
+ *
+ * @return Index of the selected level. Returns 0 if `lods` is empty.
+ */
+std::size_t abcg::selectMeshLod(std::span<MeshLod const> lods,
+                                BoundingSphere const &bounds,
+                                glm::mat4 const &modelViewMatrix,
+                                glm::mat4 const &projMatrix,
+                                float viewportHeight, float maxPixelError) {
+  // Largest scale factor of the model-view transform
+  auto const scale{std::max({glm::length(glm::vec3{modelViewMatrix[0]}),
+                             glm::length(glm::vec3{modelViewMatrix[1]}),
+                             glm::length(glm::vec3{modelViewMatrix[2]})})};
+
+  // Pixels per unit of object space at the closest point of the sphere
+  auto pixelsPerUnit{scale * projMatrix[1][1] * viewportHeight * 0.5f};
+  auto const isPerspective{projMatrix[3][3] == 0.0f};
+  if (isPerspective) {
+    auto const center{modelViewMatrix * glm::vec4{bounds.center, 1.0f}};
+    auto const distance{-center.z - bounds.radius * scale};
+    if (distance <= 0.0f) {
+      return 0;
+    }
+    pixelsPerUnit /= distance;
+  }
+
+  std::size_t selected{};
+  for (auto const [index, lod] : iter::enumerate(lods)) {
+    if (lod.error * pixelsPerUnit > maxPixelError) {
+      break;
+    }
+    selected = index;
+  }
+  return selected;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file abcgMeshSimplifier.hpp
+ * @brief Declaration of mesh simplification and level of detail functions.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MESH_SIMPLIFIER_HPP_
+#define ABCG_MESH_SIMPLIFIER_HPP_
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace abcg {
+struct SimplifyAttribute;
+struct SimplifiedMesh;
+struct BoundingSphere;
+struct MeshLod;
+struct MeshLodChain;
+struct MeshLodSettings;
+
+[[nodiscard]] SimplifiedMesh
+simplifyMesh(std::span<std::uint32_t const> indices,
+             std::span<std::byte const> vertexData, std::size_t vertexStride,
+             std::size_t positionOffset,
+             std::span<SimplifyAttribute const> attributes,
+             std::size_t targetIndexCount);
+[[nodiscard]] MeshLodChain
+generateMeshLods(std::span<std::uint32_t const> indices,
+                 std::span<std::byte const> vertexData,
+                 std::size_t vertexStride, std::size_t positionOffset,
+                 std::span<SimplifyAttribute const> attributes,
+                 MeshLodSettings const &settings);
+[[nodiscard]] BoundingSphere
+computeBoundingSphere(std::span<std::byte const> vertexData,
+                      std::size_t vertexStride, std::size_t positionOffset);
+[[nodiscard]] std::size_t selectMeshLod(std::span<MeshLod const> lods,
+                                        BoundingSphere const &bounds,
+                                        glm::mat4 const &modelViewMatrix,
+                                        glm::mat4 const &projMatrix,
+                                        float viewportHeight,
+                                        float maxPixelError = 1.0f);
+
+template <typename Vertex>
+[[nodiscard]] MeshLodChain
+generateMeshLods(std::span<Vertex const> vertices,
+                 std::span<std::uint32_t const> indices,
+                 MeshLodSettings const &settings,
+                 std::span<SimplifyAttribute const> attributes = {});
+} // namespace abcg
+
+/**
+ * @brief Vertex attribute considered by the simplification error.
+ *
+ * The attribute is an array of `float` components within each vertex, such
+ * as a normal or texture coordinates. Collapses that change the attribute
+ * across the surface are penalized in proportion to the square of the
+ * difference, scaled by `weight`.
+ */
+struct abcg::SimplifyAttribute {
+  /** @brief Offset of the first component within a vertex, in bytes. */
+  std::size_t offset{};
+  /** @brief Number of `float` components. */
+  std::size_t componentCount{};
+  /** @brief Weight of the attribute relative to the geometric error. */
+  float weight{1.0f};
+};
+
+/**
+ * @brief Result of abcg::simplifyMesh.
+ */
+struct abcg::SimplifiedMesh {
+  /** @brief Indices of the simplified mesh into the original vertex array. */
+  std::vector<std::uint32_t> indices;
+  /** @brief Approximate deviation from the original surface, in the units of
+   * the vertex positions. */
+  float error{};
+};
+
+/**
+ * @brief Sphere that bounds the vertices of a mesh.
+ */
+struct abcg::BoundingSphere {
+  /** @brief Center, in object space. */
+  glm::vec3 center{};
+  /** @brief Radius, in object space. */
+  float radius{};
+};
+
+/**
+ * @brief Level of detail of a abcg::MeshLodChain.
+ */
+struct abcg::MeshLod {
+  /** @brief Offset of the first index within abcg::MeshLodChain::indices. */
+  std::size_t firstIndex{};
+  /** @brief Number of indices. */
+  std::size_t indexCount{};
+  /** @brief Approximate deviation from the full resolution mesh, in the units
+   * of the vertex positions. */
+  float error{};
+};
+
+/**
+ * @brief Levels of detail of a mesh, generated by abcg::generateMeshLods.
+ *
+ * All levels index the same vertex array, so a single vertex buffer serves
+ * the whole chain. The index arrays of the levels are stored one after the
+ * other, from the full resolution mesh to the coarsest level, so they can be
+ * uploaded to a single index buffer and drawn with the offset
+ * `firstIndex * sizeof(std::uint32_t)`.
+ */
+struct abcg::MeshLodChain {
+  /** @brief Index arrays of all levels of detail. */
+  std::vector<std::uint32_t> indices;
+  /** @brief Levels of detail, in order of decreasing detail. */
+  std::vector<MeshLod> lods;
+  /** @brief Bounding sphere of the mesh, used by abcg::selectMeshLod. */
+  BoundingSphere bounds;
+};
+
+/**
+ * @brief Settings of abcg::generateMeshLods.
+ */
+struct abcg::MeshLodSettings {
+  /** @brief Maximum number of levels, including the full resolution mesh. */
+  std::size_t maxLodCount{5};
+  /** @brief Target ratio between the triangle counts of consecutive
+   * levels. */
+  float reduction{0.5f};
+  /** @brief Levels whose error exceeds this value, in the units of the vertex
+   * positions, are not generated. */
+  float maxError{1e30f};
+};
+
+/**
+ * @brief Generates the levels of detail of a mesh with vertices of type
+ * `Vertex`.
+ *
+ * @tparam Vertex Trivially copyable vertex type with a `glm::vec3 position`
+ * member.
+ *
+ * @param vertices Vertex array.
+ * @param indices Index array of a triangle list.
+ * @param settings Number of levels and reduction ratio.
+ * @param attributes Vertex attributes to preserve, in addition to positions.
+ *
+ * @return Levels of detail indexing `vertices`.
+ */
+template <typename Vertex>
+abcg::MeshLodChain
+abcg::generateMeshLods(std::span<Vertex const> vertices,
+                       std::span<std::uint32_t const> indices,
+                       MeshLodSettings const &settings,
+                       std::span<SimplifyAttribute const> attributes) {
+  static_assert(std::is_trivially_copyable_v<Vertex>);
+  static_assert(std::is_same_v<decltype(Vertex::position), glm::vec3>);
+  return generateMeshLods(indices, std::as_bytes(vertices), sizeof(Vertex),
+                          offsetof(Vertex, position), attributes, settings);
+}
+
+#endif
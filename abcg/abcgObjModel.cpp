@@ -0,0 +1,457 @@
+/**
+ * @file abcgObjModel.cpp
+ * @brief Definition of the Wavefront OBJ model loader.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgObjModel.hpp"
+
+#include <cppitertools/itertools.hpp>
+#include <fmt/core.h>
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+#include "abcgException.hpp"
+#include "abcgMappedFile.hpp"
+
+namespace {
+using Real = tinyobj::real_t;
+
+// Minimum size of the chunks parsed by each task
+constexpr std::size_t minChunkSize{std::size_t{4} << 20};
+
+// Face vertex whose indices are relative to the attributes read so far. The
+// indices are fixed up with the attribute counts of the preceding chunks.
+struct RelativeIndex {
+  std::size_t position{};
+  bool vertex{};
+  bool normal{};
+  bool texcoord{};
+};
+
+// Start of a shape (`o` or `g` statement), as a position in the indices of the
+// chunk
+struct ShapeStart {
+  std::string name;
+  std::size_t position{};
+};
+
+// Result of parsing a chunk of lines
+struct Chunk {
+  std::string_view text;
+  std::vector<Real> positions;
+  std::vector<Real> normals;
+  std::vector<Real> texcoords;
+  std::vector<tinyobj::index_t> indices;
+  std::vector<RelativeIndex> relativeIndices;
+  std::vector<ShapeStart> shapeStarts;
+};
+
+[[nodiscard]] bool isSpace(char character) {
+  return character == ' ' || character == '\t' || character == '\r';
+}
+
+void skipSpaces(std::string_view &text) {
+  auto const first{std::ranges::find_if_not(text, isSpace)};
+  text.remove_prefix(
+      gsl::narrow<std::size_t>(std::distance(text.begin(), first)));
+}
+
+// Removes and returns the first token of the text
+[[nodiscard]] std::string_view nextToken(std::string_view &text) {
+  skipSpaces(text);
+  auto const length{gsl::narrow<std::size_t>(
+      std::distance(text.begin(), std::ranges::find_if(text, isSpace)))};
+  auto const token{text.substr(0, length)};
+  text.remove_prefix(length);
+  return token;
+}
+
+// Parses a real number in decimal notation, with an optional exponent
+[[nodiscard]] bool parseReal(std::string_view token, Real &value) {
+  static constexpr std::array<double, 23> powersOf10{
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  // std::from_chars takes pointers, which string_view iterators may not be
+  char const *current{token.data()};
+  char const *const end{token.data() + token.size()};
+  auto const negative{current != end && *current == '-'};
+  if (current != end && (*current == '-' || *current == '+')) {
+    ++current;
+  }
+
+  // Keep up to 19 significant digits in the mantissa
+  std::uint64_t mantissa{};
+  int exponent{};
+  int digits{};
+  int significantDigits{};
+  auto const readDigits{[&](bool fraction) {
+    for (; current != end && *current >= '0' && *current <= '9'; ++current) {
+      ++digits;
+      if (significantDigits < 19) {
+        if (mantissa > 0 || *current != '0') {
+          ++significantDigits;
+        }
+        mantissa = mantissa * 10 + gsl::narrow<std::uint64_t>(*current - '0');
+        exponent -= fraction ? 1 : 0;
+      } else {
+        exponent += fraction ? 0 : 1;
+      }
+    }
+  }};
+  readDigits(false);
+  if (current != end && *current == '.') {
+    ++current;
+    readDigits(true);
+  }
+  if (digits == 0) {
+    return false;
+  }
+
+  if (current != end && (*current == 'e' || *current == 'E')) {
+    ++current;
+    if (current != end && *current == '+') {
+      ++current;
+    }
+    int exponentValue{};
+    auto const [pointer, error]{std::from_chars(current, end, exponentValue)};
+    if (error != std::errc{}) {
+      return false;
+    }
+    exponent += exponentValue;
+    current = pointer;
+  }
+  if (current != end) {
+    return false;
+  }
+
+  auto result{static_cast<double>(mantissa)};
+  auto const absExponent{std::abs(exponent)};
+  auto const scale{absExponent < std::ssize(powersOf10)
+                       ? powersOf10.at(gsl::narrow<std::size_t>(absExponent))
+                       : std::pow(10.0, absExponent)};
+  result = exponent < 0 ? result / scale : result * scale;
+  value = static_cast<Real>(negative ? -result : result);
+  return true;
+}
+
+// Parses up to `count` real numbers, and at least `minCount`
+void parseReals(std::string_view text, std::size_t minCount, std::size_t count,
+                std::vector<Real> &values) {
+  for (auto const index : iter::range(count)) {
+    auto const token{nextToken(text)};
+    Real value{};
+    if (token.empty() && index >= minCount) {
+      value = 0;
+    } else if (!parseReal(token, value)) {
+      throw abcg::RuntimeError(fmt::format("invalid number '{}'", token));
+    }
+    values.push_back(value);
+  }
+}
+
+// Parses an index of a face vertex. Returns false if the index is relative.
+bool parseIndex(std::string_view token, std::size_t count, int &index) {
+  int value{};
+  auto const [pointer, error]{
+      std::from_chars(token.data(), token.data() + token.size(), value)};
+  if (error != std::errc{} || pointer != token.data() + token.size() ||
+      value == 0) {
+    throw abcg::RuntimeError(fmt::format("invalid index '{}'", token));
+  }
+  if (value > 0) {
+    index = value - 1;
+    return true;
+  }
+  // Relative to the attributes read so far in this chunk
+  index = gsl::narrow<int>(gsl::narrow<std::ptrdiff_t>(count) + value);
+  return false;
+}
+
+// Parses a face and triangulates it as a fan
+void parseFace(std::string_view text, Chunk &chunk,
+               std::vector<std::pair<tinyobj::index_t, RelativeIndex>> &face) {
+  face.clear();
+  for (auto token{nextToken(text)}; !token.empty(); token = nextToken(text)) {
+    tinyobj::index_t index{.vertex_index = -1,
+                           .normal_index = -1,
+                           .texcoord_index = -1};
+    RelativeIndex relative{};
+
+    // v, v/vt, v//vn or v/vt/vn
+    auto const firstSlash{token.find('/')};
+    relative.vertex = !parseIndex(token.substr(0, firstSlash),
+                                  chunk.positions.size() / 3,
+                                  index.vertex_index);
+    if (firstSlash != std::string_view::npos) {
+      auto const rest{token.substr(firstSlash + 1)};
+      auto const secondSlash{rest.find('/')};
+      if (auto const texcoord{rest.substr(0, secondSlash)};
+          !texcoord.empty()) {
+        relative.texcoord = !parseIndex(texcoord, chunk.texcoords.size() / 2,
+                                        index.texcoord_index);
+      }
+      if (secondSlash != std::string_view::npos) {
+        relative.normal =
+            !parseIndex(rest.substr(secondSlash + 1),
+                        chunk.normals.size() / 3, index.normal_index);
+      }
+    }
+    face.emplace_back(index, relative);
+  }
+  if (face.size() < 3) {
+    throw abcg::RuntimeError("face with less than 3 vertices");
+  }
+
+  auto const addVertex{[&chunk](auto const &vertex) {
+    auto [index, relative]{vertex};
+    if (relative.vertex || relative.normal || relative.texcoord) {
+      relative.position = chunk.indices.size();
+      chunk.relativeIndices.push_back(relative);
+    }
+    chunk.indices.push_back(index);
+  }};
+  for (auto const index : iter::range(std::size_t{1}, face.size() - 1)) {
+    addVertex(face.front());
+    addVertex(face.at(index));
+    addVertex(face.at(index + 1));
+  }
+}
+
+// Parses the lines of a chunk
+void parseChunk(Chunk &chunk) {
+  std::vector<std::pair<tinyobj::index_t, RelativeIndex>> face;
+  auto text{chunk.text};
+  while (!text.empty()) {
+    auto const lineEnd{text.find('\n')};
+    auto line{text.substr(0, lineEnd)};
+    text.remove_prefix(lineEnd == std::string_view::npos ? text.size()
+                                                         : lineEnd + 1);
+
+    try {
+      auto const keyword{nextToken(line)};
+      if (keyword == "v") {
+        parseReals(line, 3, 3, chunk.positions);
+      } else if (keyword == "vn") {
+        parseReals(line, 3, 3, chunk.normals);
+      } else if (keyword == "vt") {
+        parseReals(line, 1, 2, chunk.texcoords);
+      } else if (keyword == "f") {
+        parseFace(line, chunk, face);
+      } else if (keyword == "o" || keyword == "g") {
+        skipSpaces(line);
+        while (!line.empty() && isSpace(line.back())) {
+          line.remove_suffix(1);
+        }
+        chunk.shapeStarts.push_back(
+            {.name = std::string{line}, .position = chunk.indices.size()});
+      }
+      // Comments, materials and other statements are ignored
+    } catch (abcg::Exception const &exception) {
+      throw abcg::RuntimeError(
+          fmt::format("{} in line '{}'", exception.what(),
+                      chunk.text.substr(
+                          gsl::narrow<std::size_t>(line.data() -
+                                                   chunk.text.data()),
+                          line.size())));
+    }
+  }
+}
+
+// Returns whether an index is out of range. Optional indices can be -1.
+[[nodiscard]] bool isInvalidIndex(int index, std::size_t count,
+                                  bool optional) {
+  return index < (optional ? -1 : 0) ||
+         (index >= 0 && gsl::narrow<std::size_t>(index) >= count);
+}
+
+// Splits the text into chunks of whole lines
+[[nodiscard]] std::vector<Chunk> splitChunks(std::string_view text,
+                                             std::size_t chunkCount) {
+  std::vector<Chunk> chunks;
+  std::size_t first{};
+  for (auto const index : iter::range(std::size_t{1}, chunkCount + 1)) {
+    auto last{index == chunkCount ? text.size()
+                                  : text.size() / chunkCount * index};
+    last = std::max(last, first);
+    if (last < text.size()) {
+      auto const lineEnd{text.find('\n', last)};
+      last = lineEnd == std::string_view::npos ? text.size() : lineEnd + 1;
+    }
+    if (last > first) {
+      chunks.emplace_back().text = text.substr(first, last - first);
+    }
+    first = last;
+  }
+  return chunks;
+}
+} // namespace
+
+/**
+ * @brief Loads a Wavefront OBJ model.
+ *
+ * The file is mapped into memory and split into chunks of whole lines, which
+ * are parsed concurrently by the worker threads of `threadPool` and the
+ * calling thread. The results of the chunks are then merged, and indices
+ * relative to the attributes read so far (negative indices) are fixed up.
+ *
+ * Vertex positions, normals and texture coordinates (`v`, `vn` and `vt`),
+ * faces (`f`) and shapes (`o` and `g`) are read. Faces are triangulated as
+ * fans. Other statements, such as materials, are ignored.
+ *
+ * @param path Path to the OBJ file.
+ * @param threadPool Pool of worker threads.
+ *
+ * @throw abcg::RuntimeError if the file could not be read or parsed.
+ *
+ * @return Attributes and shapes of the model.
+ */
+abcg::ObjModel abcg::loadObjModel(std::string_view path,
+                                  ThreadPool &threadPool) {
+  MappedFile const file{path};
+  auto const data{file.getData()};
+  std::string_view const text{reinterpret_cast<char const *>(data.data()),
+                              data.size()};
+
+  auto const chunkCount{std::clamp<std::size_t>(
+      text.size() / minChunkSize, 1, (threadPool.getThreadCount() + 1) * 4)};
+  auto chunks{splitChunks(text, chunkCount)};
+
+  try {
+    threadPool.parallelFor(chunks.size(),
+                           [&chunks](std::size_t first, std::size_t last) {
+                             for (auto const index : iter::range(first, last)) {
+                               parseChunk(chunks.at(index));
+                             }
+                           });
+  } catch (abcg::Exception const &exception) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to load model {} ({})", path, exception.what()));
+  }
+
+  // Offsets of the results of each chunk in the merged arrays
+  struct Offsets {
+    std::size_t positions{};
+    std::size_t normals{};
+    std::size_t texcoords{};
+    std::size_t indices{};
+  };
+  std::vector<Offsets> offsets(chunks.size() + 1);
+  for (auto &&[index, chunk] : iter::enumerate(chunks)) {
+    auto const &offset{offsets.at(index)};
+    offsets.at(index + 1) = {
+        .positions = offset.positions + chunk.positions.size(),
+        .normals = offset.normals + chunk.normals.size(),
+        .texcoords = offset.texcoords + chunk.texcoords.size(),
+        .indices = offset.indices + chunk.indices.size()};
+  }
+  auto const &totals{offsets.back()};
+
+  // Shapes start at `o` and `g` statements. Empty shapes are dropped, so that
+  // the last name given before the first face of a shape is kept.
+  std::vector<ShapeStart> shapeStarts{{}};
+  for (auto &&[index, chunk] : iter::enumerate(chunks)) {
+    for (auto &shapeStart : chunk.shapeStarts) {
+      shapeStart.position += offsets.at(index).indices;
+      shapeStarts.push_back(std::move(shapeStart));
+    }
+  }
+  shapeStarts.push_back({.name = {}, .position = totals.indices});
+
+  ObjModel model;
+  std::vector<std::size_t> shapePositions;
+  for (auto const index : iter::range(shapeStarts.size() - 1)) {
+    auto const first{shapeStarts.at(index).position};
+    auto const last{shapeStarts.at(index + 1).position};
+    if (last > first) {
+      auto &shape{model.shapes.emplace_back()};
+      shape.name = std::move(shapeStarts.at(index).name);
+      auto const triangleCount{(last - first) / 3};
+      shape.mesh.indices.resize(last - first);
+      shape.mesh.num_face_vertices.assign(triangleCount, 3);
+      shape.mesh.material_ids.assign(triangleCount, -1);
+      shape.mesh.smoothing_group_ids.assign(triangleCount, 0);
+      shapePositions.push_back(first);
+    }
+  }
+
+  auto &attrib{model.attrib};
+  attrib.vertices.resize(totals.positions);
+  attrib.normals.resize(totals.normals);
+  attrib.texcoords.resize(totals.texcoords);
+
+  // Merge the chunks
+  threadPool.parallelFor(chunks.size(), [&](std::size_t first,
+                                            std::size_t last) {
+    for (auto const chunkIndex : iter::range(first, last)) {
+      auto &chunk{chunks.at(chunkIndex)};
+      auto const &offset{offsets.at(chunkIndex)};
+
+      std::ranges::copy(
+          chunk.positions,
+          std::span{attrib.vertices}.subspan(offset.positions).begin());
+      std::ranges::copy(
+          chunk.normals,
+          std::span{attrib.normals}.subspan(offset.normals).begin());
+      std::ranges::copy(
+          chunk.texcoords,
+          std::span{attrib.texcoords}.subspan(offset.texcoords).begin());
+
+      // Fix up relative indices
+      for (auto const &relative : chunk.relativeIndices) {
+        auto &index{chunk.indices.at(relative.position)};
+        index.vertex_index +=
+            relative.vertex ? gsl::narrow<int>(offset.positions / 3) : 0;
+        index.normal_index +=
+            relative.normal ? gsl::narrow<int>(offset.normals / 3) : 0;
+        index.texcoord_index +=
+            relative.texcoord ? gsl::narrow<int>(offset.texcoords / 2) : 0;
+      }
+      if (std::ranges::any_of(chunk.indices, [&totals](auto const &index) {
+            return isInvalidIndex(index.vertex_index, totals.positions / 3,
+                                  false) ||
+                   isInvalidIndex(index.normal_index, totals.normals / 3,
+                                  true) ||
+                   isInvalidIndex(index.texcoord_index, totals.texcoords / 2,
+                                  true);
+          })) {
+        throw abcg::RuntimeError(
+            fmt::format("Failed to load model {} (index out of range)", path));
+      }
+
+      // Copy the indices to the shapes that overlap the chunk
+      auto const chunkFirst{offset.indices};
+      auto const chunkLast{chunkFirst + chunk.indices.size()};
+      for (auto &&[shape, shapeFirst] :
+           iter::zip(model.shapes, shapePositions)) {
+        auto const shapeLast{shapeFirst + shape.mesh.indices.size()};
+        auto const overlapFirst{std::max(chunkFirst, shapeFirst)};
+        auto const overlapLast{std::min(chunkLast, shapeLast)};
+        if (overlapFirst < overlapLast) {
+          auto const source{std::span{chunk.indices}.subspan(
+              overlapFirst - chunkFirst, overlapLast - overlapFirst)};
+          std::ranges::copy(source, std::span{shape.mesh.indices}
+                                        .subspan(overlapFirst - shapeFirst)
+                                        .begin());
+        }
+      }
+
+      // Release the memory of the chunk
+      chunk = {};
+    }
+  });
+
+  return model;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file abcgObjModel.hpp
+ * @brief Declaration of the Wavefront OBJ model loader.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OBJ_MODEL_HPP_
+#define ABCG_OBJ_MODEL_HPP_
+
+#include "abcgThreadPool.hpp"
+
+#include <tiny_obj_loader.h>
+
+#include <string_view>
+#include <vector>
+
+namespace abcg {
+struct ObjModel;
+
+[[nodiscard]] ObjModel loadObjModel(std::string_view path,
+                                    ThreadPool &threadPool = getThreadPool());
+} // namespace abcg
+
+/**
+ * @brief Geometry of a Wavefront OBJ model loaded by abcg::loadObjModel.
+ *
+ * The attributes and shapes use the tinyobj types, with the same layout as
+ * the ones returned by `tinyobj::ObjReader` with triangulation enabled.
+ */
+struct abcg::ObjModel {
+  /** @brief Vertex attributes. Only `vertices` (positions), `normals` and
+   * `texcoords` are filled. */
+  tinyobj::attrib_t attrib;
+  /** @brief Shapes, in order of appearance. Only the triangle meshes are
+   * filled, with no materials. */
+  std::vector<tinyobj::shape_t> shapes;
+};
+
+#endif
@@ -15,7 +15,13 @@
 
 #include "abcg.hpp"
 #include "abcgOpenGLImage.hpp"
+#include "abcgOpenGLProgram.hpp"
 #include "abcgOpenGLShader.hpp"
+#include "abcgOpenGLShaderCompileQueue.hpp"
+#include "abcgOpenGLStateCache.hpp"
+#include "abcgOpenGLTextureQueue.hpp"
+#include "abcgOpenGLUploadRing.hpp"
+#include "abcgOpenGLVertexLayout.hpp"
 #include "abcgOpenGLWindow.hpp"
 
 #endif
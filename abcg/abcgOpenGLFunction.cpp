@@ -12,9 +12,174 @@
 #include "abcgOpenGLError.hpp"
 
 #if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include <gsl/gsl>
+
+#include "abcgExternal.hpp"
+
+namespace {
+// Set while errors are reported by the debug message callback
+std::atomic<bool> debugOutputEnabled{};
+// Set by the callback when an error message arrives
+std::atomic<bool> debugErrorPending{};
+// Guards the message of the pending error, as the callback may be called
+// from another thread when the debug output is asynchronous
+std::mutex debugErrorMutex;
+std::string debugErrorMessage;
+
+[[nodiscard]] bool hasDebugOutput() {
+  GLint contextFlags{};
+  glGetIntegerv(GL_CONTEXT_FLAGS, &contextFlags);
+  if ((gsl::narrow_cast<GLuint>(contextFlags) & GL_CONTEXT_FLAG_DEBUG_BIT) ==
+      0) {
+    return false;
+  }
+
+  // KHR_debug is part of the core profile since OpenGL 4.3
+  GLint majorVersion{};
+  GLint minorVersion{};
+  glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+  glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+  if (majorVersion > 4 || (majorVersion == 4 && minorVersion >= 3)) {
+    return true;
+  }
+
+  GLint numExtensions{};
+  glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+  for (GLint index{}; index < numExtensions; ++index) {
+    auto const *name{reinterpret_cast<char const *>(
+        glGetStringi(GL_EXTENSIONS, gsl::narrow<GLuint>(index)))};
+    if (name != nullptr && std::strcmp(name, "GL_KHR_debug") == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+[[nodiscard]] std::string_view getDebugTypeString(GLenum type) {
+  switch (type) {
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    return "deprecated behavior";
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    return "undefined behavior";
+  case GL_DEBUG_TYPE_PORTABILITY:
+    return "portability";
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    return "performance";
+  default:
+    return "message";
+  }
+}
+
+// Errors are kept to be thrown by abcg::checkGLError, as exceptions must not
+// propagate through the OpenGL implementation. Other messages are printed.
+void GLAPIENTRY debugMessageCallback(GLenum /*source*/, GLenum type,
+                                     GLuint /*id*/, GLenum /*severity*/,
+                                     GLsizei length, GLchar const *message,
+                                     void const * /*userParam*/) {
+  std::string_view const text{
+      length < 0 ? std::string_view{message}
+                 : std::string_view{message, gsl::narrow_cast<std::size_t>(
+                                                 length)}};
+  if (type != GL_DEBUG_TYPE_ERROR) {
+    fmt::print("Warning: OpenGL {}: {}\n", getDebugTypeString(type), text);
+    return;
+  }
+
+  std::scoped_lock const lock{debugErrorMutex};
+  if (!debugErrorPending.load(std::memory_order_relaxed)) {
+    debugErrorMessage = text;
+    debugErrorPending.store(true, std::memory_order_release);
+  }
+}
+} // namespace
+
+/**
+ * @brief Reports OpenGL errors through a debug message callback.
+ *
+ * If the current context is a debug context that supports `KHR_debug`, a
+ * callback is installed with `glDebugMessageCallback`, and
+ * abcg::checkGLError no longer calls `glGetError`. Instead, it throws only
+ * when the callback has received an error message. Messages of other types
+ * are printed as warnings, except notifications, which are disabled.
+ *
+ * With synchronous output, messages are generated during the call that
+ * causes them, so the exception reports the source location of that call.
+ * Otherwise, the error is reported by the first checked call after the
+ * message arrives.
+ *
+ * This must be called while the OpenGL context is current.
+ *
+ * @param synchronous Whether to enable `GL_DEBUG_OUTPUT_SYNCHRONOUS`.
+ *
+ * @return `true` if the callback was installed, or `false` if errors are
+ * still checked with `glGetError`.
+ */
+bool abcg::enableGLDebugOutput(bool synchronous) {
+  disableGLDebugOutput();
+  if (!hasDebugOutput()) {
+    return false;
+  }
+
+  glDebugMessageCallback(debugMessageCallback, nullptr);
+  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE,
+                        GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+  glEnable(GL_DEBUG_OUTPUT);
+  if (synchronous) {
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  } else {
+    glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  }
+
+  // Errors raised before the callback was installed are still in the queue
+  // of glGetError
+  while (glGetError() != GL_NO_ERROR) {
+  }
+
+  debugOutputEnabled.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+/**
+ * @brief Removes the debug message callback installed by
+ * abcg::enableGLDebugOutput.
+ *
+ * Errors are checked again with `glGetError`. This must be called while the
+ * OpenGL context is current.
+ */
+void abcg::disableGLDebugOutput() {
+  if (!debugOutputEnabled.exchange(false, std::memory_order_relaxed)) {
+    return;
+  }
+  glDisable(GL_DEBUG_OUTPUT);
+  glDebugMessageCallback(nullptr, nullptr);
+
+  std::scoped_lock const lock{debugErrorMutex};
+  debugErrorPending.store(false, std::memory_order_relaxed);
+  debugErrorMessage.clear();
+}
+
+/**
+ * @brief Returns whether errors are reported by the debug message callback.
+ *
+ * @return `true` if abcg::enableGLDebugOutput installed the callback.
+ */
+bool abcg::isGLDebugOutputEnabled() noexcept {
+  return debugOutputEnabled.load(std::memory_order_relaxed);
+}
+
 /**
  * @brief Checks OpenGL error status and throws on error with a log message.
  *
+ * If abcg::enableGLDebugOutput installed the debug message callback, this
+ * only checks whether the callback has received an error message, and the
+ * source location is resolved only in that case. Otherwise, the error status
+ * is queried with `glGetError`.
+ *
  * @param sourceLocation Information about the source code, to be used for
  * logging.
  * @param appendString A string to be appended to "OpenGL error " in the
@@ -24,6 +189,20 @@
  */
 void abcg::checkGLError(source_location const &sourceLocation,
                         std::string_view const appendString) {
+  if (debugOutputEnabled.load(std::memory_order_relaxed)) {
+    if (!debugErrorPending.load(std::memory_order_acquire)) {
+      return;
+    }
+    std::string what;
+    {
+      std::scoped_lock const lock{debugErrorMutex};
+      what = fmt::format("{}: {}", appendString, debugErrorMessage);
+      debugErrorMessage.clear();
+      debugErrorPending.store(false, std::memory_order_relaxed);
+    }
+    throw abcg::OpenGLError(what, glGetError(), sourceLocation);
+  }
+
   // Throw on first error
   if (auto const status{glGetError()}; status != GL_NO_ERROR) {
     throw abcg::OpenGLError(appendString, status, sourceLocation);
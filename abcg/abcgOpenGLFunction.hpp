@@ -28,10 +28,14 @@ using source_location = std::source_location;
 #endif
 #endif
 
+#include <array>
+#include <cstddef>
+#include <span>
 #include <string_view>
 #include <type_traits>
 
 #include "abcgOpenGLExternal.hpp"
+#include "abcgOpenGLStateCache.hpp"
 
 #if defined(_MSC_VER)
 // Disable "unreachable code" warnings for the case callGl is not specialized
@@ -45,10 +49,16 @@ namespace abcg {
 
 void checkGLError(source_location const &sourceLocation,
                   std::string_view appendString);
+[[nodiscard]] bool enableGLDebugOutput(bool synchronous);
+void disableGLDebugOutput();
+[[nodiscard]] bool isGLDebugOutputEnabled() noexcept;
 
 /**
  * @brief Checks for OpenGL errors before and after a function call.
  *
+ * Errors are checked with abcg::checkGLError, which calls `glGetError` unless
+ * abcg::enableGLDebugOutput has installed a debug message callback.
+ *
  * @tparam TFun Function typename.
  * @tparam TArgs Variadic arguments typename.
  *
@@ -105,6 +115,34 @@ auto callGL([[maybe_unused]] source_location, TFun &&function,
 }
 #endif
 
+/**
+ * @brief Checks a uniform upload against abcg::OpenGLStateCache.
+ *
+ * @tparam T Type of the components of the value.
+ *
+ * @param location Location of the uniform variable.
+ * @param type Type of the components of the value.
+ * @param value Pointer to the components of the value.
+ * @param count Number of elements of the value.
+ * @param componentCount Number of components of each element.
+ *
+ * @return `true` if the cache is enabled and the uniform variable already
+ * holds the value, so the upload can be elided.
+ */
+template <typename T>
+[[nodiscard]] bool isRedundantUniform(GLint location, OpenGLUniformType type,
+                                      T const *value, GLsizei count,
+                                      std::size_t componentCount) {
+  auto &cache{getOpenGLStateCache()};
+  if (!cache.isEnabled() || value == nullptr || count <= 0) {
+    return false;
+  }
+  std::span const components{value,
+                             static_cast<std::size_t>(count) * componentCount};
+  return !cache.updateUniform(location, count, type,
+                              std::as_bytes(components));
+}
+
 // NOLINTBEGIN(readability-identifier-length)
 
 // OpenGL ES 2.0 function definitions
@@ -127,6 +165,10 @@ inline void glBindAttribLocation(
 inline void glBindBuffer(
     GLenum target, GLuint buffer,
     source_location const &sourceLocation = source_location::current()) {
+  if (auto &cache{getOpenGLStateCache()};
+      cache.isEnabled() && !cache.updateBuffer(target, buffer)) {
+    return;
+  }
   callGL(sourceLocation, ::glBindBuffer, target, buffer);
 }
 inline void glBindFramebuffer(
@@ -259,6 +301,9 @@ inline void glDeleteBuffers(
     source_location const &sourceLocation = source_location::current()) {
   if (buffers == nullptr || *buffers == 0)
     return;
+  if (auto &cache{getOpenGLStateCache()}; cache.isEnabled() && n > 0) {
+    cache.forgetBuffers({buffers, static_cast<std::size_t>(n)});
+  }
   callGL(sourceLocation, ::glDeleteBuffers, n, buffers);
 }
 inline void glDeleteFramebuffers(
@@ -273,6 +318,9 @@ inline void glDeleteProgram(
     source_location const &sourceLocation = source_location::current()) {
   if (program == 0)
     return;
+  if (auto &cache{getOpenGLStateCache()}; cache.isEnabled()) {
+    cache.forgetProgram(program);
+  }
   callGL(sourceLocation, ::glDeleteProgram, program);
 }
 inline void glDeleteRenderbuffers(
@@ -317,6 +365,10 @@ inline void glDetachShader(
 inline void
 glDisable(GLenum cap,
           source_location const &sourceLocation = source_location::current()) {
+  if (auto &cache{getOpenGLStateCache()};
+      cache.isEnabled() && !cache.updateCapability(cap, false)) {
+    return;
+  }
   callGL(sourceLocation, ::glDisable, cap);
 }
 inline void glDisableVertexAttribArray(
@@ -337,6 +389,10 @@ inline void glDrawElements(
 inline void
 glEnable(GLenum cap,
          source_location const &sourceLocation = source_location::current()) {
+  if (auto &cache{getOpenGLStateCache()};
+      cache.isEnabled() && !cache.updateCapability(cap, true)) {
+    return;
+  }
   callGL(sourceLocation, ::glEnable, cap);
 }
 inline void glEnableVertexAttribArray(
@@ -575,6 +631,9 @@ inline void glLineWidth(GLfloat width, source_location const &sourceLocation =
 inline void glLinkProgram(
     GLuint program,
     source_location const &sourceLocation = source_location::current()) {
+  if (auto &cache{getOpenGLStateCache()}; cache.isEnabled()) {
+    cache.forgetProgram(program);
+  }
   callGL(sourceLocation, ::glLinkProgram, program);
 }
 inline void glPixelStorei(
@@ -693,103 +752,192 @@ inline void glTexSubImage2D(
 inline void glUniform1f(
     GLint location, GLfloat v0,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0};
+      isRedundantUniform(location, OpenGLUniformType::Float, value.data(), 1,
+                         value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform1f, location, v0);
 }
 inline void glUniform1fv(
     GLint location, GLsizei count, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::Float, value, count, 1)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform1fv, location, count, value);
 }
 inline void glUniform1i(
     GLint location, GLint v0,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0};
+      isRedundantUniform(location, OpenGLUniformType::Int, value.data(), 1,
+                         value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform1i, location, v0);
 }
 inline void glUniform1iv(
     GLint location, GLsizei count, GLint const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::Int, value, count, 1)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform1iv, location, count, value);
 }
 inline void glUniform2f(
     GLint location, GLfloat v0, GLfloat v1,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0, v1};
+      isRedundantUniform(location, OpenGLUniformType::Float, value.data(), 1,
+                         value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform2f, location, v0, v1);
 }
 inline void glUniform2fv(
     GLint location, GLsizei count, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::Float, value, count, 2)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform2fv, location, count, value);
 }
 inline void glUniform2i(
     GLint location, GLint v0, GLint v1,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0, v1};
+      isRedundantUniform(location, OpenGLUniformType::Int, value.data(), 1,
+                         value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform2i, location, v0, v1);
 }
 inline void glUniform2iv(
     GLint location, GLsizei count, GLint const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::Int, value, count, 2)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform2iv, location, count, value);
 }
 inline void glUniform3f(
     GLint location, GLfloat v0, GLfloat v1, GLfloat v2,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0, v1, v2};
+      isRedundantUniform(location, OpenGLUniformType::Float, value.data(), 1,
+                         value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform3f, location, v0, v1, v2);
 }
 inline void glUniform3fv(
     GLint location, GLsizei count, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::Float, value, count, 3)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform3fv, location, count, value);
 }
 inline void glUniform3i(
     GLint location, GLint v0, GLint v1, GLint v2,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0, v1, v2};
+      isRedundantUniform(location, OpenGLUniformType::Int, value.data(), 1,
+                         value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform3i, location, v0, v1, v2);
 }
 inline void glUniform3iv(
     GLint location, GLsizei count, GLint const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::Int, value, count, 3)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform3iv, location, count, value);
 }
 inline void glUniform4f(
     GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0, v1, v2, v3};
+      isRedundantUniform(location, OpenGLUniformType::Float, value.data(), 1,
+                         value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform4f, location, v0, v1, v2, v3);
 }
 inline void glUniform4fv(
     GLint location, GLsizei count, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::Float, value, count, 4)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform4fv, location, count, value);
 }
 inline void glUniform4i(
     GLint location, GLint v0, GLint v1, GLint v2, GLint v3,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0, v1, v2, v3};
+      isRedundantUniform(location, OpenGLUniformType::Int, value.data(), 1,
+                         value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform4i, location, v0, v1, v2, v3);
 }
 inline void glUniform4iv(
     GLint location, GLsizei count, GLint const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::Int, value, count, 4)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform4iv, location, count, value);
 }
 inline void glUniformMatrix2fv(
     GLint location, GLsizei count, GLboolean transpose, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location,
+                         transpose == GL_FALSE
+                             ? OpenGLUniformType::Matrix
+                             : OpenGLUniformType::TransposedMatrix,
+                         value, count, 4)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniformMatrix2fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix3fv(
     GLint location, GLsizei count, GLboolean transpose, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location,
+                         transpose == GL_FALSE
+                             ? OpenGLUniformType::Matrix
+                             : OpenGLUniformType::TransposedMatrix,
+                         value, count, 9)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniformMatrix3fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix4fv(
     GLint location, GLsizei count, GLboolean transpose, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location,
+                         transpose == GL_FALSE
+                             ? OpenGLUniformType::Matrix
+                             : OpenGLUniformType::TransposedMatrix,
+                         value, count, 16)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniformMatrix4fv, location, count, transpose,
          value);
 }
 inline void glUseProgram(GLuint program, source_location const &sourceLocation =
                                              source_location::current()) {
+  if (auto &cache{getOpenGLStateCache()};
+      cache.isEnabled() && !cache.updateProgram(program)) {
+    return;
+  }
   callGL(sourceLocation, ::glUseProgram, program);
 }
 inline void glValidateProgram(
@@ -955,36 +1103,78 @@ inline void glDrawBuffers(
 inline void glUniformMatrix2x3fv(
     GLint location, GLsizei count, GLboolean transpose, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location,
+                         transpose == GL_FALSE
+                             ? OpenGLUniformType::Matrix
+                             : OpenGLUniformType::TransposedMatrix,
+                         value, count, 6)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniformMatrix2x3fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix3x2fv(
     GLint location, GLsizei count, GLboolean transpose, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location,
+                         transpose == GL_FALSE
+                             ? OpenGLUniformType::Matrix
+                             : OpenGLUniformType::TransposedMatrix,
+                         value, count, 6)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniformMatrix3x2fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix2x4fv(
     GLint location, GLsizei count, GLboolean transpose, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location,
+                         transpose == GL_FALSE
+                             ? OpenGLUniformType::Matrix
+                             : OpenGLUniformType::TransposedMatrix,
+                         value, count, 8)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniformMatrix2x4fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix4x2fv(
     GLint location, GLsizei count, GLboolean transpose, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location,
+                         transpose == GL_FALSE
+                             ? OpenGLUniformType::Matrix
+                             : OpenGLUniformType::TransposedMatrix,
+                         value, count, 8)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniformMatrix4x2fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix3x4fv(
     GLint location, GLsizei count, GLboolean transpose, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location,
+                         transpose == GL_FALSE
+                             ? OpenGLUniformType::Matrix
+                             : OpenGLUniformType::TransposedMatrix,
+                         value, count, 12)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniformMatrix3x4fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix4x3fv(
     GLint location, GLsizei count, GLboolean transpose, GLfloat const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location,
+                         transpose == GL_FALSE
+                             ? OpenGLUniformType::Matrix
+                             : OpenGLUniformType::TransposedMatrix,
+                         value, count, 12)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniformMatrix4x3fv, location, count, transpose,
          value);
 }
@@ -1022,11 +1212,19 @@ inline void glFlushMappedBufferRange(
 inline void glBindVertexArray(
     GLuint array,
     source_location const &sourceLocation = source_location::current()) {
+  if (auto &cache{getOpenGLStateCache()};
+      cache.isEnabled() && !cache.updateVertexArray(array)) {
+    return;
+  }
   callGL(sourceLocation, ::glBindVertexArray, array);
 }
 inline void glDeleteVertexArrays(
     GLsizei n, GLuint const *arrays,
     source_location const &sourceLocation = source_location::current()) {
+  if (auto &cache{getOpenGLStateCache()};
+      cache.isEnabled() && arrays != nullptr && n > 0) {
+    cache.forgetVertexArrays({arrays, static_cast<std::size_t>(n)});
+  }
   callGL(sourceLocation, ::glDeleteVertexArrays, n, arrays);
 }
 inline void glGenVertexArrays(
@@ -1128,41 +1326,77 @@ inline GLint glGetFragDataLocation(
 inline void glUniform1ui(
     GLint location, GLuint v0,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0};
+      isRedundantUniform(location, OpenGLUniformType::UnsignedInt,
+                         value.data(), 1, value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform1ui, location, v0);
 }
 inline void glUniform2ui(
     GLint location, GLuint v0, GLuint v1,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0, v1};
+      isRedundantUniform(location, OpenGLUniformType::UnsignedInt,
+                         value.data(), 1, value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform2ui, location, v0, v1);
 }
 inline void glUniform3ui(
     GLint location, GLuint v0, GLuint v1, GLuint v2,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0, v1, v2};
+      isRedundantUniform(location, OpenGLUniformType::UnsignedInt,
+                         value.data(), 1, value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform3ui, location, v0, v1, v2);
 }
 inline void glUniform4ui(
     GLint location, GLuint v0, GLuint v1, GLuint v2, GLuint v3,
     source_location const &sourceLocation = source_location::current()) {
+  if (std::array const value{v0, v1, v2, v3};
+      isRedundantUniform(location, OpenGLUniformType::UnsignedInt,
+                         value.data(), 1, value.size())) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform4ui, location, v0, v1, v2, v3);
 }
 inline void glUniform1uiv(
     GLint location, GLsizei count, GLuint const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::UnsignedInt, value,
+                         count, 1)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform1uiv, location, count, value);
 }
 inline void glUniform2uiv(
     GLint location, GLsizei count, GLuint const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::UnsignedInt, value,
+                         count, 2)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform2uiv, location, count, value);
 }
 inline void glUniform3uiv(
     GLint location, GLsizei count, GLuint const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::UnsignedInt, value,
+                         count, 3)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform3uiv, location, count, value);
 }
 inline void glUniform4uiv(
     GLint location, GLsizei count, GLuint const *value,
     source_location const &sourceLocation = source_location::current()) {
+  if (isRedundantUniform(location, OpenGLUniformType::UnsignedInt, value,
+                         count, 4)) {
+    return;
+  }
   callGL(sourceLocation, ::glUniform4uiv, location, count, value);
 }
 inline void glClearBufferiv(
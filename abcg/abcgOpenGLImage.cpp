@@ -9,18 +9,190 @@
  */
 
 #include "abcgOpenGLImage.hpp"
-#include "abcgImage.hpp"
 
 #include <cppitertools/itertools.hpp>
 #include <fmt/core.h>
 #include <gsl/gsl>
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <utility>
+
 #include "abcgException.hpp"
+#include "abcgThreadPool.hpp"
+
+namespace {
+struct TextureFormat {
+  Uint32 pixelFormat{};
+  GLenum internalFormat{};
+  GLenum format{};
+  int bytesPerPixel{};
+};
+
+// Enforces RGB/RGBA
+[[nodiscard]] TextureFormat selectTextureFormat(SDL_Surface const &surface,
+                                                bool sRGBToLinear) {
+  if (surface.format->BytesPerPixel == 3) {
+    return {.pixelFormat = SDL_PIXELFORMAT_RGB24,
+            .internalFormat = sRGBToLinear ? GLenum{GL_SRGB8} : GL_RGB,
+            .format = GL_RGB,
+            .bytesPerPixel = 3};
+  }
+  return {.pixelFormat = SDL_PIXELFORMAT_RGBA32,
+          .internalFormat = sRGBToLinear ? GLenum{GL_SRGB8_ALPHA8} : GL_RGBA,
+          .format = GL_RGBA,
+          .bytesPerPixel = 4};
+}
+
+// Returns the size of a row of pixels with the default GL_UNPACK_ALIGNMENT
+[[nodiscard]] std::size_t getUnpackPitch(int width, int bytesPerPixel) {
+  auto const rowSize{gsl::narrow<std::size_t>(width * bytesPerPixel)};
+  return (rowSize + 3) & ~std::size_t{3};
+}
+
+// Converts the pixels of a surface while writing them to another location,
+// flipping the rows if requested
+void writePixels(SDL_Surface const &surface, Uint32 pixelFormat,
+                 bool flipUpsideDown, std::span<std::byte> data) {
+  auto const height{gsl::narrow<std::size_t>(surface.h)};
+  auto const srcPitch{gsl::narrow<std::size_t>(surface.pitch)};
+  auto const dstPitch{data.size() / height};
+  std::span const pixels{static_cast<std::byte const *>(surface.pixels),
+                         srcPitch * height};
+
+  for (auto const row : iter::range(height)) {
+    auto const dstRow{flipUpsideDown ? height - row - 1 : row};
+    if (SDL_ConvertPixels(surface.w, 1, surface.format->format,
+                          pixels.subspan(row * srcPitch).data(),
+                          surface.pitch, pixelFormat,
+                          data.subspan(dstRow * dstPitch).data(),
+                          gsl::narrow<int>(dstPitch)) != 0) {
+      throw abcg::RuntimeError(
+          fmt::format("Failed to convert image: {}", SDL_GetError()));
+    }
+  }
+}
+
+// Specifies level 0 of the bound 2D texture from a buffer of the upload ring
+void uploadFromRing(abcg::OpenGLUploadRing &uploadRing, int width, int height,
+                    TextureFormat const &format,
+                    abcg::OpenGLUploadRing::WriteFunction const &write) {
+  // Allocate the storage, then source the pixels from the buffer
+  glTexImage2D(GL_TEXTURE_2D, 0, gsl::narrow<GLint>(format.internalFormat),
+               width, height, 0, format.format, GL_UNSIGNED_BYTE, nullptr);
+  uploadRing.upload(
+      getUnpackPitch(width, format.bytesPerPixel) *
+          gsl::narrow<std::size_t>(height),
+      write, [&] {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format.format,
+                        GL_UNSIGNED_BYTE, nullptr);
+      });
+}
+
+// Returns whether immutable texture storage (glTexStorage2D) is available
+[[nodiscard]] bool hasTextureStorage() {
+#if defined(__EMSCRIPTEN__)
+  return true;
+#else
+  GLint majorVersion{};
+  GLint minorVersion{};
+  glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+  glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+  if (majorVersion > 4 || (majorVersion == 4 && minorVersion >= 2)) {
+    return true;
+  }
+
+  GLint numExtensions{};
+  glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+  for (GLint index{}; index < numExtensions; ++index) {
+    auto const *name{reinterpret_cast<char const *>(
+        glGetStringi(GL_EXTENSIONS, gsl::narrow<GLuint>(index)))};
+    if (name != nullptr && std::strcmp(name, "GL_ARB_texture_storage") == 0) {
+      return true;
+    }
+  }
+  return false;
+#endif
+}
+
+// Converts and flips a face of a cubemap. Returns the face with its index in
+// the order of the cubemap targets.
+[[nodiscard]] std::pair<std::size_t, abcg::SurfacePtr>
+decodeCubemapFace(std::string_view path, std::size_t index,
+                  bool rightHandedSystem) {
+  // Enforce RGB
+  auto formattedSurface{
+      abcg::convertImage(*abcg::loadImage(path), SDL_PIXELFORMAT_RGB24)};
+
+  auto target{GL_TEXTURE_CUBE_MAP_POSITIVE_X + gsl::narrow<GLenum>(index)};
+
+  // LHS to RHS
+  if (rightHandedSystem) {
+    if (target == GL_TEXTURE_CUBE_MAP_POSITIVE_Y ||
+        target == GL_TEXTURE_CUBE_MAP_NEGATIVE_Y) {
+      // Flip upside down
+      abcg::flipVertically(*formattedSurface, abcg::getThreadPool());
+    } else {
+      abcg::flipHorizontally(*formattedSurface, abcg::getThreadPool());
+    }
+
+    // Swap -z and +z
+    if (target == GL_TEXTURE_CUBE_MAP_POSITIVE_Z)
+      target = GL_TEXTURE_CUBE_MAP_NEGATIVE_Z;
+    else if (target == GL_TEXTURE_CUBE_MAP_NEGATIVE_Z)
+      target = GL_TEXTURE_CUBE_MAP_POSITIVE_Z;
+  }
+
+  return {target - GL_TEXTURE_CUBE_MAP_POSITIVE_X,
+          std::move(formattedSurface)};
+}
+
+// Creates a 2D texture whose level 0 is specified by uploadImage
+[[nodiscard]] GLuint
+createTexture2D(abcg::OpenGLTextureCreateInfo const &createInfo,
+                std::function<void()> const &uploadImage) {
+  // Generate the texture
+  GLuint textureID{};
+  glGenTextures(1, &textureID);
+  glBindTexture(GL_TEXTURE_2D, textureID);
+  uploadImage();
+
+  // Set texture filtering
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  // Generate the mipmap levels
+  if (createInfo.generateMipmaps) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    // Override minifying filtering
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+  }
+
+  // Set texture wrapping
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return textureID;
+}
+} // namespace
 
 /**
  * @brief Creates an OpenGL 2D texture from an image loaded from a filesystem
  * path.
  *
+ * If abcg::OpenGLTextureCreateInfo::uploadRing is set, the image is
+ * converted and flipped while being written to a pixel unpack buffer of the
+ * ring, and the texture is specified from that buffer without waiting for the
+ * transfer. To load textures without blocking the render thread, use
+ * abcg::OpenGLTextureQueue.
+ *
  * @param createInfo Texture creation settings.
  *
  * @throw abcg::RuntimeError if the image could not be loaded.
@@ -28,116 +200,193 @@
  * @return ID of the texture, as generated by glGenTextures.
  */
 GLuint abcg::loadOpenGLTexture(OpenGLTextureCreateInfo const &createInfo) {
-  GLuint textureID{};
-
-  if (SDL_Surface *const surface{IMG_Load(createInfo.path.data())}) {
-    // Enforce RGB/RGBA
-    GLenum internalFormat{};
-    GLenum format{};
-    SDL_Surface *formattedSurface{};
-    if (surface->format->BytesPerPixel == 3) {
-      formattedSurface =
-          SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB24, 0);
-      internalFormat = createInfo.sRGBToLinear ? GL_SRGB8 : GL_RGB;
-      format = GL_RGB;
-    } else {
-      formattedSurface =
-          SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
-      internalFormat = createInfo.sRGBToLinear ? GL_SRGB8_ALPHA8 : GL_RGBA;
-      format = GL_RGBA;
-    }
-    SDL_FreeSurface(surface);
+  if (createInfo.uploadRing == nullptr) {
+    return uploadOpenGLTexture(createInfo, decodeOpenGLTexture(createInfo));
+  }
 
-    // Flip upside down
-    if (createInfo.flipUpsideDown) {
-      flipVertically(*formattedSurface);
-    }
+  auto surface{loadImage(createInfo.path)};
+  auto const format{selectTextureFormat(*surface, createInfo.sRGBToLinear)};
 
-    // Generate the texture
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, gsl::narrow<GLint>(internalFormat),
-                 formattedSurface->w, formattedSurface->h, 0, format,
-                 GL_UNSIGNED_BYTE, formattedSurface->pixels);
+  // SDL_ConvertPixels does not support indexed formats
+  if (SDL_ISPIXELFORMAT_INDEXED(surface->format->format)) {
+    surface = convertImage(*surface, format.pixelFormat);
+  }
 
-    SDL_FreeSurface(formattedSurface);
+  return createTexture2D(createInfo, [&] {
+    uploadFromRing(*createInfo.uploadRing, surface->w, surface->h, format,
+                   [&](std::span<std::byte> data) {
+                     writePixels(*surface, format.pixelFormat,
+                                 createInfo.flipUpsideDown, data);
+                   });
+  });
+}
 
-    // Set texture filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+/**
+ * @brief Creates an OpenGL cubemap texture from a set of images loaded from
+ * filesystem paths.
+ *
+ * To load textures without blocking the render thread, use
+ * abcg::OpenGLTextureQueue.
+ *
+ * @param createInfo Texture creation settings.
+ *
+ * @throw abcg::RuntimeError if any image could not be loaded.
+ *
+ * @return ID of the texture, as generated by glGenTextures.
+ */
+GLuint abcg::loadOpenGLCubemap(OpenGLCubemapCreateInfo const &createInfo) {
+  return uploadOpenGLCubemap(createInfo, decodeOpenGLCubemap(createInfo));
+}
 
-    // Generate the mipmap levels
-    if (createInfo.generateMipmaps) {
-      glGenerateMipmap(GL_TEXTURE_2D);
+/**
+ * @brief Decodes the image of an OpenGL 2D texture.
+ *
+ * This function does not call OpenGL and can be called from any thread.
+ *
+ * @param createInfo Texture creation settings.
+ *
+ * @throw abcg::RuntimeError if the image could not be loaded.
+ *
+ * @return Decoded image, to be passed to abcg::uploadOpenGLTexture.
+ */
+abcg::OpenGLDecodedTexture
+abcg::decodeOpenGLTexture(OpenGLTextureCreateInfo const &createInfo) {
+  auto const surface{loadImage(createInfo.path)};
+  auto const format{selectTextureFormat(*surface, createInfo.sRGBToLinear)};
 
-      // Override minifying filtering
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                      GL_LINEAR_MIPMAP_LINEAR);
-    }
+  OpenGLDecodedTexture decoded{
+      .surface = convertImage(*surface, format.pixelFormat),
+      .internalFormat = format.internalFormat,
+      .format = format.format};
 
-    // Set texture wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  } else {
-    throw abcg::RuntimeError(
-        fmt::format("Failed to load texture file {}", createInfo.path));
+  // Flip upside down
+  if (createInfo.flipUpsideDown) {
+    flipVertically(*decoded.surface, getThreadPool());
   }
 
-  glBindTexture(GL_TEXTURE_2D, 0);
-
-  return textureID;
+  return decoded;
 }
 
 /**
- * @brief Creates an OpenGL cubemap texture from a set of images loaded from
- * filesystem paths.
+ * @brief Decodes the images of an OpenGL cubemap texture.
+ *
+ * The faces are decoded concurrently by the worker threads of
+ * abcg::getThreadPool and the calling thread. This function does not call
+ * OpenGL and can be called from any thread.
  *
  * @param createInfo Texture creation settings.
  *
  * @throw abcg::RuntimeError if any image could not be loaded.
  *
+ * @return Decoded faces in the order of the cubemap targets, to be passed to
+ * abcg::uploadOpenGLCubemap.
+ */
+std::array<abcg::SurfacePtr, 6>
+abcg::decodeOpenGLCubemap(OpenGLCubemapCreateInfo const &createInfo) {
+  std::array<SurfacePtr, 6> faces;
+
+  // Decode the faces concurrently, one per task
+  getThreadPool().parallelFor(
+      faces.size(), [&](std::size_t first, std::size_t last) {
+        for (auto const index : iter::range(first, last)) {
+          auto [faceIndex, face]{decodeCubemapFace(
+              createInfo.paths.at(index), index,
+              createInfo.rightHandedSystem)};
+          // Each face is written by a single task
+          faces.at(faceIndex) = std::move(face);
+        }
+      });
+
+  return faces;
+}
+
+/**
+ * @brief Creates an OpenGL 2D texture from a decoded image.
+ *
+ * @param createInfo Texture creation settings.
+ * @param decoded Image decoded by abcg::decodeOpenGLTexture with the same
+ * settings.
+ *
  * @return ID of the texture, as generated by glGenTextures.
  */
-GLuint abcg::loadOpenGLCubemap(OpenGLCubemapCreateInfo const &createInfo) {
+GLuint abcg::uploadOpenGLTexture(OpenGLTextureCreateInfo const &createInfo,
+                                 OpenGLDecodedTexture const &decoded) {
+  auto const &surface{*decoded.surface};
+
+  return createTexture2D(createInfo, [&] {
+    if (createInfo.uploadRing == nullptr) {
+      glTexImage2D(GL_TEXTURE_2D, 0,
+                   gsl::narrow<GLint>(decoded.internalFormat), surface.w,
+                   surface.h, 0, decoded.format, GL_UNSIGNED_BYTE,
+                   surface.pixels);
+      return;
+    }
+
+    // The image is already converted and flipped
+    TextureFormat const format{
+        .pixelFormat = surface.format->format,
+        .internalFormat = decoded.internalFormat,
+        .format = decoded.format,
+        .bytesPerPixel = gsl::narrow<int>(surface.format->BytesPerPixel)};
+    uploadFromRing(*createInfo.uploadRing, surface.w, surface.h, format,
+                   [&](std::span<std::byte> data) {
+                     writePixels(surface, format.pixelFormat, false, data);
+                   });
+  });
+}
+
+/**
+ * @brief Creates an OpenGL cubemap texture from decoded images.
+ *
+ * If immutable texture storage is available, the storage of all faces and
+ * mipmap levels is allocated once with glTexStorage2D, and the faces are
+ * uploaded with glTexSubImage2D.
+ *
+ * @param createInfo Texture creation settings.
+ * @param faces Faces decoded by abcg::decodeOpenGLCubemap with the same
+ * settings.
+ *
+ * @throw abcg::RuntimeError if the faces are not square images of the same
+ * size.
+ *
+ * @return ID of the texture, as generated by glGenTextures.
+ */
+GLuint
+abcg::uploadOpenGLCubemap(OpenGLCubemapCreateInfo const &createInfo,
+                          std::array<SurfacePtr, 6> const &faces) {
+  auto const size{faces.front()->w};
+  if (std::ranges::any_of(faces, [size](auto const &face) {
+        return face->w != size || face->h != size;
+      })) {
+    throw abcg::RuntimeError(
+        "Cubemap faces must be square images of the same size");
+  }
+
   GLuint textureID{};
   glGenTextures(1, &textureID);
   glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
-  for (auto &&[index, path] : iter::enumerate(createInfo.paths)) {
-    // Load the bitmap
-    if (SDL_Surface *const surface{IMG_Load(path.data())}) {
-      // Enforce RGB
-      SDL_Surface *const formattedSurface{
-          SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB24, 0)};
-      SDL_FreeSurface(surface);
-
-      auto target{GL_TEXTURE_CUBE_MAP_POSITIVE_X + gsl::narrow<GLenum>(index)};
-
-      // LHS to RHS
-      if (createInfo.rightHandedSystem) {
-        if (target == GL_TEXTURE_CUBE_MAP_POSITIVE_Y ||
-            target == GL_TEXTURE_CUBE_MAP_NEGATIVE_Y) {
-          // Flip upside down
-          flipVertically(*formattedSurface);
-        } else {
-          flipHorizontally(*formattedSurface);
-        }
-
-        // Swap -z and +z
-        if (target == GL_TEXTURE_CUBE_MAP_POSITIVE_Z)
-          target = GL_TEXTURE_CUBE_MAP_NEGATIVE_Z;
-        else if (target == GL_TEXTURE_CUBE_MAP_NEGATIVE_Z)
-          target = GL_TEXTURE_CUBE_MAP_POSITIVE_Z;
-      }
+  auto const useTextureStorage{hasTextureStorage()};
+  if (useTextureStorage) {
+    // Allocate all faces and levels at once
+    auto const levels{createInfo.generateMipmaps
+                          ? gsl::narrow<GLsizei>(std::bit_width(
+                                gsl::narrow<unsigned int>(size)))
+                          : 1};
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, levels, GL_RGB8, size, size);
+  }
 
-      // Create texture
-      glTexImage2D(target, 0, GL_RGB, formattedSurface->w, formattedSurface->h,
-                   0, GL_RGB, GL_UNSIGNED_BYTE, formattedSurface->pixels);
+  for (auto &&[index, face] : iter::enumerate(faces)) {
+    auto const target{GL_TEXTURE_CUBE_MAP_POSITIVE_X +
+                      gsl::narrow<GLenum>(index)};
 
-      SDL_FreeSurface(formattedSurface);
+    // Upload texture
+    if (useTextureStorage) {
+      glTexSubImage2D(target, 0, 0, 0, size, size, GL_RGB, GL_UNSIGNED_BYTE,
+                      face->pixels);
     } else {
-      throw abcg::RuntimeError(
-          fmt::format("Failed to load texture file {}", path));
+      glTexImage2D(target, 0, GL_RGB, size, size, 0, GL_RGB,
+                   GL_UNSIGNED_BYTE, face->pixels);
     }
   }
 
@@ -160,4 +409,4 @@ GLuint abcg::loadOpenGLCubemap(OpenGLCubemapCreateInfo const &createInfo) {
   }
 
   return textureID;
-}
\ No newline at end of file
+}
@@ -11,7 +11,9 @@
 #ifndef ABCG_OPENGL_IMAGE_HPP_
 #define ABCG_OPENGL_IMAGE_HPP_
 
+#include "abcgImage.hpp"
 #include "abcgOpenGLExternal.hpp"
+#include "abcgOpenGLUploadRing.hpp"
 
 #include <array>
 #include <string_view>
@@ -19,11 +21,23 @@
 namespace abcg {
 struct OpenGLTextureCreateInfo;
 struct OpenGLCubemapCreateInfo;
+struct OpenGLDecodedTexture;
 
 [[nodiscard]] GLuint
 loadOpenGLTexture(OpenGLTextureCreateInfo const &createInfo);
 [[nodiscard]] GLuint
 loadOpenGLCubemap(OpenGLCubemapCreateInfo const &createInfo);
+
+[[nodiscard]] OpenGLDecodedTexture
+decodeOpenGLTexture(OpenGLTextureCreateInfo const &createInfo);
+[[nodiscard]] std::array<SurfacePtr, 6>
+decodeOpenGLCubemap(OpenGLCubemapCreateInfo const &createInfo);
+[[nodiscard]] GLuint
+uploadOpenGLTexture(OpenGLTextureCreateInfo const &createInfo,
+                    OpenGLDecodedTexture const &decoded);
+[[nodiscard]] GLuint
+uploadOpenGLCubemap(OpenGLCubemapCreateInfo const &createInfo,
+                    std::array<SurfacePtr, 6> const &faces);
 } // namespace abcg
 
 /**
@@ -39,6 +53,11 @@ struct abcg::OpenGLTextureCreateInfo {
   /** @brief Whether to apply gamma decoding (expansion) to convert an image in
    * sRGB space to linear space. */
   bool sRGBToLinear{false};
+  /** @brief Ring of pixel unpack buffers used to stream the upload, or
+   * `nullptr` to upload from client memory.
+   *
+   * @sa abcg::OpenGLWindow::getUploadRing. */
+  OpenGLUploadRing *uploadRing{};
 };
 
 /**
@@ -55,4 +74,16 @@ struct abcg::OpenGLCubemapCreateInfo {
   bool rightHandedSystem{true};
 };
 
+/**
+ * @brief Image of a 2D texture decoded by abcg::decodeOpenGLTexture.
+ */
+struct abcg::OpenGLDecodedTexture {
+  /** @brief Surface with the pixels, already flipped if requested. */
+  SurfacePtr surface{};
+  /** @brief Internal format of the texture. */
+  GLenum internalFormat{};
+  /** @brief Format of the pixel data. */
+  GLenum format{};
+};
+
 #endif
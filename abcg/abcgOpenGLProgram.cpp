@@ -0,0 +1,398 @@
+/**
+ * @file abcgOpenGLProgram.cpp
+ * @brief Definition of abcg::OpenGLProgram members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLProgram.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <bit>
+
+#include "abcgException.hpp"
+#include "abcgExternal.hpp"
+#include "abcgOpenGLFunction.hpp"
+#include "abcgOpenGLShader.hpp"
+#include "abcgUtil.hpp"
+
+namespace {
+// Returns the name of an active resource from a query that writes it into a
+// buffer of at least maxLength characters
+template <typename TQuery>
+[[nodiscard]] std::string queryName(GLint maxLength, TQuery &&query) {
+  std::string name(gsl::narrow<std::size_t>(std::max(maxLength, 1)), '\0');
+  GLsizei length{};
+  std::forward<TQuery>(query)(gsl::narrow<GLsizei>(name.size()), &length,
+                              name.data());
+  name.resize(gsl::narrow<std::size_t>(std::max(length, 0)));
+  return name;
+}
+
+// Strips the "[0]" suffix that is appended to the name of arrays
+[[nodiscard]] std::string_view arrayBaseName(std::string_view name) {
+  if (name.ends_with("[0]")) {
+    name.remove_suffix(3);
+  }
+  return name;
+}
+} // namespace
+
+template <typename T>
+void abcg::OpenGLProgram::Table<T>::build(
+    std::vector<std::pair<std::string, T>> entries) {
+  m_slots.clear();
+  if (entries.empty()) {
+    return;
+  }
+
+  // Keep the load factor at or below 1/2
+  m_slots.resize(std::bit_ceil(entries.size() * 2));
+  auto const mask{m_slots.size() - 1};
+  for (auto &[name, value] : entries) {
+    auto const hash{hashFNV1a(name)};
+    for (auto index{hash & mask};; index = (index + 1) & mask) {
+      auto &slot{m_slots[index]};
+      if (slot.name.empty()) {
+        slot = {.hash = hash, .name = std::move(name), .value = value};
+        break;
+      }
+      if (slot.hash == hash && slot.name == name) {
+        break;
+      }
+    }
+  }
+}
+
+template <typename T>
+T const *abcg::OpenGLProgram::Table<T>::find(std::string_view name) const {
+  if (m_slots.empty() || name.empty()) {
+    return nullptr;
+  }
+
+  auto const mask{m_slots.size() - 1};
+  auto const hash{hashFNV1a(name)};
+  for (auto index{hash & mask};; index = (index + 1) & mask) {
+    auto const &slot{m_slots[index]};
+    if (slot.name.empty()) {
+      return nullptr;
+    }
+    if (slot.hash == hash && slot.name == name) {
+      return &slot.value;
+    }
+  }
+}
+
+/**
+ * @brief Builds a program from shader paths or sources and reflects it.
+ *
+ * @param pathsOrSources Paths or source codes of the shaders, as in
+ * abcg::createOpenGLProgram.
+ *
+ * @throw abcg::RuntimeError if the program could not be built.
+ */
+void abcg::OpenGLProgram::create(
+    std::vector<ShaderSource> const &pathsOrSources) {
+  create(createOpenGLProgram(pathsOrSources));
+}
+
+/**
+ * @brief Takes ownership of a linked program object and reflects it.
+ *
+ * Use this for programs built with abcg::OpenGLShaderCompileQueue or
+ * abcg::triggerOpenGLShaderLink. The program previously held, if any, is not
+ * deleted.
+ *
+ * @param program Name of a successfully linked program object.
+ */
+void abcg::OpenGLProgram::create(GLuint program) {
+  m_program = program;
+  reflect();
+}
+
+/**
+ * @brief Deletes the program object.
+ */
+void abcg::OpenGLProgram::destroy() {
+  abcg::glDeleteProgram(m_program);
+  m_program = 0;
+  m_uniforms = {};
+  m_uniformBlocks = {};
+  m_attributes = {};
+}
+
+/**
+ * @brief Conversion to GLuint.
+ *
+ * @return Name of the program object.
+ */
+abcg::OpenGLProgram::operator GLuint() const noexcept { return m_program; }
+
+/**
+ * @brief Installs the program as part of the current rendering state.
+ */
+void abcg::OpenGLProgram::use() const { abcg::glUseProgram(m_program); }
+
+/**
+ * @brief Returns the location of an active uniform variable.
+ *
+ * @param name Name of the uniform variable.
+ *
+ * @return Location of the uniform variable, or -1 if `name` is not an active
+ * uniform variable of the default uniform block.
+ */
+GLint abcg::OpenGLProgram::getUniformLocation(std::string_view name) const {
+  auto const *uniform{m_uniforms.find(name)};
+  return uniform == nullptr ? -1 : uniform->location;
+}
+
+/**
+ * @brief Returns the location of an active vertex attribute.
+ *
+ * @param name Name of the attribute.
+ *
+ * @return Location of the attribute, or -1 if `name` is not an active
+ * attribute.
+ */
+GLint abcg::OpenGLProgram::getAttributeLocation(std::string_view name) const {
+  auto const *attribute{m_attributes.find(name)};
+  return attribute == nullptr ? -1 : attribute->location;
+}
+
+/**
+ * @brief Returns the index of an active uniform block.
+ *
+ * @param name Name of the uniform block.
+ *
+ * @return Index of the uniform block, or `GL_INVALID_INDEX` if `name` is not
+ * an active uniform block.
+ */
+GLuint abcg::OpenGLProgram::getUniformBlockIndex(std::string_view name) const {
+  auto const *block{m_uniformBlocks.find(name)};
+  return block == nullptr ? GL_INVALID_INDEX : block->index;
+}
+
+/**
+ * @brief Returns the reflection of an active uniform variable.
+ *
+ * @param name Name of the uniform variable.
+ *
+ * @return Pointer to the reflection, or `nullptr` if not found.
+ */
+abcg::OpenGLUniformInfo const *
+abcg::OpenGLProgram::findUniform(std::string_view name) const {
+  return m_uniforms.find(name);
+}
+
+/**
+ * @brief Returns the reflection of an active uniform block.
+ *
+ * @param name Name of the uniform block.
+ *
+ * @return Pointer to the reflection, or `nullptr` if not found.
+ */
+abcg::OpenGLUniformBlockInfo const *
+abcg::OpenGLProgram::findUniformBlock(std::string_view name) const {
+  return m_uniformBlocks.find(name);
+}
+
+/**
+ * @brief Returns the reflection of an active vertex attribute.
+ *
+ * @param name Name of the attribute.
+ *
+ * @return Pointer to the reflection, or `nullptr` if not found.
+ */
+abcg::OpenGLAttributeInfo const *
+abcg::OpenGLProgram::findAttribute(std::string_view name) const {
+  return m_attributes.find(name);
+}
+
+/**
+ * @brief Assigns a binding point to a uniform block.
+ *
+ * @param blockIndex Index of the uniform block, as returned by
+ * abcg::OpenGLProgram::getUniformBlockIndex.
+ * @param binding Uniform buffer binding point.
+ */
+void abcg::OpenGLProgram::setUniformBlockBinding(GLuint blockIndex,
+                                                 GLuint binding) const {
+  abcg::glUniformBlockBinding(m_program, blockIndex, binding);
+}
+
+/**
+ * @brief Sets the value of a uniform variable of the program in use.
+ *
+ * The program must be in use. The value is set through the `abcg::gl*`
+ * wrappers, so redundant uploads are elided when abcg::OpenGLStateCache is
+ * enabled.
+ *
+ * @param location Location of the uniform variable, as returned by
+ * abcg::OpenGLProgram::getUniformLocation. Locations equal to -1 are
+ * ignored.
+ * @param value Value of the uniform variable.
+ */
+void abcg::OpenGLProgram::setUniform(GLint location, GLfloat value) const {
+  abcg::glUniform1f(location, value);
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location, GLint value) const {
+  abcg::glUniform1i(location, value);
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location, GLuint value) const {
+  abcg::glUniform1ui(location, value);
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location,
+                                     glm::vec2 const &value) const {
+  abcg::glUniform2fv(location, 1, glm::value_ptr(value));
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location,
+                                     glm::vec3 const &value) const {
+  abcg::glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location,
+                                     glm::vec4 const &value) const {
+  abcg::glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location,
+                                     glm::ivec2 const &value) const {
+  abcg::glUniform2iv(location, 1, glm::value_ptr(value));
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location,
+                                     glm::ivec3 const &value) const {
+  abcg::glUniform3iv(location, 1, glm::value_ptr(value));
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location,
+                                     glm::ivec4 const &value) const {
+  abcg::glUniform4iv(location, 1, glm::value_ptr(value));
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location,
+                                     glm::mat2 const &value) const {
+  abcg::glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location,
+                                     glm::mat3 const &value) const {
+  abcg::glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+/** @copydoc setUniform(GLint, GLfloat) const */
+void abcg::OpenGLProgram::setUniform(GLint location,
+                                     glm::mat4 const &value) const {
+  abcg::glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+// Queries the active uniforms, uniform blocks and attributes of the program
+void abcg::OpenGLProgram::reflect() {
+  auto const getProgramiv{[this](GLenum pname) {
+    GLint value{};
+    glGetProgramiv(m_program, pname, &value);
+    return value;
+  }};
+
+  // Uniforms of the default block. Uniforms in named blocks have no location
+  std::vector<std::pair<std::string, OpenGLUniformInfo>> uniforms;
+  auto const uniformCount{getProgramiv(GL_ACTIVE_UNIFORMS)};
+  auto const uniformMaxLength{getProgramiv(GL_ACTIVE_UNIFORM_MAX_LENGTH)};
+  for (GLint index{}; index < uniformCount; ++index) {
+    GLint size{};
+    GLenum type{};
+    auto name{queryName(uniformMaxLength, [&](GLsizei bufSize,
+                                              GLsizei *length, GLchar *data) {
+      glGetActiveUniform(m_program, gsl::narrow<GLuint>(index), bufSize,
+                         length, &size, &type, data);
+    })};
+    auto const location{glGetUniformLocation(m_program, name.c_str())};
+    if (location < 0) {
+      continue;
+    }
+
+    if (auto const baseName{arrayBaseName(name)}; baseName != name) {
+      // Array elements may not have consecutive locations
+      for (GLint element{1}; element < size; ++element) {
+        auto elementName{fmt::format("{}[{}]", baseName, element)};
+        auto const elementLocation{
+            glGetUniformLocation(m_program, elementName.c_str())};
+        uniforms.emplace_back(std::move(elementName),
+                              OpenGLUniformInfo{.location = elementLocation,
+                                                .type = type,
+                                                .size = 1});
+      }
+      uniforms.emplace_back(
+          std::string{baseName},
+          OpenGLUniformInfo{.location = location, .type = type, .size = size});
+    }
+    uniforms.emplace_back(
+        std::move(name),
+        OpenGLUniformInfo{.location = location, .type = type, .size = size});
+  }
+  m_uniforms.build(std::move(uniforms));
+
+  std::vector<std::pair<std::string, OpenGLUniformBlockInfo>> blocks;
+  auto const blockCount{getProgramiv(GL_ACTIVE_UNIFORM_BLOCKS)};
+  auto const blockMaxLength{
+      getProgramiv(GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH)};
+  for (GLint index{}; index < blockCount; ++index) {
+    auto const blockIndex{gsl::narrow<GLuint>(index)};
+    auto name{queryName(blockMaxLength, [&](GLsizei bufSize, GLsizei *length,
+                                            GLchar *data) {
+      glGetActiveUniformBlockName(m_program, blockIndex, bufSize, length,
+                                  data);
+    })};
+    GLint dataSize{};
+    glGetActiveUniformBlockiv(m_program, blockIndex,
+                              GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+    blocks.emplace_back(std::move(name),
+                        OpenGLUniformBlockInfo{.index = blockIndex,
+                                               .dataSize = dataSize});
+  }
+  m_uniformBlocks.build(std::move(blocks));
+
+  // Built-in attributes such as gl_VertexID have no location
+  std::vector<std::pair<std::string, OpenGLAttributeInfo>> attributes;
+  auto const attributeCount{getProgramiv(GL_ACTIVE_ATTRIBUTES)};
+  auto const attributeMaxLength{
+      getProgramiv(GL_ACTIVE_ATTRIBUTE_MAX_LENGTH)};
+  for (GLint index{}; index < attributeCount; ++index) {
+    GLint size{};
+    GLenum type{};
+    auto name{queryName(attributeMaxLength, [&](GLsizei bufSize,
+                                                GLsizei *length,
+                                                GLchar *data) {
+      glGetActiveAttrib(m_program, gsl::narrow<GLuint>(index), bufSize,
+                        length, &size, &type, data);
+    })};
+    auto const location{glGetAttribLocation(m_program, name.c_str())};
+    if (location < 0) {
+      continue;
+    }
+    attributes.emplace_back(
+        std::move(name),
+        OpenGLAttributeInfo{.location = location, .type = type, .size = size});
+  }
+  m_attributes.build(std::move(attributes));
+}
@@ -0,0 +1,144 @@
+/**
+ * @file abcgOpenGLProgram.hpp
+ * @brief Header file of abcg::OpenGLProgram.
+ *
+ * Declaration of abcg::OpenGLProgram and related structures.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_PROGRAM_HPP_
+#define ABCG_OPENGL_PROGRAM_HPP_
+
+#include "abcgOpenGLExternal.hpp"
+#include "abcgShader.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace abcg {
+struct OpenGLUniformInfo;
+struct OpenGLUniformBlockInfo;
+struct OpenGLAttributeInfo;
+class OpenGLProgram;
+} // namespace abcg
+
+/**
+ * @brief Reflection of an active uniform variable of a program.
+ */
+struct abcg::OpenGLUniformInfo {
+  /** @brief Location of the uniform variable. */
+  GLint location{-1};
+  /** @brief Data type (e.g., `GL_FLOAT_MAT4`). */
+  GLenum type{};
+  /** @brief Number of array elements, or 1 if not an array. */
+  GLint size{};
+};
+
+/**
+ * @brief Reflection of an active uniform block of a program.
+ */
+struct abcg::OpenGLUniformBlockInfo {
+  /** @brief Index of the uniform block. */
+  GLuint index{GL_INVALID_INDEX};
+  /** @brief Minimum size of the buffer bound to the block, in bytes. */
+  GLint dataSize{};
+};
+
+/**
+ * @brief Reflection of an active vertex attribute of a program.
+ */
+struct abcg::OpenGLAttributeInfo {
+  /** @brief Location of the attribute. */
+  GLint location{-1};
+  /** @brief Data type (e.g., `GL_FLOAT_VEC3`). */
+  GLenum type{};
+  /** @brief Number of array elements, or 1 if not an array. */
+  GLint size{};
+};
+
+/**
+ * @brief A class for representing an OpenGL program object.
+ *
+ * The active uniform variables, uniform blocks and vertex attributes of the
+ * program are queried once, when the program is created, and stored in flat
+ * hash tables. Lookups by name do not call the OpenGL API.
+ *
+ * Uniform locations should be looked up once, after creation, and then
+ * passed to the typed abcg::OpenGLProgram::setUniform overloads, so that
+ * no string is compared or hashed while rendering. Elements of uniform arrays
+ * can be looked up as `name`, `name[0]`, `name[1]`, etc.
+ *
+ * @remark Objects of this type are handles: copies refer to the same program
+ * object, which is deleted with abcg::OpenGLProgram::destroy.
+ */
+class abcg::OpenGLProgram {
+public:
+  void create(std::vector<ShaderSource> const &pathsOrSources);
+  void create(GLuint program);
+  void destroy();
+
+  explicit operator GLuint() const noexcept;
+
+  void use() const;
+
+  [[nodiscard]] GLint getUniformLocation(std::string_view name) const;
+  [[nodiscard]] GLint getAttributeLocation(std::string_view name) const;
+  [[nodiscard]] GLuint getUniformBlockIndex(std::string_view name) const;
+
+  [[nodiscard]] OpenGLUniformInfo const *
+  findUniform(std::string_view name) const;
+  [[nodiscard]] OpenGLUniformBlockInfo const *
+  findUniformBlock(std::string_view name) const;
+  [[nodiscard]] OpenGLAttributeInfo const *
+  findAttribute(std::string_view name) const;
+
+  void setUniformBlockBinding(GLuint blockIndex, GLuint binding) const;
+
+  void setUniform(GLint location, GLfloat value) const;
+  void setUniform(GLint location, GLint value) const;
+  void setUniform(GLint location, GLuint value) const;
+  void setUniform(GLint location, glm::vec2 const &value) const;
+  void setUniform(GLint location, glm::vec3 const &value) const;
+  void setUniform(GLint location, glm::vec4 const &value) const;
+  void setUniform(GLint location, glm::ivec2 const &value) const;
+  void setUniform(GLint location, glm::ivec3 const &value) const;
+  void setUniform(GLint location, glm::ivec4 const &value) const;
+  void setUniform(GLint location, glm::mat2 const &value) const;
+  void setUniform(GLint location, glm::mat3 const &value) const;
+  void setUniform(GLint location, glm::mat4 const &value) const;
+
+private:
+  // Open addressing table with linear probing, keyed by the FNV-1a hash of
+  // the name. Empty slots have empty names.
+  template <typename T> class Table {
+  public:
+    void build(std::vector<std::pair<std::string, T>> entries);
+    [[nodiscard]] T const *find(std::string_view name) const;
+
+  private:
+    struct Slot {
+      std::uint64_t hash{};
+      std::string name;
+      T value{};
+    };
+    std::vector<Slot> m_slots;
+  };
+
+  void reflect();
+
+  GLuint m_program{};
+  Table<OpenGLUniformInfo> m_uniforms;
+  Table<OpenGLUniformBlockInfo> m_uniformBlocks;
+  Table<OpenGLAttributeInfo> m_attributes;
+};
+
+#endif
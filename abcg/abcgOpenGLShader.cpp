@@ -14,13 +14,17 @@
 #include <fmt/core.h>
 #include <gsl/gsl>
 
+#include <array>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <limits>
 #include <regex>
 #include <sstream>
 #include <vector>
 
 #include "abcgException.hpp"
+#include "abcgUtil.hpp"
 
 namespace {
 void printShaderInfoLog(GLuint const shader, std::string_view prefix) {
@@ -96,21 +100,27 @@ void printProgramInfoLog(GLuint const program) {
   return source.str();
 }
 
-// Compiles a shader and returns immediately (i.e. don't wait until completion).
-// Returns the shader ID of the compiled shader.
-[[nodiscard]] abcg::OpenGLShader compileHelper(std::string_view shaderSource,
-                                               GLuint shaderStage) {
+// Returns the shader source code as it will be passed to glShaderSource.
+[[nodiscard]] std::string preprocessHelper(std::string_view shaderSource) {
   std::string source{shaderSource};
 #if !defined(__EMSCRIPTEN__) && defined(__APPLE__)
   // Remove version header, if any
-  source = std::regex_replace(source, std::regex(R"(^\s*#\s*version\s+\d+\s+es\s*)"), "");
+  source = std::regex_replace(
+      source, std::regex(R"(^\s*#\s*version\s+\d+\s+es\s*)"), "");
   if (source != shaderSource)
   {
     // Add new header
     source = "#version 410\n" + source;
   }
 #endif
+  return source;
+}
 
+// Compiles a shader and returns immediately (i.e. don't wait until completion).
+// Returns the shader ID of the compiled shader.
+[[nodiscard]] abcg::OpenGLShader compileHelper(std::string_view shaderSource,
+                                               GLuint shaderStage) {
+  std::string const source{shaderSource};
   auto shaderID{glCreateShader(shaderStage)};
   auto const *sourceCStr{source.c_str()};
   glShaderSource(shaderID, 1, &sourceCStr, nullptr);
@@ -153,8 +163,220 @@ void deleteShaders(std::vector<abcg::OpenGLShader> const &shaderIDs) {
     throw abcg::RuntimeError("Unknown shader stage");
   }
 }
+
+// Directory of the program binary cache. Empty if the cache is disabled.
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::string programCacheDirectory;
+
+// Header of a program binary cache entry. The entry is laid out as the header,
+// followed by `infoLength` bytes of the driver identification string, followed
+// by `binaryLength` bytes of the program binary.
+struct ProgramCacheHeader {
+  std::array<char, 8> magic{'A', 'B', 'C', 'G', 'P', 'R', 'O', 'G'};
+  std::uint32_t version{1};
+  std::uint32_t binaryFormat{};
+  std::uint64_t key{};
+  std::uint32_t infoLength{};
+  std::uint32_t binaryLength{};
+};
+
+// Returns a string identifying the current OpenGL driver. Cache entries built
+// with a different string are considered stale.
+[[nodiscard]] std::string driverInfo() {
+  auto const toString{[](GLenum name) {
+    auto const *str{reinterpret_cast<char const *>(glGetString(name))};
+    return std::string{str != nullptr ? str : ""};
+  }};
+  return toString(GL_VENDOR) + "\n" + toString(GL_RENDERER) + "\n" +
+         toString(GL_VERSION);
+}
+
+// Returns the cache key of a program built from the given (already
+// preprocessed) shader sources.
+[[nodiscard]] std::uint64_t
+programCacheKey(std::vector<abcg::ShaderSource> const &sources,
+                std::string_view info) {
+  auto hash{abcg::fnv1aOffsetBasis};
+  for (auto const &source : sources) {
+    hash =
+        abcg::hashFNV1a(std::to_string(static_cast<int>(source.stage)), hash);
+    hash = abcg::hashFNV1a(std::string_view{"\0", 1}, hash);
+    hash = abcg::hashFNV1a(source.source, hash);
+    hash = abcg::hashFNV1a(std::string_view{"\0", 1}, hash);
+  }
+  return abcg::hashFNV1a(info, hash);
+}
+
+[[nodiscard]] std::filesystem::path programCachePath(std::uint64_t key) {
+  return std::filesystem::path{programCacheDirectory} /
+         fmt::format("{:016x}.glprog", key);
+}
+
+[[nodiscard]] bool isProgramCacheSupported() {
+#if defined(__EMSCRIPTEN__)
+  // WebGL does not support program binaries
+  return false;
+#else
+  GLint numFormats{};
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  return numFormats > 0;
+#endif
+}
+
+// Creates a program from a cache entry. Returns 0 if there is no entry for the
+// key. Invalid or stale entries are removed.
+[[nodiscard]] GLuint loadCachedProgram(std::uint64_t key,
+                                       std::string_view info) {
+  auto const path{programCachePath(key)};
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream) {
+    return 0U;
+  }
+
+  std::error_code sizeError;
+  auto const fileSize{std::filesystem::file_size(path, sizeError)};
+
+  auto const discard{[&stream, &path]() {
+    stream.close();
+    std::error_code errorCode;
+    std::filesystem::remove(path, errorCode);
+    return 0U;
+  }};
+
+  ProgramCacheHeader header{};
+  ProgramCacheHeader const expected{};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!stream || header.magic != expected.magic ||
+      header.version != expected.version || header.key != key ||
+      header.infoLength != info.size()) {
+    return discard();
+  }
+
+  // Check the lengths against the file size before allocating, as a
+  // truncated or corrupt entry could request gigabytes
+  if (sizeError || header.binaryLength == 0 ||
+      header.binaryLength >
+          static_cast<std::uint32_t>(std::numeric_limits<GLsizei>::max()) ||
+      fileSize != sizeof(header) + std::uintmax_t{header.infoLength} +
+                      header.binaryLength) {
+    return discard();
+  }
+
+  std::string storedInfo(header.infoLength, '\0');
+  stream.read(storedInfo.data(),
+              gsl::narrow<std::streamsize>(storedInfo.size()));
+  if (!stream || storedInfo != info) {
+    return discard();
+  }
+
+  std::vector<char> binary(header.binaryLength);
+  stream.read(binary.data(), gsl::narrow<std::streamsize>(binary.size()));
+  if (!stream || binary.empty()) {
+    return discard();
+  }
+
+  auto const program{glCreateProgram()};
+  if (program == 0) {
+    return 0U;
+  }
+  glProgramBinary(program, header.binaryFormat, binary.data(),
+                  gsl::narrow<GLsizei>(binary.size()));
+
+  // The driver rejects binaries that are no longer compatible
+  GLint linkStatus{};
+  glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+  if (linkStatus == GL_FALSE) {
+    glDeleteProgram(program);
+    return discard();
+  }
+
+  return program;
+}
+
+// Writes the binary of a linked program to the cache. Failures are ignored.
+void storeCachedProgram(GLuint program, std::uint64_t key,
+                        std::string_view info) {
+  GLint binaryLength{};
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+  if (binaryLength <= 0) {
+    return;
+  }
+
+  std::vector<char> binary(gsl::narrow<std::size_t>(binaryLength));
+  GLenum binaryFormat{};
+  GLsizei length{};
+  glGetProgramBinary(program, binaryLength, &length, &binaryFormat,
+                     binary.data());
+  if (length <= 0) {
+    return;
+  }
+
+  ProgramCacheHeader const header{
+      .binaryFormat = binaryFormat,
+      .key = key,
+      .infoLength = gsl::narrow<std::uint32_t>(info.size()),
+      .binaryLength = gsl::narrow<std::uint32_t>(length)};
+
+  std::error_code errorCode;
+  std::filesystem::create_directories(programCacheDirectory, errorCode);
+
+  // Write to a temporary file first so that readers never see a partial entry
+  auto const path{programCachePath(key)};
+  auto tempPath{path};
+  tempPath += ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    stream.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    stream.write(info.data(), gsl::narrow<std::streamsize>(info.size()));
+    stream.write(binary.data(), length);
+    if (!stream) {
+      stream.close();
+      std::filesystem::remove(tempPath, errorCode);
+      return;
+    }
+  }
+  std::filesystem::rename(tempPath, path, errorCode);
+  if (errorCode) {
+    std::filesystem::remove(tempPath, errorCode);
+  }
+}
 } // namespace
 
+/**
+ * @brief Enables or disables the on-disk program binary cache used by
+ * abcg::createOpenGLProgram.
+ *
+ * When enabled, programs are stored with `glGetProgramBinary` after being
+ * linked, and are restored with `glProgramBinary` on subsequent calls with the
+ * same shader sources. Entries are keyed by a hash of the preprocessed shader
+ * sources and the OpenGL vendor, renderer and version strings. Entries that are
+ * stale or rejected by the driver are removed and rebuilt.
+ *
+ * The cache is disabled by default. It has no effect if the OpenGL context
+ * does not support any program binary format (e.g., WebGL).
+ *
+ * @param directory Path to the directory where the cache entries will be
+ * stored. The directory is created if it does not exist. An empty string
+ * disables the cache.
+ */
+void abcg::setOpenGLProgramCacheDirectory(std::string_view directory) {
+  programCacheDirectory = directory;
+}
+
+/**
+ * @brief Returns the directory of the program binary cache.
+ *
+ * @return Path to the cache directory, or an empty string if the cache is
+ * disabled.
+ *
+ * @sa abcg::setOpenGLProgramCacheDirectory.
+ */
+std::string const &abcg::getOpenGLProgramCacheDirectory() noexcept {
+  return programCacheDirectory;
+}
+
 /**
  * @brief Creates a program object from a group of shader paths or source codes.
  *
@@ -167,6 +389,9 @@ void deleteShaders(std::vector<abcg::OpenGLShader> const &shaderIDs) {
  * failed, or if the linking has failed.
  *
  * @return ID of the program object, or 0 on error.
+ *
+ * @sa abcg::setOpenGLProgramCacheDirectory to reuse program binaries across
+ * runs.
  */
 GLuint
 abcg::createOpenGLProgram(std::vector<ShaderSource> const &pathsOrSources,
@@ -175,7 +400,21 @@ abcg::createOpenGLProgram(std::vector<ShaderSource> const &pathsOrSources,
   sources.reserve(pathsOrSources.size());
   for (auto const &pathOrSource : pathsOrSources) {
     sources.push_back(
-        {.source = toSource(pathOrSource.source), .stage = pathOrSource.stage});
+        {.source = preprocessHelper(toSource(pathOrSource.source)),
+         .stage = pathOrSource.stage});
+  }
+
+  // Try the program binary cache first
+  auto const useCache{!programCacheDirectory.empty() &&
+                      isProgramCacheSupported()};
+  std::string info;
+  std::uint64_t cacheKey{};
+  if (useCache) {
+    info = driverInfo();
+    cacheKey = programCacheKey(sources, info);
+    if (auto const program{loadCachedProgram(cacheKey, info)}; program != 0) {
+      return program;
+    }
   }
 
   std::vector<OpenGLShader> compiledShaders;
@@ -201,6 +440,13 @@ abcg::createOpenGLProgram(std::vector<ShaderSource> const &pathsOrSources,
     glAttachShader(shaderProgram, shader.shader);
   }
 
+#if !defined(__EMSCRIPTEN__)
+  if (useCache) {
+    glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                        GL_TRUE);
+  }
+#endif
+
   glLinkProgram(shaderProgram);
 
   for (auto const &shader : compiledShaders) {
@@ -221,6 +467,10 @@ abcg::createOpenGLProgram(std::vector<ShaderSource> const &pathsOrSources,
     return 0U;
   }
 
+  if (useCache) {
+    storeCachedProgram(shaderProgram, cacheKey, info);
+  }
+
   return shaderProgram;
 }
 
@@ -253,7 +503,8 @@ std::vector<abcg::OpenGLShader> abcg::triggerOpenGLShaderCompile(
   sources.reserve(pathsOrSources.size());
   for (auto const &pathOrSource : pathsOrSources) {
     sources.push_back(
-        {.source = toSource(pathOrSource.source), .stage = pathOrSource.stage});
+        {.source = preprocessHelper(toSource(pathOrSource.source)),
+         .stage = pathOrSource.stage});
   }
 
   std::vector<OpenGLShader> compiledShaders;
@@ -14,6 +14,8 @@
 #include "abcgOpenGLExternal.hpp"
 #include "abcgShader.hpp"
 
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace abcg {
@@ -41,6 +43,8 @@ bool checkOpenGLShaderCompile(std::vector<OpenGLShader> const &shaders,
 GLuint triggerOpenGLShaderLink(std::vector<OpenGLShader> const &shaders,
                                bool throwOnError = true);
 bool checkOpenGLShaderLink(GLuint shaderProgram, bool throwOnError = true);
+void setOpenGLProgramCacheDirectory(std::string_view directory);
+[[nodiscard]] std::string const &getOpenGLProgramCacheDirectory() noexcept;
 } // namespace abcg
 
 #endif
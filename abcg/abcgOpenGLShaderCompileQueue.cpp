@@ -0,0 +1,219 @@
+/**
+ * @file abcgOpenGLShaderCompileQueue.cpp
+ * @brief Definition of abcg::OpenGLShaderCompileQueue members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLShaderCompileQueue.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include "abcgException.hpp"
+
+#if !defined(GL_COMPLETION_STATUS_KHR)
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace {
+[[nodiscard]] bool hasParallelShaderCompile() {
+  GLint numExtensions{};
+  glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+  for (GLint index{}; index < numExtensions; ++index) {
+    auto const *name{reinterpret_cast<char const *>(
+        glGetStringi(GL_EXTENSIONS, gsl::narrow<GLuint>(index)))};
+    if (name != nullptr &&
+        (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0 ||
+         std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0)) {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace
+
+/**
+ * @brief Submits a program to be built.
+ *
+ * The shaders are read and their compilation is triggered immediately. The
+ * function returns without waiting for the compilation to finish.
+ *
+ * @param pathsOrSources Paths or source codes of the shaders of the program.
+ * @param onReady Function called from abcg::OpenGLShaderCompileQueue::poll
+ * with the ID of the program once it is linked.
+ * @param onError Function called from abcg::OpenGLShaderCompileQueue::poll
+ * if the program failed to compile or link. If empty, the error is thrown by
+ * abcg::OpenGLShaderCompileQueue::poll as an abcg::RuntimeError.
+ *
+ * @throw abcg::RuntimeError if a shader could not be read from file.
+ */
+void abcg::OpenGLShaderCompileQueue::submit(
+    std::vector<ShaderSource> const &pathsOrSources, ReadyCallback onReady,
+    ErrorCallback onError) {
+  Job job;
+  job.shaders = triggerOpenGLShaderCompile(pathsOrSources);
+  job.onReady = std::move(onReady);
+  job.onError = std::move(onError);
+  m_jobs.push_back(std::move(job));
+}
+
+/**
+ * @brief Advances the programs in the queue and calls the callbacks of the
+ * programs that are done.
+ *
+ * This must be called while the OpenGL context is current. Callbacks are
+ * called after the finished programs are removed from the queue, so they may
+ * submit new programs.
+ *
+ * @throw abcg::RuntimeError if a program failed to build and no error callback
+ * was given for it.
+ *
+ * @return Number of programs that finished building, with or without errors.
+ */
+std::size_t abcg::OpenGLShaderCompileQueue::poll() { return update(false); }
+
+/**
+ * @brief Waits until all programs in the queue are built and calls their
+ * callbacks.
+ *
+ * @throw abcg::RuntimeError if a program failed to build and no error callback
+ * was given for it.
+ */
+void abcg::OpenGLShaderCompileQueue::finish() {
+  while (!m_jobs.empty()) {
+    update(true);
+  }
+}
+
+/**
+ * @brief Discards all programs in the queue without calling their callbacks.
+ *
+ * The shader and program objects owned by the queue are deleted. This must be
+ * called while the OpenGL context is current.
+ */
+void abcg::OpenGLShaderCompileQueue::clear() {
+  for (auto const &job : m_jobs) {
+    for (auto const &shader : job.shaders) {
+      glDeleteShader(shader.shader);
+    }
+    if (job.program != 0) {
+      glDeleteProgram(job.program);
+    }
+  }
+  m_jobs.clear();
+}
+
+/**
+ * @brief Returns the number of programs that are still being built.
+ *
+ * @return Number of programs in the queue.
+ */
+std::size_t abcg::OpenGLShaderCompileQueue::getPendingCount() const noexcept {
+  return m_jobs.size();
+}
+
+/**
+ * @brief Returns whether the driver supports building programs in
+ * background threads.
+ *
+ * This must be called while the OpenGL context is current.
+ *
+ * @return `true` if `GL_KHR_parallel_shader_compile` (or the equivalent ARB
+ * extension) is supported; `false` otherwise.
+ */
+bool abcg::OpenGLShaderCompileQueue::isParallel() {
+  if (!m_parallel.has_value()) {
+    m_parallel = hasParallelShaderCompile();
+  }
+  return *m_parallel;
+}
+
+std::size_t abcg::OpenGLShaderCompileQueue::update(bool wait) {
+  auto const parallel{isParallel()};
+
+  std::size_t numDone{};
+  for (auto &job : m_jobs) {
+    // Without parallel compilation, checking a program stalls until the
+    // driver is done with it, so finish at most one program per poll
+    if (!wait && !parallel && numDone > 0) {
+      break;
+    }
+    while (!job.done && (wait || isComplete(job))) {
+      advance(job);
+    }
+    if (job.done) {
+      ++numDone;
+    }
+  }
+
+  std::vector<Job> done;
+  done.reserve(numDone);
+  auto const firstDone{std::stable_partition(
+      m_jobs.begin(), m_jobs.end(), [](Job const &job) { return !job.done; })};
+  std::move(firstDone, m_jobs.end(), std::back_inserter(done));
+  m_jobs.erase(firstDone, m_jobs.end());
+
+  std::optional<std::string> unhandledError;
+  for (auto &job : done) {
+    if (job.program != 0) {
+      if (job.onReady) {
+        job.onReady(job.program);
+      }
+    } else if (job.onError) {
+      job.onError(job.error);
+    } else if (!unhandledError.has_value()) {
+      unhandledError = std::move(job.error);
+    }
+  }
+  if (unhandledError.has_value()) {
+    throw abcg::RuntimeError(*unhandledError);
+  }
+
+  return done.size();
+}
+
+// Returns true if the current stage of the job (compile or link) can be
+// checked without blocking.
+bool abcg::OpenGLShaderCompileQueue::isComplete(Job const &job) {
+  if (!isParallel()) {
+    return true;
+  }
+
+  GLint status{};
+  if (job.program != 0) {
+    glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &status);
+    return status == GL_TRUE;
+  }
+  return std::ranges::all_of(job.shaders, [&status](auto const &shader) {
+    glGetShaderiv(shader.shader, GL_COMPLETION_STATUS_KHR, &status);
+    return status == GL_TRUE;
+  });
+}
+
+// Checks the current stage of the job and triggers the next one
+void abcg::OpenGLShaderCompileQueue::advance(Job &job) {
+  try {
+    if (job.program == 0) {
+      // The shaders are deleted by the check and link functions
+      auto const shaders{std::exchange(job.shaders, {})};
+      checkOpenGLShaderCompile(shaders);
+      job.program = triggerOpenGLShaderLink(shaders);
+      return;
+    }
+    checkOpenGLShaderLink(job.program);
+  } catch (abcg::Exception const &exception) {
+    // The program, if any, is deleted by checkOpenGLShaderLink
+    job.program = 0;
+    job.error = exception.what();
+  }
+  job.done = true;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file abcgOpenGLShaderCompileQueue.hpp
+ * @brief Header file of abcg::OpenGLShaderCompileQueue.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_SHADER_COMPILE_QUEUE_HPP_
+#define ABCG_OPENGL_SHADER_COMPILE_QUEUE_HPP_
+
+#include "abcgOpenGLShader.hpp"
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace abcg {
+class OpenGLShaderCompileQueue;
+} // namespace abcg
+
+/**
+ * @brief Builds OpenGL programs without blocking the render loop.
+ *
+ * Programs submitted to the queue have their shaders compiled right away with
+ * abcg::triggerOpenGLShaderCompile. Calls to
+ * abcg::OpenGLShaderCompileQueue::poll then advance each program through
+ * compilation and linking, and hand back linked programs through callbacks.
+ *
+ * If the `GL_KHR_parallel_shader_compile` extension is available, the driver
+ * compiles and links in background threads, and polling queries
+ * `GL_COMPLETION_STATUS_KHR` so that it never waits for a program that is not
+ * ready. Otherwise, each poll finishes at most one program, so that the cost
+ * of building many programs is spread across frames.
+ *
+ * abcg::OpenGLWindow owns a queue that is polled once per frame before
+ * abcg::OpenGLWindow::onPaint, and cleared after
+ * abcg::OpenGLWindow::onDestroy. Other queues must be cleared with
+ * abcg::OpenGLShaderCompileQueue::clear while the OpenGL context is current.
+ *
+ * @sa abcg::OpenGLWindow::getShaderCompileQueue.
+ *
+ * @remark Objects of this type cannot be copied or copy-constructed.
+ */
+class abcg::OpenGLShaderCompileQueue {
+public:
+  /** @brief Function called with the ID of a successfully linked program. The
+   * callee takes ownership of the program. */
+  using ReadyCallback = std::function<void(GLuint program)>;
+  /** @brief Function called with the error message of a program that failed to
+   * compile or link. */
+  using ErrorCallback = std::function<void(std::string_view what)>;
+
+  OpenGLShaderCompileQueue() = default;
+  OpenGLShaderCompileQueue(OpenGLShaderCompileQueue const &) = delete;
+  OpenGLShaderCompileQueue(OpenGLShaderCompileQueue &&) noexcept = default;
+  OpenGLShaderCompileQueue &
+  operator=(OpenGLShaderCompileQueue const &) = delete;
+  OpenGLShaderCompileQueue &
+  operator=(OpenGLShaderCompileQueue &&) noexcept = default;
+  ~OpenGLShaderCompileQueue() = default;
+
+  void submit(std::vector<ShaderSource> const &pathsOrSources,
+              ReadyCallback onReady, ErrorCallback onError = {});
+  std::size_t poll();
+  void finish();
+  void clear();
+
+  [[nodiscard]] std::size_t getPendingCount() const noexcept;
+  [[nodiscard]] bool isParallel();
+
+private:
+  struct Job {
+    std::vector<OpenGLShader> shaders;
+    GLuint program{};
+    ReadyCallback onReady;
+    ErrorCallback onError;
+    std::string error;
+    bool done{};
+  };
+
+  std::size_t update(bool wait);
+  [[nodiscard]] bool isComplete(Job const &job);
+  void advance(Job &job);
+
+  std::vector<Job> m_jobs;
+  // Whether GL_KHR_parallel_shader_compile is supported. Queried on first use
+  // since the queue may be created before the OpenGL context.
+  std::optional<bool> m_parallel;
+};
+
+#endif
@@ -0,0 +1,283 @@
+/**
+ * @file abcgOpenGLStateCache.cpp
+ * @brief Definition of abcg::OpenGLStateCache members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLStateCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief Returns the state cache used by the `abcg::gl*` wrappers.
+ *
+ * @return Reference to the state cache of the OpenGL context.
+ */
+abcg::OpenGLStateCache &abcg::getOpenGLStateCache() {
+  static OpenGLStateCache cache;
+  return cache;
+}
+
+/**
+ * @brief Enables or disables the cache.
+ *
+ * All tracked state is forgotten.
+ *
+ * @param enabled Whether the `abcg::gl*` wrappers should consult the cache.
+ */
+void abcg::OpenGLStateCache::setEnabled(bool enabled) {
+  m_enabled = enabled;
+  clear();
+  m_statistics = {};
+  m_frameStatistics = {};
+}
+
+/**
+ * @brief Starts counting the calls elided in a new frame.
+ *
+ * The tracked bindings and capabilities are invalidated, as they may have
+ * been changed by direct OpenGL calls since the last frame.
+ */
+void abcg::OpenGLStateCache::beginFrame() noexcept {
+  invalidate();
+  m_statistics = {};
+}
+
+/**
+ * @brief Finishes counting the calls elided in the current frame.
+ *
+ * @sa abcg::OpenGLStateCache::getFrameStatistics.
+ */
+void abcg::OpenGLStateCache::endFrame() noexcept {
+  m_frameStatistics = m_statistics;
+}
+
+/**
+ * @brief Returns the number of calls elided in the last frame.
+ *
+ * @return Statistics of the calls elided between the last calls to
+ * abcg::OpenGLStateCache::beginFrame and abcg::OpenGLStateCache::endFrame.
+ */
+abcg::OpenGLStateCacheStatistics const &
+abcg::OpenGLStateCache::getFrameStatistics() const noexcept {
+  return m_frameStatistics;
+}
+
+/**
+ * @brief Forgets the tracked bindings and capabilities.
+ *
+ * Call this after changing the bindings or capabilities through direct
+ * OpenGL calls. The next call that sets each state is always issued.
+ */
+void abcg::OpenGLStateCache::invalidate() noexcept {
+  m_vertexArray.reset();
+  m_arrayBuffer.reset();
+  m_program.reset();
+  m_elementBuffers.clear();
+  m_capabilities.clear();
+}
+
+/**
+ * @brief Forgets all tracked state, including uniform values.
+ */
+void abcg::OpenGLStateCache::clear() noexcept {
+  invalidate();
+  m_uniforms.clear();
+}
+
+/**
+ * @brief Updates the tracked vertex array object binding.
+ *
+ * @param array Name of the vertex array object to be bound.
+ *
+ * @return `false` if `array` is already bound and the call can be elided.
+ */
+bool abcg::OpenGLStateCache::updateVertexArray(GLuint array) {
+  if (m_vertexArray == array) {
+    ++m_statistics.elidedBinds;
+    return false;
+  }
+  m_vertexArray = array;
+  return true;
+}
+
+/**
+ * @brief Updates the tracked buffer binding of a target.
+ *
+ * Only `GL_ARRAY_BUFFER` and `GL_ELEMENT_ARRAY_BUFFER` are tracked. The
+ * element array buffer is part of the state of the bound vertex array object
+ * and is not tracked while that binding is unknown.
+ *
+ * @param target Buffer binding target.
+ * @param buffer Name of the buffer object to be bound.
+ *
+ * @return `false` if `buffer` is already bound to `target` and the call can
+ * be elided.
+ */
+bool abcg::OpenGLStateCache::updateBuffer(GLenum target, GLuint buffer) {
+  if (target == GL_ARRAY_BUFFER) {
+    if (m_arrayBuffer == buffer) {
+      ++m_statistics.elidedBinds;
+      return false;
+    }
+    m_arrayBuffer = buffer;
+    return true;
+  }
+
+  if (target == GL_ELEMENT_ARRAY_BUFFER && m_vertexArray.has_value()) {
+    auto [iter, inserted]{m_elementBuffers.try_emplace(*m_vertexArray, buffer)};
+    if (!inserted && iter->second == buffer) {
+      ++m_statistics.elidedBinds;
+      return false;
+    }
+    iter->second = buffer;
+  }
+  return true;
+}
+
+/**
+ * @brief Updates the tracked program object.
+ *
+ * @param program Name of the program object to be used.
+ *
+ * @return `false` if `program` is already in use and the call can be elided.
+ */
+bool abcg::OpenGLStateCache::updateProgram(GLuint program) {
+  if (m_program == program) {
+    ++m_statistics.elidedBinds;
+    return false;
+  }
+  m_program = program;
+  return true;
+}
+
+/**
+ * @brief Updates the tracked state of a capability.
+ *
+ * @param cap Capability, such as `GL_DEPTH_TEST`.
+ * @param enabled `true` for `glEnable`, `false` for `glDisable`.
+ *
+ * @return `false` if the capability is already in the given state and the
+ * call can be elided.
+ */
+bool abcg::OpenGLStateCache::updateCapability(GLenum cap, bool enabled) {
+  auto [iter, inserted]{m_capabilities.try_emplace(cap, enabled)};
+  if (!inserted && iter->second == enabled) {
+    ++m_statistics.elidedCapabilities;
+    return false;
+  }
+  iter->second = enabled;
+  return true;
+}
+
+/**
+ * @brief Updates the tracked value of a uniform variable of the program in
+ * use.
+ *
+ * Values are not tracked while the program in use is unknown, for negative
+ * locations, or when larger than abcg::OpenGLStateCache::maxUniformSize.
+ *
+ * Uploads of more than one element are not tracked either, as the elements
+ * of an array can also be set through their own locations. The values of the
+ * locations `[location, location + count)` are forgotten instead, assuming
+ * that array elements have consecutive locations, as on typical drivers.
+ *
+ * @param location Location of the uniform variable.
+ * @param count Number of array elements to be set.
+ * @param type Type of the components of the value.
+ * @param value Binary representation of the value.
+ *
+ * @return `false` if the uniform variable already holds the value and the
+ * call can be elided.
+ */
+bool abcg::OpenGLStateCache::updateUniform(GLint location, GLsizei count,
+                                           OpenGLUniformType type,
+                                           std::span<std::byte const> value) {
+  if (!m_program.has_value() || *m_program == 0 || location < 0) {
+    return true;
+  }
+
+  auto const key{std::uint64_t{*m_program} << 32U |
+                 static_cast<std::uint32_t>(location)};
+  if (count != 1 || value.size() > maxUniformSize) {
+    for (GLsizei element{}; element < std::max(count, 1); ++element) {
+      m_uniforms.erase(key + static_cast<std::uint64_t>(element));
+    }
+    return true;
+  }
+
+  auto &uniform{m_uniforms[key]};
+  if (uniform.size != 0 && uniform.type == type &&
+      uniform.size == value.size() &&
+      std::memcmp(uniform.data.data(), value.data(), value.size()) == 0) {
+    ++m_statistics.elidedUniforms;
+    return false;
+  }
+  uniform.type = type;
+  uniform.size = value.size();
+  std::ranges::copy(value, uniform.data.begin());
+  return true;
+}
+
+/**
+ * @brief Forgets the state of vertex array objects about to be deleted.
+ *
+ * If the bound vertex array object is deleted, the binding reverts to zero.
+ *
+ * @param arrays Names of the vertex array objects.
+ */
+void abcg::OpenGLStateCache::forgetVertexArrays(
+    std::span<GLuint const> arrays) {
+  for (auto const array : arrays) {
+    m_elementBuffers.erase(array);
+    if (m_vertexArray == array) {
+      m_vertexArray = 0U;
+    }
+  }
+}
+
+/**
+ * @brief Forgets the bindings of buffer objects about to be deleted.
+ *
+ * Deleted buffers bound to `GL_ARRAY_BUFFER` or to the bound vertex array
+ * object revert to zero. The element array buffer of other vertex array
+ * objects that reference them becomes unknown.
+ *
+ * @param buffers Names of the buffer objects.
+ */
+void abcg::OpenGLStateCache::forgetBuffers(std::span<GLuint const> buffers) {
+  for (auto const buffer : buffers) {
+    if (buffer == 0) {
+      continue;
+    }
+    if (m_arrayBuffer == buffer) {
+      m_arrayBuffer = 0U;
+    }
+    std::erase_if(m_elementBuffers, [&](auto const &entry) {
+      return entry.second == buffer && entry.first != m_vertexArray;
+    });
+    if (m_vertexArray.has_value()) {
+      if (auto iter{m_elementBuffers.find(*m_vertexArray)};
+          iter != m_elementBuffers.end() && iter->second == buffer) {
+        iter->second = 0U;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Forgets the uniform values of a program about to be linked or
+ * deleted.
+ *
+ * @param program Name of the program object.
+ */
+void abcg::OpenGLStateCache::forgetProgram(GLuint program) {
+  std::erase_if(m_uniforms, [program](auto const &entry) {
+    return entry.first >> 32U == program;
+  });
+}
@@ -0,0 +1,168 @@
+/**
+ * @file abcgOpenGLStateCache.hpp
+ * @brief Header file of abcg::OpenGLStateCache.
+ *
+ * Declaration of abcg::OpenGLStateCache and abcg::getOpenGLStateCache.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_STATE_CACHE_HPP_
+#define ABCG_OPENGL_STATE_CACHE_HPP_
+
+#include "abcgOpenGLExternal.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <unordered_map>
+
+namespace abcg {
+class OpenGLStateCache;
+struct OpenGLStateCacheStatistics;
+enum class OpenGLUniformType;
+
+[[nodiscard]] OpenGLStateCache &getOpenGLStateCache();
+} // namespace abcg
+
+/**
+ * @brief Number of OpenGL calls elided by abcg::OpenGLStateCache.
+ *
+ * @sa abcg::OpenGLStateCache::getFrameStatistics.
+ */
+struct abcg::OpenGLStateCacheStatistics {
+  /** @brief Elided calls to `glBindVertexArray`, `glBindBuffer` and
+   * `glUseProgram`. */
+  std::size_t elidedBinds{};
+  /** @brief Elided calls to `glEnable` and `glDisable`. */
+  std::size_t elidedCapabilities{};
+  /** @brief Elided calls to `glUniform*`. */
+  std::size_t elidedUniforms{};
+
+  /**
+   * @brief Returns the total number of elided calls.
+   *
+   * @return Sum of the elided binds, capabilities and uniforms.
+   */
+  [[nodiscard]] std::size_t total() const noexcept {
+    return elidedBinds + elidedCapabilities + elidedUniforms;
+  }
+};
+
+/**
+ * @brief Type of the components of a uniform value.
+ *
+ * Values of different types are never considered equal, even if their
+ * binary representations match.
+ */
+enum class abcg::OpenGLUniformType {
+  /** @brief `glUniform*f` and `glUniform*fv`. */
+  Float,
+  /** @brief `glUniform*i` and `glUniform*iv`. */
+  Int,
+  /** @brief `glUniform*ui` and `glUniform*uiv`. */
+  UnsignedInt,
+  /** @brief `glUniformMatrix*fv` with `transpose` set to `GL_FALSE`. */
+  Matrix,
+  /** @brief `glUniformMatrix*fv` with `transpose` set to `GL_TRUE`. */
+  TransposedMatrix
+};
+
+/**
+ * @brief Tracks OpenGL state to elide redundant state changes.
+ *
+ * When enabled, the `abcg::gl*` wrappers of abcgOpenGLFunction.hpp consult
+ * the cache before calling the OpenGL function, and skip the call if it would
+ * not change the current state. The following state is tracked:
+ *
+ * - The vertex array object bound with `glBindVertexArray`;
+ * - The buffers bound to `GL_ARRAY_BUFFER` and `GL_ELEMENT_ARRAY_BUFFER`.
+ * The element array buffer is tracked per vertex array object;
+ * - The program installed with `glUseProgram`;
+ * - The capabilities set with `glEnable` and `glDisable`;
+ * - The values of uniform variables set with `glUniform*`, per program and
+ * location, up to abcg::OpenGLStateCache::maxUniformSize bytes each. Only
+ * uploads of a single element are tracked. Uploads of several array elements
+ * are always issued, and forget the values of the locations they overwrite.
+ *
+ * State is initially unknown, so the first call that sets it is always
+ * issued. Calls made directly to the OpenGL API are not seen by the cache.
+ * Call abcg::OpenGLStateCache::invalidate after such calls, as
+ * abcg::OpenGLWindow does at the beginning of each frame, when Dear ImGui and
+ * the resource queues may have changed the state. Uniform values are only
+ * forgotten when the program is linked or deleted through the wrappers, so
+ * programs whose uniforms are tracked must not be updated directly.
+ *
+ * The cache is disabled by default. abcg::OpenGLWindow enables it when
+ * abcg::OpenGLSettings::stateCache is `true`.
+ *
+ * @sa abcg::getOpenGLStateCache.
+ *
+ * @remark The cache is not thread-safe. It must be used only from the thread
+ * where the OpenGL context is current.
+ */
+class abcg::OpenGLStateCache {
+public:
+  /** @brief Maximum size, in bytes, of a uniform value that is tracked. */
+  static constexpr std::size_t maxUniformSize{64};
+
+  void setEnabled(bool enabled);
+  [[nodiscard]] bool isEnabled() const noexcept;
+
+  void beginFrame() noexcept;
+  void endFrame() noexcept;
+  [[nodiscard]] OpenGLStateCacheStatistics const &
+  getFrameStatistics() const noexcept;
+
+  void invalidate() noexcept;
+  void clear() noexcept;
+
+  [[nodiscard]] bool updateVertexArray(GLuint array);
+  [[nodiscard]] bool updateBuffer(GLenum target, GLuint buffer);
+  [[nodiscard]] bool updateProgram(GLuint program);
+  [[nodiscard]] bool updateCapability(GLenum cap, bool enabled);
+  [[nodiscard]] bool updateUniform(GLint location, GLsizei count,
+                                   OpenGLUniformType type,
+                                   std::span<std::byte const> value);
+
+  void forgetVertexArrays(std::span<GLuint const> arrays);
+  void forgetBuffers(std::span<GLuint const> buffers);
+  void forgetProgram(GLuint program);
+
+private:
+  struct UniformValue {
+    OpenGLUniformType type{};
+    std::size_t size{};
+    std::array<std::byte, maxUniformSize> data{};
+  };
+
+  bool m_enabled{};
+
+  std::optional<GLuint> m_vertexArray;
+  std::optional<GLuint> m_arrayBuffer;
+  std::optional<GLuint> m_program;
+  // Element array buffer bound to each vertex array object
+  std::unordered_map<GLuint, GLuint> m_elementBuffers;
+  std::unordered_map<GLenum, bool> m_capabilities;
+  // Keyed by program name (high bits) and uniform location (low bits)
+  std::unordered_map<std::uint64_t, UniformValue> m_uniforms;
+
+  OpenGLStateCacheStatistics m_statistics;
+  OpenGLStateCacheStatistics m_frameStatistics;
+};
+
+/**
+ * @brief Returns whether the cache is enabled.
+ *
+ * @return `true` if the `abcg::gl*` wrappers consult the cache.
+ */
+inline bool abcg::OpenGLStateCache::isEnabled() const noexcept {
+  return m_enabled;
+}
+
+#endif
@@ -0,0 +1,297 @@
+/**
+ * @file abcgOpenGLTextureQueue.cpp
+ * @brief Definition of abcg::OpenGLTextureQueue members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLTextureQueue.hpp"
+#include "abcgThreadPool.hpp"
+
+#include <array>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
+#include <string>
+#include <utility>
+
+#include "abcgException.hpp"
+
+/**
+ * @brief State of a texture being loaded by abcg::OpenGLTextureQueue. For
+ * internal use.
+ */
+struct abcg::OpenGLTextureJob {
+  // Returns whether the images are decoded. Called from the render thread.
+  std::function<bool()> isDecoded;
+  // Waits for the images and uploads them. Called from the render thread.
+  std::function<GLuint()> upload;
+  GLuint placeholder{};
+  GLuint texture{};
+  std::string error;
+  bool done{};
+};
+
+namespace {
+// Uploads the texture of the job, or records why it could not be loaded
+void finishJob(abcg::OpenGLTextureJob &job) {
+  try {
+    job.texture = job.upload();
+  } catch (std::exception const &exception) {
+    job.error = exception.what();
+  }
+  // Release the decoded images
+  job.isDecoded = {};
+  job.upload = {};
+  job.done = true;
+}
+
+template <typename T>
+[[nodiscard]] bool isFutureReady(std::shared_future<T> const &future) {
+  return future.wait_for(std::chrono::seconds::zero()) ==
+         std::future_status::ready;
+}
+} // namespace
+
+/**
+ * @brief Returns the ID of the texture.
+ *
+ * @return ID of the texture if it is ready, or the ID of the placeholder
+ * texture otherwise.
+ */
+GLuint abcg::OpenGLTextureHandle::getID() const noexcept {
+  if (!m_job) {
+    return 0;
+  }
+  return m_job->texture != 0 ? m_job->texture : m_job->placeholder;
+}
+
+/**
+ * @brief Returns whether the texture is uploaded.
+ *
+ * @return `true` if the texture is ready to use; `false` otherwise.
+ */
+bool abcg::OpenGLTextureHandle::isReady() const noexcept {
+  return m_job && m_job->texture != 0;
+}
+
+/**
+ * @brief Returns whether the texture failed to load.
+ *
+ * The placeholder texture remains in use if the texture failed to load.
+ *
+ * @return `true` if the texture could not be loaded; `false` otherwise.
+ */
+bool abcg::OpenGLTextureHandle::hasFailed() const noexcept {
+  return m_job && m_job->done && m_job->texture == 0;
+}
+
+/**
+ * @brief Returns whether the handle refers to a texture.
+ *
+ * @return `false` if the handle is default-constructed; `true` otherwise.
+ */
+bool abcg::OpenGLTextureHandle::isValid() const noexcept {
+  return m_job != nullptr;
+}
+
+/**
+ * @brief Waits for the texture and returns its ID.
+ *
+ * If the texture is not uploaded yet, this waits for its images to be decoded
+ * and uploads it immediately. This must be called while the OpenGL context is
+ * current.
+ *
+ * @throw abcg::RuntimeError if the handle is default-constructed, or if the
+ * texture could not be loaded.
+ *
+ * @return ID of the texture.
+ */
+GLuint abcg::OpenGLTextureHandle::get() {
+  if (!m_job) {
+    throw abcg::RuntimeError("Invalid texture handle");
+  }
+  if (!m_job->done) {
+    finishJob(*m_job);
+  }
+  if (m_job->texture == 0) {
+    throw abcg::RuntimeError(m_job->error);
+  }
+  return m_job->texture;
+}
+
+/**
+ * @brief Submits a 2D texture to be loaded.
+ *
+ * The image is decoded in a worker thread. The function returns without
+ * waiting for it. This must be called while the OpenGL context is current.
+ *
+ * @param createInfo Texture creation settings. The path is copied.
+ *
+ * @return Handle to the texture.
+ */
+abcg::OpenGLTextureHandle
+abcg::OpenGLTextureQueue::submit(OpenGLTextureCreateInfo const &createInfo) {
+  // The path is copied, as the view may not outlive the decoding
+  auto decoded{getThreadPool()
+                   .submit([info = createInfo,
+                            path = std::string{createInfo.path}]() mutable {
+                     info.path = path;
+                     return decodeOpenGLTexture(info);
+                   })
+                   .share()};
+
+  auto job{std::make_shared<OpenGLTextureJob>()};
+  job->isDecoded = [decoded] { return isFutureReady(decoded); };
+  // Only the settings used by the upload are kept
+  job->upload = [uploadInfo = OpenGLTextureCreateInfo{
+                     .generateMipmaps = createInfo.generateMipmaps,
+                     .uploadRing = createInfo.uploadRing},
+                 decoded] {
+    return uploadOpenGLTexture(uploadInfo, decoded.get());
+  };
+  job->placeholder = getPlaceholder(GL_TEXTURE_2D);
+  return enqueue(std::move(job));
+}
+
+/**
+ * @brief Submits a cubemap texture to be loaded.
+ *
+ * The images are decoded in a worker thread. The function returns without
+ * waiting for them. This must be called while the OpenGL context is current.
+ *
+ * @param createInfo Texture creation settings. The paths are copied.
+ *
+ * @return Handle to the texture.
+ */
+abcg::OpenGLTextureHandle
+abcg::OpenGLTextureQueue::submit(OpenGLCubemapCreateInfo const &createInfo) {
+  // The paths are copied, as the views may not outlive the decoding
+  std::array<std::string, 6> paths;
+  std::ranges::copy(createInfo.paths, paths.begin());
+
+  auto decoded{getThreadPool()
+                   .submit([info = createInfo,
+                            paths = std::move(paths)]() mutable {
+                     std::ranges::copy(paths, info.paths.begin());
+                     return decodeOpenGLCubemap(info);
+                   })
+                   .share()};
+
+  auto job{std::make_shared<OpenGLTextureJob>()};
+  job->isDecoded = [decoded] { return isFutureReady(decoded); };
+  // Only the settings used by the upload are kept
+  job->upload = [uploadInfo = OpenGLCubemapCreateInfo{
+                     .generateMipmaps = createInfo.generateMipmaps},
+                 decoded] {
+    return uploadOpenGLCubemap(uploadInfo, decoded.get());
+  };
+  job->placeholder = getPlaceholder(GL_TEXTURE_CUBE_MAP);
+  return enqueue(std::move(job));
+}
+
+/**
+ * @brief Uploads the textures whose images are decoded.
+ *
+ * This must be called while the OpenGL context is current. Textures whose
+ * handles were destroyed are discarded without being uploaded.
+ *
+ * @param maxUploads Maximum number of textures to upload, to spread the cost
+ * of uploading many textures across frames.
+ *
+ * @return Number of textures that finished loading, with or without errors.
+ */
+std::size_t abcg::OpenGLTextureQueue::poll(std::size_t maxUploads) {
+  std::size_t numDone{};
+  for (auto &job : m_jobs) {
+    // The queue holds the only reference to jobs of destroyed handles
+    if (job.use_count() == 1) {
+      job.reset();
+      continue;
+    }
+    if (!job->done && numDone < maxUploads && job->isDecoded()) {
+      finishJob(*job);
+      ++numDone;
+    }
+  }
+
+  std::erase_if(m_jobs, [](auto const &job) { return !job || job->done; });
+
+  return numDone;
+}
+
+/**
+ * @brief Waits until the images of all textures in the queue are decoded and
+ * uploads them.
+ */
+void abcg::OpenGLTextureQueue::finish() {
+  for (auto const &job : m_jobs) {
+    if (!job->done) {
+      finishJob(*job);
+    }
+  }
+  m_jobs.clear();
+}
+
+/**
+ * @brief Discards all textures in the queue and deletes the placeholder
+ * textures.
+ *
+ * Images being decoded are released once decoded. This must be called while
+ * the OpenGL context is current.
+ */
+void abcg::OpenGLTextureQueue::clear() {
+  m_jobs.clear();
+  glDeleteTextures(1, &m_placeholder2D);
+  glDeleteTextures(1, &m_placeholderCubemap);
+  m_placeholder2D = 0;
+  m_placeholderCubemap = 0;
+}
+
+/**
+ * @brief Returns the number of textures that are still being loaded.
+ *
+ * @return Number of textures in the queue.
+ */
+std::size_t abcg::OpenGLTextureQueue::getPendingCount() const noexcept {
+  return m_jobs.size();
+}
+
+// Returns a 1x1 gray texture of the given target, created on first use
+GLuint abcg::OpenGLTextureQueue::getPlaceholder(GLenum target) {
+  auto &placeholder{target == GL_TEXTURE_CUBE_MAP ? m_placeholderCubemap
+                                                  : m_placeholder2D};
+  if (placeholder != 0) {
+    return placeholder;
+  }
+
+  std::array<GLubyte, 4> const gray{128, 128, 128, 255};
+  glGenTextures(1, &placeholder);
+  glBindTexture(target, placeholder);
+  if (target == GL_TEXTURE_CUBE_MAP) {
+    for (GLenum face{}; face < 6; ++face) {
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA, 1, 1, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, gray.data());
+    }
+  } else {
+    glTexImage2D(target, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 gray.data());
+  }
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(target, 0);
+
+  return placeholder;
+}
+
+abcg::OpenGLTextureHandle
+abcg::OpenGLTextureQueue::enqueue(std::shared_ptr<OpenGLTextureJob> job) {
+  OpenGLTextureHandle handle;
+  handle.m_job = job;
+  m_jobs.push_back(std::move(job));
+  return handle;
+}
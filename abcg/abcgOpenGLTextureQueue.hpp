@@ -0,0 +1,99 @@
+/**
+ * @file abcgOpenGLTextureQueue.hpp
+ * @brief Header file of abcg::OpenGLTextureQueue.
+ *
+ * Declaration of abcg::OpenGLTextureQueue and abcg::OpenGLTextureHandle.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_TEXTURE_QUEUE_HPP_
+#define ABCG_OPENGL_TEXTURE_QUEUE_HPP_
+
+#include "abcgOpenGLImage.hpp"
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace abcg {
+struct OpenGLTextureJob;
+class OpenGLTextureHandle;
+class OpenGLTextureQueue;
+} // namespace abcg
+
+/**
+ * @brief Handle to a texture being loaded by an abcg::OpenGLTextureQueue.
+ *
+ * Until the texture is uploaded, abcg::OpenGLTextureHandle::getID returns a
+ * placeholder texture owned by the queue. Once uploaded, the texture is owned
+ * by the caller and must be deleted with `glDeleteTextures`. Textures of
+ * handles destroyed before the upload are never created.
+ *
+ * A default-constructed handle refers to no texture.
+ */
+class abcg::OpenGLTextureHandle {
+public:
+  [[nodiscard]] GLuint getID() const noexcept;
+  [[nodiscard]] bool isReady() const noexcept;
+  [[nodiscard]] bool hasFailed() const noexcept;
+  [[nodiscard]] bool isValid() const noexcept;
+  GLuint get();
+
+private:
+  friend class OpenGLTextureQueue;
+
+  std::shared_ptr<OpenGLTextureJob> m_job;
+};
+
+/**
+ * @brief Loads OpenGL textures without blocking the render loop.
+ *
+ * Images submitted to the queue are decoded and converted by the worker
+ * threads of abcg::getThreadPool. Calls to abcg::OpenGLTextureQueue::poll then
+ * upload the textures whose images are ready. Only the upload runs on the
+ * render thread.
+ *
+ * abcg::OpenGLWindow owns a queue that is polled once per frame before
+ * abcg::OpenGLWindow::onPaint, and cleared after
+ * abcg::OpenGLWindow::onDestroy. Other queues must be cleared with
+ * abcg::OpenGLTextureQueue::clear while the OpenGL context is current.
+ *
+ * @sa abcg::OpenGLWindow::getTextureQueue.
+ *
+ * @remark Objects of this type cannot be copied or copy-constructed.
+ */
+class abcg::OpenGLTextureQueue {
+public:
+  OpenGLTextureQueue() = default;
+  OpenGLTextureQueue(OpenGLTextureQueue const &) = delete;
+  OpenGLTextureQueue(OpenGLTextureQueue &&) noexcept = default;
+  OpenGLTextureQueue &operator=(OpenGLTextureQueue const &) = delete;
+  OpenGLTextureQueue &operator=(OpenGLTextureQueue &&) noexcept = default;
+  ~OpenGLTextureQueue() = default;
+
+  [[nodiscard]] OpenGLTextureHandle
+  submit(OpenGLTextureCreateInfo const &createInfo);
+  [[nodiscard]] OpenGLTextureHandle
+  submit(OpenGLCubemapCreateInfo const &createInfo);
+  std::size_t
+  poll(std::size_t maxUploads = std::numeric_limits<std::size_t>::max());
+  void finish();
+  void clear();
+
+  [[nodiscard]] std::size_t getPendingCount() const noexcept;
+
+private:
+  [[nodiscard]] GLuint getPlaceholder(GLenum target);
+  [[nodiscard]] OpenGLTextureHandle
+  enqueue(std::shared_ptr<OpenGLTextureJob> job);
+
+  std::vector<std::shared_ptr<OpenGLTextureJob>> m_jobs;
+  GLuint m_placeholder2D{};
+  GLuint m_placeholderCubemap{};
+};
+
+#endif
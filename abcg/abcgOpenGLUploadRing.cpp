@@ -0,0 +1,145 @@
+/**
+ * @file abcgOpenGLUploadRing.cpp
+ * @brief Definition of abcg::OpenGLUploadRing members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLUploadRing.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+
+#include "abcgException.hpp"
+
+/**
+ * @brief Sets up the ring.
+ *
+ * The buffers are created on first use. This must be called while the OpenGL
+ * context is current.
+ *
+ * @param bufferCount Number of buffers in the ring.
+ */
+void abcg::OpenGLUploadRing::create(std::size_t bufferCount) {
+  destroy();
+  m_buffers.resize(std::max<std::size_t>(bufferCount, 1));
+  m_nextBuffer = 0;
+}
+
+/**
+ * @brief Deletes the buffers and fences of the ring.
+ *
+ * This must be called while the OpenGL context is current.
+ */
+void abcg::OpenGLUploadRing::destroy() {
+  for (auto &buffer : m_buffers) {
+    if (buffer.fence != nullptr) {
+      glDeleteSync(buffer.fence);
+    }
+    glDeleteBuffers(1, &buffer.buffer);
+  }
+  m_buffers.clear();
+}
+
+/**
+ * @brief Uploads data through the next buffer of the ring.
+ *
+ * Waits until the buffer is no longer read by previous commands, maps it and
+ * calls `write` to fill it. The buffer is then unmapped and bound to
+ * `GL_PIXEL_UNPACK_BUFFER` while `submit` issues the commands that read from
+ * it. This must be called while the OpenGL context is current.
+ *
+ * @param size Size of the data, in bytes. Buffers grow as needed.
+ * @param write Function that writes `size` bytes into the mapped buffer.
+ * @param submit Function that issues the commands that read from the buffer.
+ *
+ * @throw abcg::RuntimeError if the buffer could not be mapped, or if its
+ * contents were lost while mapped.
+ */
+void abcg::OpenGLUploadRing::upload(std::size_t size,
+                                    WriteFunction const &write,
+                                    SubmitFunction const &submit) {
+  if (m_buffers.empty()) {
+    create();
+  }
+
+  auto &buffer{m_buffers.at(m_nextBuffer)};
+  m_nextBuffer = (m_nextBuffer + 1) % m_buffers.size();
+
+  waitFence(buffer);
+
+  if (buffer.buffer == 0) {
+    glGenBuffers(1, &buffer.buffer);
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+  auto const unbind{
+      gsl::finally([] { glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); })};
+
+  if (buffer.capacity < size) {
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, gsl::narrow<GLsizeiptr>(size),
+                 nullptr, GL_STREAM_DRAW);
+    buffer.capacity = size;
+  }
+
+#if defined(__EMSCRIPTEN__)
+  // WebGL cannot map buffers
+  std::vector<std::byte> data(size);
+  write(data);
+  glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, gsl::narrow<GLsizeiptr>(size),
+                  data.data());
+#else
+  auto *const mappedData{glMapBufferRange(
+      GL_PIXEL_UNPACK_BUFFER, 0, gsl::narrow<GLsizeiptr>(size),
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)};
+  if (mappedData == nullptr) {
+    throw abcg::RuntimeError("Failed to map pixel unpack buffer");
+  }
+  try {
+    write({static_cast<std::byte *>(mappedData), size});
+  } catch (...) {
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    throw;
+  }
+  if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE) {
+    throw abcg::RuntimeError("Pixel unpack buffer was lost while mapped");
+  }
+#endif
+
+  submit();
+
+#if !defined(__EMSCRIPTEN__)
+  // WebGL fences are only signaled after control returns to the browser, and
+  // glBufferSubData already synchronizes with previous reads
+  buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+}
+
+// Waits until the commands that read from the buffer complete
+void abcg::OpenGLUploadRing::waitFence(Buffer &buffer) {
+  if (buffer.fence == nullptr) {
+    return;
+  }
+
+  auto const deleteFence{gsl::finally([&buffer] {
+    glDeleteSync(buffer.fence);
+    buffer.fence = nullptr;
+  })};
+
+  // Only the first wait needs to flush the commands
+  GLbitfield flags{GL_SYNC_FLUSH_COMMANDS_BIT};
+  auto const timeout{GLuint64{1'000'000'000}};
+  while (true) {
+    auto const status{glClientWaitSync(buffer.fence, flags, timeout)};
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+      return;
+    }
+    if (status == GL_WAIT_FAILED) {
+      throw abcg::RuntimeError("Failed to wait for pixel unpack buffer");
+    }
+    flags = 0;
+  }
+}
@@ -0,0 +1,83 @@
+/**
+ * @file abcgOpenGLUploadRing.hpp
+ * @brief Header file of abcg::OpenGLUploadRing.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_UPLOAD_RING_HPP_
+#define ABCG_OPENGL_UPLOAD_RING_HPP_
+
+#include "abcgOpenGLExternal.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace abcg {
+class OpenGLUploadRing;
+} // namespace abcg
+
+/**
+ * @brief Ring of pixel unpack buffers for streaming texture uploads.
+ *
+ * Each upload writes the pixels directly into a mapped pixel unpack buffer
+ * (PBO), and the texture is specified from that buffer. The driver copies the
+ * data to the texture asynchronously, so the transfer overlaps with
+ * rendering. A fence is inserted after each upload, and a buffer is reused
+ * only after the commands that read from it complete.
+ *
+ * In WebGL, buffers cannot be mapped and client waits cannot block, so the
+ * pixels are written with `glBufferSubData` and no fences are used.
+ *
+ * abcg::OpenGLWindow owns a ring that can be passed to abcg::loadOpenGLTexture
+ * through abcg::OpenGLTextureCreateInfo::uploadRing.
+ *
+ * @sa abcg::OpenGLWindow::getUploadRing.
+ *
+ * @remark Objects of this type cannot be copied or copy-constructed.
+ */
+class abcg::OpenGLUploadRing {
+public:
+  /** @brief Default number of buffers in the ring. */
+  static constexpr std::size_t defaultBufferCount{3};
+
+  /** @brief Function that writes the data to be uploaded into the mapped
+   * buffer. */
+  using WriteFunction = std::function<void(std::span<std::byte> data)>;
+  /** @brief Function that issues the commands that read from the buffer,
+   * such as `glTexSubImage2D` with offset 0, while it is bound to
+   * `GL_PIXEL_UNPACK_BUFFER`. */
+  using SubmitFunction = std::function<void()>;
+
+  OpenGLUploadRing() = default;
+  OpenGLUploadRing(OpenGLUploadRing const &) = delete;
+  OpenGLUploadRing(OpenGLUploadRing &&) noexcept = default;
+  OpenGLUploadRing &operator=(OpenGLUploadRing const &) = delete;
+  OpenGLUploadRing &operator=(OpenGLUploadRing &&) noexcept = default;
+  ~OpenGLUploadRing() = default;
+
+  void create(std::size_t bufferCount = defaultBufferCount);
+  void destroy();
+
+  void upload(std::size_t size, WriteFunction const &write,
+              SubmitFunction const &submit);
+
+private:
+  struct Buffer {
+    GLuint buffer{};
+    std::size_t capacity{};
+    GLsync fence{};
+  };
+
+  static void waitFence(Buffer &buffer);
+
+  std::vector<Buffer> m_buffers;
+  std::size_t m_nextBuffer{};
+};
+
+#endif
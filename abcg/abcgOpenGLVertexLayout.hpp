@@ -0,0 +1,110 @@
+/**
+ * @file abcgOpenGLVertexLayout.hpp
+ * @brief OpenGL vertex attribute setup derived from abcg::VertexLayout.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_VERTEX_LAYOUT_HPP_
+#define ABCG_OPENGL_VERTEX_LAYOUT_HPP_
+
+#include "abcgOpenGLFunction.hpp"
+#include "abcgVertexLayout.hpp"
+
+#include <cstdint>
+
+namespace abcg {
+struct OpenGLVertexFormat;
+
+[[nodiscard]] constexpr OpenGLVertexFormat
+getOpenGLVertexFormat(VertexFormat format) noexcept;
+[[nodiscard]] constexpr GLenum getOpenGLIndexType(IndexFormat format) noexcept;
+
+template <HasVertexLayout Vertex> void setupOpenGLVertexAttributes();
+} // namespace abcg
+
+/**
+ * @brief Arguments of `glVertexAttribPointer` for a vertex format.
+ */
+struct abcg::OpenGLVertexFormat {
+  /** @brief Number of components. */
+  GLint size{};
+  /** @brief Component type. */
+  GLenum type{};
+  /** @brief Whether integer components are normalized. */
+  GLboolean normalized{};
+};
+
+/**
+ * @brief Returns the arguments of `glVertexAttribPointer` for a vertex
+ * format.
+ *
+ * @param format Vertex format.
+ *
+ * @return Size, type and normalization of the format.
+ */
+constexpr abcg::OpenGLVertexFormat
+abcg::getOpenGLVertexFormat(VertexFormat format) noexcept {
+  switch (format) {
+  case VertexFormat::Float32x1:
+  case VertexFormat::Float32x2:
+  case VertexFormat::Float32x3:
+  case VertexFormat::Float32x4:
+    return {.size = static_cast<GLint>(
+                getVertexFormatInfo(format).componentCount),
+            .type = GL_FLOAT,
+            .normalized = GL_FALSE};
+  case VertexFormat::Float16x2:
+    return {.size = 2, .type = GL_HALF_FLOAT, .normalized = GL_FALSE};
+  case VertexFormat::Float16x4:
+    return {.size = 4, .type = GL_HALF_FLOAT, .normalized = GL_FALSE};
+  case VertexFormat::Snorm16x2:
+    return {.size = 2, .type = GL_SHORT, .normalized = GL_TRUE};
+  case VertexFormat::Snorm16x4:
+    return {.size = 4, .type = GL_SHORT, .normalized = GL_TRUE};
+  case VertexFormat::Unorm8x4:
+    return {.size = 4, .type = GL_UNSIGNED_BYTE, .normalized = GL_TRUE};
+  case VertexFormat::Snorm10x3:
+    return {.size = 4, .type = GL_INT_2_10_10_10_REV, .normalized = GL_TRUE};
+  }
+  return {};
+}
+
+/**
+ * @brief Returns the type argument of `glDrawElements` for an index format.
+ *
+ * @param format Index format.
+ *
+ * @return `GL_UNSIGNED_SHORT` or `GL_UNSIGNED_INT`.
+ */
+constexpr GLenum abcg::getOpenGLIndexType(IndexFormat format) noexcept {
+  return format == IndexFormat::Uint16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+/**
+ * @brief Enables and specifies the vertex attributes of a vertex type.
+ *
+ * Calls `glEnableVertexAttribArray` and `glVertexAttribPointer` for each
+ * attribute of abcg::VertexLayout<Vertex>, at the locations given by the
+ * layout and with a stride of `sizeof(Vertex)`. The vertex array object and
+ * the array buffer must be bound.
+ *
+ * @tparam Vertex Vertex type with a specialization of abcg::VertexLayout.
+ */
+template <abcg::HasVertexLayout Vertex>
+void abcg::setupOpenGLVertexAttributes() {
+  for (auto const &attribute : VertexLayout<Vertex>::attributes) {
+    constexpr auto stride{static_cast<GLsizei>(sizeof(Vertex))};
+    auto const format{getOpenGLVertexFormat(attribute.format)};
+    abcg::glEnableVertexAttribArray(attribute.location);
+    abcg::glVertexAttribPointer(
+        attribute.location, format.size, format.type, format.normalized,
+        stride,
+        reinterpret_cast<void const *>(std::uintptr_t{attribute.offset}));
+  }
+}
+
+#endif
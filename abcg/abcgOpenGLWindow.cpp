@@ -44,6 +44,46 @@ void abcg::OpenGLWindow::setOpenGLSettings(
   m_openGLSettings = openGLSettings;
 }
 
+/**
+ * @brief Returns the queue of programs being built in the background.
+ *
+ * The queue is polled once per frame before abcg::OpenGLWindow::onPaint, and
+ * the programs still pending are discarded after
+ * abcg::OpenGLWindow::onDestroy.
+ *
+ * @returns Reference to the abcg::OpenGLShaderCompileQueue of the window.
+ */
+abcg::OpenGLShaderCompileQueue &
+abcg::OpenGLWindow::getShaderCompileQueue() noexcept {
+  return m_shaderCompileQueue;
+}
+
+/**
+ * @brief Returns the queue of textures being loaded in the background.
+ *
+ * The queue is polled once per frame before abcg::OpenGLWindow::onPaint, and
+ * the textures still pending are discarded after
+ * abcg::OpenGLWindow::onDestroy.
+ *
+ * @returns Reference to the abcg::OpenGLTextureQueue of the window.
+ */
+abcg::OpenGLTextureQueue &abcg::OpenGLWindow::getTextureQueue() noexcept {
+  return m_textureQueue;
+}
+
+/**
+ * @brief Returns the ring of pixel unpack buffers used to stream texture
+ * uploads.
+ *
+ * The ring can be set in abcg::OpenGLTextureCreateInfo::uploadRing. Its
+ * buffers are deleted after abcg::OpenGLWindow::onDestroy.
+ *
+ * @returns Reference to the abcg::OpenGLUploadRing of the window.
+ */
+abcg::OpenGLUploadRing &abcg::OpenGLWindow::getUploadRing() noexcept {
+  return m_uploadRing;
+}
+
 /**
  * @brief Takes a snapshot of the screen and saves it to a file.
  *
@@ -127,7 +167,9 @@ void abcg::OpenGLWindow::onPaint() {
  *
  * Override it for custom behavior. By default, it shows a FPS counter if
  * abcg::WindowSettings::showFPS is set to `true`, and a toggle fullscreen
- * button if abcg::WindowSettings::showFullscreenButton is set to `true`.
+ * button if abcg::WindowSettings::showFullscreenButton is set to `true`. If
+ * abcg::OpenGLSettings::stateCache is `true`, the FPS counter also shows the
+ * number of calls elided by abcg::OpenGLStateCache in the last frame.
  */
 void abcg::OpenGLWindow::onPaintUI() {
   // FPS counter
@@ -156,6 +198,13 @@ void abcg::OpenGLWindow::onPaintUI() {
                      // *std::ranges::max_element(frames) * 2,
                      *std::max_element(frames.begin(), frames.end()) * 2,
                      ImVec2(gsl::narrow<float>(frames.size()), 50));
+    if (auto const &stateCache{getOpenGLStateCache()};
+        stateCache.isEnabled()) {
+      auto const &statistics{stateCache.getFrameStatistics()};
+      ImGui::TextUnformatted(
+          fmt::format("{} redundant GL calls elided", statistics.total())
+              .c_str());
+    }
     ImGui::End();
   }
 
@@ -296,22 +345,30 @@ void abcg::OpenGLWindow::create() {
   m_GLSLVersion =
       fmt::format("#version {:d}{:02d}", majorVersion, minorVersion * 10);
 
+  // Debug contexts report errors through KHR_debug
+  auto contextFlags{0};
+#if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
+  if (m_openGLSettings.debugOutput) {
+    contextFlags |= SDL_GL_CONTEXT_DEBUG_FLAG;
+  }
+#endif
+
   switch (profile) {
   case OpenGLProfile::Core:
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS,
-                        SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
+                        contextFlags | SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
                         SDL_GL_CONTEXT_PROFILE_CORE);
     m_GLSLVersion += " core";
     break;
   case OpenGLProfile::Compatibility:
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, contextFlags);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
                         SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
     m_GLSLVersion += " compatibility";
     break;
   case OpenGLProfile::ES:
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, contextFlags);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
     m_GLSLVersion += " es";
     break;
@@ -380,6 +437,14 @@ void abcg::OpenGLWindow::create() {
       "GLSL version...: {}\n",
       reinterpret_cast<char const *>(glGetString(GL_SHADING_LANGUAGE_VERSION)));
 
+#if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
+  auto const debugOutput{
+      m_openGLSettings.debugOutput &&
+      enableGLDebugOutput(m_openGLSettings.synchronousDebugOutput)};
+  fmt::print("Error checking.: {}\n",
+             debugOutput ? "KHR_debug callback" : "glGetError");
+#endif
+
   // Print out extensions
   // GLint numExtensions{};
   // glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
@@ -419,6 +484,9 @@ void abcg::OpenGLWindow::create() {
     throw abcg::RuntimeError("Failed to load font file");
   }
 
+  // Track the state set through the abcg::gl* wrappers
+  getOpenGLStateCache().setEnabled(m_openGLSettings.stateCache);
+
   onCreate();
 
   onResize(getWindowSize());
@@ -443,16 +511,28 @@ void abcg::OpenGLWindow::paint() {
   }
 #endif
 
+  // Hand back the programs that finished building since the last frame
+  m_shaderCompileQueue.poll();
+
+  // Upload the textures decoded since the last frame
+  m_textureQueue.poll();
+
   ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplSDL2_NewFrame();
   ImGui::NewFrame();
 
+  // The state may have been changed by Dear ImGui and by the queues above
+  auto &stateCache{getOpenGLStateCache()};
+  stateCache.beginFrame();
+
   onPaintUI();
 
   ImGui::Render();
 
   onPaint();
 
+  stateCache.endFrame();
+
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
   if (m_openGLSettings.doubleBuffering) {
     SDL_GL_SwapWindow(abcg::Window::getSDLWindow());
@@ -464,6 +544,17 @@ void abcg::OpenGLWindow::paint() {
 void abcg::OpenGLWindow::destroy() {
   onDestroy();
 
+  getOpenGLStateCache().setEnabled(false);
+
+  if (m_GLContext != nullptr) {
+#if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
+    disableGLDebugOutput();
+#endif
+    m_shaderCompileQueue.clear();
+    m_textureQueue.clear();
+    m_uploadRing.destroy();
+  }
+
   if (ImGui::GetCurrentContext() != nullptr) {
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
@@ -17,6 +17,8 @@
 
 #include "abcgExternal.hpp"
 #include "abcgOpenGLFunction.hpp"
+#include "abcgOpenGLShaderCompileQueue.hpp"
+#include "abcgOpenGLTextureQueue.hpp"
 #include "abcgWindow.hpp"
 
 namespace abcg {
@@ -77,6 +79,24 @@ struct abcg::OpenGLSettings {
   bool vSync{false};
   /** @brief Whether the output is double buffered. */
   bool doubleBuffering{true};
+  /** @brief Whether debug builds create a debug context and report OpenGL
+   * errors through a `KHR_debug` message callback instead of calling
+   * `glGetError` before and after each `abcg::gl*` call.
+   *
+   * `glGetError` is still used if the context does not support `KHR_debug`.
+   * This has no effect in release builds.
+   *
+   * @sa abcg::enableGLDebugOutput. */
+  bool debugOutput{true};
+  /** @brief Whether debug messages are generated during the call that
+   * causes them, so that errors are reported with the source location of
+   * that call. */
+  bool synchronousDebugOutput{true};
+  /** @brief Whether redundant state changes made through the `abcg::gl*`
+   * wrappers are elided.
+   *
+   * @sa abcg::OpenGLStateCache. */
+  bool stateCache{false};
 };
 
 /**
@@ -101,6 +121,9 @@ public:
   [[nodiscard]] OpenGLSettings const &getOpenGLSettings() const noexcept;
   void setOpenGLSettings(OpenGLSettings const &openGLSettings) noexcept;
   void saveScreenshotPNG(std::string_view filename) const;
+  [[nodiscard]] OpenGLShaderCompileQueue &getShaderCompileQueue() noexcept;
+  [[nodiscard]] OpenGLTextureQueue &getTextureQueue() noexcept;
+  [[nodiscard]] OpenGLUploadRing &getUploadRing() noexcept;
 
 protected:
   virtual void onEvent(SDL_Event const &event);
@@ -121,6 +144,9 @@ private:
   OpenGLSettings m_openGLSettings;
   std::string m_GLSLVersion;
   SDL_GLContext m_GLContext{};
+  OpenGLShaderCompileQueue m_shaderCompileQueue;
+  OpenGLTextureQueue m_textureQueue;
+  OpenGLUploadRing m_uploadRing;
   bool m_hidden{};
   bool m_minimized{};
 };
@@ -0,0 +1,204 @@
+/**
+ * @file abcgThreadPool.cpp
+ * @brief Definition of abcg::ThreadPool members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+/**
+ * @brief Returns the thread pool shared by ABCg functions that run tasks in
+ * the background, such as asynchronous texture decoding.
+ *
+ * The pool is created on first use with
+ * abcg::ThreadPool::getDefaultThreadCount worker threads.
+ *
+ * @return Reference to the shared pool.
+ */
+abcg::ThreadPool &abcg::getThreadPool() {
+  static ThreadPool pool;
+  return pool;
+}
+
+/**
+ * @brief Constructs a pool and starts its worker threads.
+ *
+ * @param threadCount Number of worker threads. If 0, tasks are run on the
+ * calling thread.
+ */
+abcg::ThreadPool::ThreadPool(std::size_t threadCount) {
+  m_threads.reserve(threadCount);
+  for (std::size_t index{}; index < threadCount; ++index) {
+    m_threads.emplace_back([this] { run(); });
+  }
+}
+
+/**
+ * @brief Destructor.
+ *
+ * Waits for the tasks already submitted to finish and joins the worker
+ * threads.
+ */
+abcg::ThreadPool::~ThreadPool() {
+  {
+    std::scoped_lock const lock{m_mutex};
+    m_stopping = true;
+  }
+  m_condition.notify_all();
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+}
+
+/**
+ * @brief Splits a range of indices into batches and processes them in
+ * parallel.
+ *
+ * The calling thread processes batches as well, and returns when all batches
+ * are processed. It never waits for tasks that did not start, so this can be
+ * called from a task of the same pool.
+ *
+ * @param count Number of indices.
+ * @param function Function called once per batch with the range of indices
+ * of the batch.
+ * @param minBatchSize Minimum number of indices per batch.
+ *
+ * @throw The first exception thrown by `function`, after all batches are
+ * processed.
+ */
+void abcg::ThreadPool::parallelFor(std::size_t count,
+                                   RangeFunction const &function,
+                                   std::size_t minBatchSize) {
+  if (count == 0) {
+    return;
+  }
+
+  // One batch per thread, including the calling thread
+  auto const threadBatchSize{(count + m_threads.size()) /
+                             (m_threads.size() + 1)};
+  auto const batchSize{std::max({threadBatchSize, minBatchSize,
+                                 std::size_t{1}})};
+  auto const batchCount{(count + batchSize - 1) / batchSize};
+  if (batchCount == 1) {
+    function(0, count);
+    return;
+  }
+
+  // Shared with tasks that may start after this function returns
+  struct State {
+    RangeFunction function;
+    std::size_t count{};
+    std::size_t batchSize{};
+    std::size_t batchCount{};
+    std::atomic<std::size_t> nextBatch{};
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::size_t finishedBatches{};
+    std::exception_ptr exception;
+  };
+  auto state{std::make_shared<State>()};
+  state->function = function;
+  state->count = count;
+  state->batchSize = batchSize;
+  state->batchCount = batchCount;
+
+  auto const processBatches{[](State &batches) {
+    while (true) {
+      auto const batch{batches.nextBatch.fetch_add(1)};
+      if (batch >= batches.batchCount) {
+        return;
+      }
+      auto const first{batch * batches.batchSize};
+      try {
+        batches.function(first,
+                         std::min(first + batches.batchSize, batches.count));
+      } catch (...) {
+        std::scoped_lock const lock{batches.mutex};
+        if (!batches.exception) {
+          batches.exception = std::current_exception();
+        }
+      }
+      std::scoped_lock const lock{batches.mutex};
+      if (++batches.finishedBatches == batches.batchCount) {
+        batches.condition.notify_all();
+      }
+    }
+  }};
+
+  auto const taskCount{std::min(m_threads.size(), batchCount - 1)};
+  for (std::size_t index{}; index < taskCount; ++index) {
+    enqueue([state, processBatches] { processBatches(*state); });
+  }
+  processBatches(*state);
+
+  std::unique_lock lock{state->mutex};
+  state->condition.wait(
+      lock, [&] { return state->finishedBatches == state->batchCount; });
+  if (state->exception) {
+    std::rethrow_exception(state->exception);
+  }
+}
+
+/**
+ * @brief Returns the number of worker threads.
+ *
+ * @return Number of worker threads.
+ */
+std::size_t abcg::ThreadPool::getThreadCount() const noexcept {
+  return m_threads.size();
+}
+
+/**
+ * @brief Returns the default number of worker threads.
+ *
+ * One thread per hardware thread, leaving one for the render thread. Returns
+ * 0 on platforms without thread support.
+ *
+ * @return Number of worker threads.
+ */
+std::size_t abcg::ThreadPool::getDefaultThreadCount() noexcept {
+#if defined(__EMSCRIPTEN__)
+  return 0;
+#else
+  auto const hardwareThreads{std::thread::hardware_concurrency()};
+  return std::max<std::size_t>(hardwareThreads, 2) - 1;
+#endif
+}
+
+void abcg::ThreadPool::enqueue(std::function<void()> task) {
+  if (m_threads.empty()) {
+    task();
+    return;
+  }
+  {
+    std::scoped_lock const lock{m_mutex};
+    m_tasks.push_back(std::move(task));
+  }
+  m_condition.notify_one();
+}
+
+void abcg::ThreadPool::run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock{m_mutex};
+      m_condition.wait(lock,
+                       [this] { return m_stopping || !m_tasks.empty(); });
+      if (m_tasks.empty()) {
+        return;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    // Exceptions are stored in the future of the task
+    task();
+  }
+}
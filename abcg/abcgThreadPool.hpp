@@ -0,0 +1,96 @@
+/**
+ * @file abcgThreadPool.hpp
+ * @brief Header file of abcg::ThreadPool.
+ *
+ * Declaration of abcg::ThreadPool and abcg::getThreadPool.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_THREAD_POOL_HPP_
+#define ABCG_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace abcg {
+class ThreadPool;
+
+[[nodiscard]] ThreadPool &getThreadPool();
+} // namespace abcg
+
+/**
+ * @brief Fixed-size pool of worker threads.
+ *
+ * Tasks are run in the order they are submitted, by the first worker thread
+ * that becomes idle. Each submission returns a `std::future` with the result
+ * of the task, or the exception thrown by it.
+ *
+ * If the pool has no worker threads, as on platforms without thread support,
+ * tasks are run on the calling thread at submission.
+ *
+ * @sa abcg::getThreadPool for the pool shared by ABCg functions.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::ThreadPool {
+public:
+  explicit ThreadPool(std::size_t threadCount = getDefaultThreadCount());
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool &&) = delete;
+  ~ThreadPool();
+
+  /**
+   * @brief Submits a task to be run by a worker thread.
+   *
+   * @param function Callable object taking no arguments.
+   *
+   * @return Future of the result of `function`.
+   */
+  template <typename Function>
+  [[nodiscard]] std::future<std::invoke_result_t<std::decay_t<Function>>>
+  submit(Function &&function) {
+    using Result = std::invoke_result_t<std::decay_t<Function>>;
+    // std::function requires a copyable target
+    auto task{std::make_shared<std::packaged_task<Result()>>(
+        std::forward<Function>(function))};
+    auto future{task->get_future()};
+    enqueue([task] { (*task)(); });
+    return future;
+  }
+
+  /** @brief Function that processes the indices in `[first, last)`. */
+  using RangeFunction =
+      std::function<void(std::size_t first, std::size_t last)>;
+
+  void parallelFor(std::size_t count, RangeFunction const &function,
+                   std::size_t minBatchSize = 1);
+
+  [[nodiscard]] std::size_t getThreadCount() const noexcept;
+  [[nodiscard]] static std::size_t getDefaultThreadCount() noexcept;
+
+private:
+  void enqueue(std::function<void()> task);
+  void run();
+
+  std::vector<std::thread> m_threads;
+  std::deque<std::function<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_stopping{};
+};
+
+#endif
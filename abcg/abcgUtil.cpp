@@ -17,6 +17,29 @@ auto const codeBoldBlue{"\033[1;34m"};
 auto const codeReset{"\033[0m"};
 } // namespace
 
+/**
+ * @brief Computes the 64-bit FNV-1a hash of a sequence of bytes.
+ *
+ * Unlike std::hash and abcg::hashCombine, the result is the same across runs
+ * and platforms, so it can be used as a key for data stored on disk. Hashes of
+ * several sequences can be chained by passing the previous result as the seed:
+ * @code
+ * auto hash{abcg::hashFNV1a(first)};
+ * hash = abcg::hashFNV1a(second, hash);
+ * @endcode
+ *
+ * @param data View of the bytes to be hashed.
+ * @param seed Initial hash value.
+ * @return Hash value.
+ */
+std::uint64_t abcg::hashFNV1a(std::string_view data, std::uint64_t seed) {
+  for (auto const character : data) {
+    seed ^= static_cast<unsigned char>(character);
+    seed *= 0x100000001b3ULL;
+  }
+  return seed;
+}
+
 /**
  * @brief Creates a string prefixed with the ANSI color code that corresponds to
  * foreground bold red.
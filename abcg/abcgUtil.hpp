@@ -11,8 +11,10 @@
 #ifndef ABCG_UTIL_HPP_
 #define ABCG_UTIL_HPP_
 
+#include <cstdint>
 #include <functional>
 #include <string>
+#include <string_view>
 
 namespace abcg {
 
@@ -69,6 +71,16 @@ std::size_t hashCombine(const TFirst &value, const TRest &...rest) {
   return seed;
 }
 
+/**
+ * @brief Offset basis of the 64-bit FNV-1a hash.
+ *
+ * @sa abcg::hashFNV1a.
+ */
+inline constexpr std::uint64_t fnv1aOffsetBasis{0xcbf29ce484222325ULL};
+
+[[nodiscard]] std::uint64_t hashFNV1a(std::string_view data,
+                                      std::uint64_t seed = fnv1aOffsetBasis);
+
 std::string toRedString(std::string_view str);
 std::string toYellowString(std::string_view str);
 std::string toBlueString(std::string_view str);
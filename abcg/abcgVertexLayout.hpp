@@ -0,0 +1,443 @@
+/**
+ * @file abcgVertexLayout.hpp
+ * @brief Compact vertex attribute types and compile-time vertex layouts.
+ *
+ * Vertex structures declare their attributes with the types defined here
+ * (half-float, normalized integer and 10:10:10:2 formats) or with `float`
+ * and glm vectors. A specialization of abcg::VertexLayout lists the
+ * attributes, from which the OpenGL and Vulkan vertex input states are
+ * derived.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_VERTEX_LAYOUT_HPP_
+#define ABCG_VERTEX_LAYOUT_HPP_
+
+#include <glm/gtc/packing.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace abcg {
+enum class VertexFormat;
+enum class IndexFormat;
+struct VertexFormatInfo;
+struct VertexAttribute;
+struct PackedIndices;
+struct Float16x2;
+struct Float16x4;
+struct Snorm16x2;
+struct Snorm16x4;
+struct Unorm8x4;
+struct Snorm10x3;
+
+template <typename T> struct VertexFormatOf;
+template <typename Vertex> struct VertexLayout;
+
+template <typename Vertex>
+concept HasVertexLayout = requires {
+  { VertexLayout<Vertex>::attributes };
+};
+} // namespace abcg
+
+/**
+ * @brief Formats of vertex attributes.
+ */
+enum class abcg::VertexFormat {
+  Float32x1,
+  Float32x2,
+  Float32x3,
+  Float32x4,
+  Float16x2,
+  Float16x4,
+  Snorm16x2,
+  Snorm16x4,
+  Unorm8x4,
+  /** @brief Three signed normalized 10-bit components and one 2-bit
+   * component, packed in a 32-bit word with the first component in the least
+   * significant bits. */
+  Snorm10x3
+};
+
+/**
+ * @brief Formats of index arrays.
+ */
+enum class abcg::IndexFormat { Uint16, Uint32 };
+
+/**
+ * @brief Description of a vertex format.
+ */
+struct abcg::VertexFormatInfo {
+  /** @brief Number of components read by the vertex shader. */
+  std::uint32_t componentCount{};
+  /** @brief Size of an attribute, in bytes. */
+  std::uint32_t size{};
+};
+
+namespace abcg {
+/**
+ * @brief Returns the description of a vertex format.
+ *
+ * @param format Vertex format.
+ *
+ * @return Number of components and size.
+ */
+[[nodiscard]] constexpr VertexFormatInfo
+getVertexFormatInfo(VertexFormat format) noexcept {
+  switch (format) {
+  case VertexFormat::Float32x1:
+    return {.componentCount = 1, .size = 4};
+  case VertexFormat::Float32x2:
+    return {.componentCount = 2, .size = 8};
+  case VertexFormat::Float32x3:
+    return {.componentCount = 3, .size = 12};
+  case VertexFormat::Float32x4:
+    return {.componentCount = 4, .size = 16};
+  case VertexFormat::Float16x2:
+  case VertexFormat::Snorm16x2:
+    return {.componentCount = 2, .size = 4};
+  case VertexFormat::Float16x4:
+  case VertexFormat::Snorm16x4:
+    return {.componentCount = 4, .size = 8};
+  case VertexFormat::Unorm8x4:
+  case VertexFormat::Snorm10x3:
+    return {.componentCount = 4, .size = 4};
+  }
+  return {};
+}
+
+/**
+ * @brief Returns the size of an index of the given format.
+ *
+ * @param format Index format.
+ *
+ * @return Size of an index, in bytes.
+ */
+[[nodiscard]] constexpr std::size_t getIndexSize(IndexFormat format) noexcept {
+  return format == IndexFormat::Uint16 ? sizeof(std::uint16_t)
+                                       : sizeof(std::uint32_t);
+}
+
+[[nodiscard]] PackedIndices packIndices(std::span<std::uint32_t const> indices,
+                                        std::size_t vertexCount);
+} // namespace abcg
+
+/**
+ * @brief Two half-precision floating-point components.
+ */
+struct abcg::Float16x2 {
+  /** @brief Components, as IEEE 754 binary16 values. */
+  std::array<std::uint16_t, 2> components{};
+
+  constexpr Float16x2() noexcept = default;
+  /** @brief Converts a vector to half precision. */
+  explicit Float16x2(glm::vec2 const &value) noexcept
+      : components{glm::packHalf1x16(value.x), glm::packHalf1x16(value.y)} {}
+
+  /** @brief Converts back to single precision. */
+  [[nodiscard]] glm::vec2 unpack() const noexcept {
+    return {glm::unpackHalf1x16(components[0]),
+            glm::unpackHalf1x16(components[1])};
+  }
+
+  friend bool operator==(Float16x2 const &, Float16x2 const &) = default;
+};
+
+/**
+ * @brief Four half-precision floating-point components.
+ *
+ * Also used for positions, with the fourth component set to 1, as there is no
+ * three-component half format with 4-byte alignment.
+ */
+struct abcg::Float16x4 {
+  /** @brief Components, as IEEE 754 binary16 values. */
+  std::array<std::uint16_t, 4> components{};
+
+  constexpr Float16x4() noexcept = default;
+  /** @brief Converts a vector to half precision. */
+  explicit Float16x4(glm::vec4 const &value) noexcept
+      : components{glm::packHalf1x16(value.x), glm::packHalf1x16(value.y),
+                   glm::packHalf1x16(value.z), glm::packHalf1x16(value.w)} {}
+  /** @brief Converts a point to half precision, with the fourth component
+   * set to `w`. */
+  explicit Float16x4(glm::vec3 const &value, float w = 1.0f) noexcept
+      : Float16x4{glm::vec4{value, w}} {}
+
+  /** @brief Converts back to single precision. */
+  [[nodiscard]] glm::vec4 unpack() const noexcept {
+    return {glm::unpackHalf1x16(components[0]),
+            glm::unpackHalf1x16(components[1]),
+            glm::unpackHalf1x16(components[2]),
+            glm::unpackHalf1x16(components[3])};
+  }
+
+  friend bool operator==(Float16x4 const &, Float16x4 const &) = default;
+};
+
+/**
+ * @brief Two signed normalized 16-bit components, mapping [-1, 1] to
+ * [-32767, 32767].
+ */
+struct abcg::Snorm16x2 {
+  /** @brief Components. */
+  std::array<std::int16_t, 2> components{};
+
+  constexpr Snorm16x2() noexcept = default;
+  /** @brief Quantizes a vector with components in [-1, 1]. */
+  explicit Snorm16x2(glm::vec2 const &value) noexcept
+      : components{std::bit_cast<std::int16_t>(glm::packSnorm1x16(value.x)),
+                   std::bit_cast<std::int16_t>(glm::packSnorm1x16(value.y))} {}
+
+  /** @brief Converts back to floating point. */
+  [[nodiscard]] glm::vec2 unpack() const noexcept {
+    return {
+        glm::unpackSnorm1x16(std::bit_cast<std::uint16_t>(components[0])),
+        glm::unpackSnorm1x16(std::bit_cast<std::uint16_t>(components[1]))};
+  }
+
+  friend bool operator==(Snorm16x2 const &, Snorm16x2 const &) = default;
+};
+
+/**
+ * @brief Four signed normalized 16-bit components, mapping [-1, 1] to
+ * [-32767, 32767].
+ */
+struct abcg::Snorm16x4 {
+  /** @brief Components. */
+  std::array<std::int16_t, 4> components{};
+
+  constexpr Snorm16x4() noexcept = default;
+  /** @brief Quantizes a vector with components in [-1, 1]. */
+  explicit Snorm16x4(glm::vec4 const &value) noexcept
+      : components{std::bit_cast<std::int16_t>(glm::packSnorm1x16(value.x)),
+                   std::bit_cast<std::int16_t>(glm::packSnorm1x16(value.y)),
+                   std::bit_cast<std::int16_t>(glm::packSnorm1x16(value.z)),
+                   std::bit_cast<std::int16_t>(glm::packSnorm1x16(value.w))} {}
+
+  /** @brief Converts back to floating point. */
+  [[nodiscard]] glm::vec4 unpack() const noexcept {
+    return {
+        glm::unpackSnorm1x16(std::bit_cast<std::uint16_t>(components[0])),
+        glm::unpackSnorm1x16(std::bit_cast<std::uint16_t>(components[1])),
+        glm::unpackSnorm1x16(std::bit_cast<std::uint16_t>(components[2])),
+        glm::unpackSnorm1x16(std::bit_cast<std::uint16_t>(components[3]))};
+  }
+
+  friend bool operator==(Snorm16x4 const &, Snorm16x4 const &) = default;
+};
+
+/**
+ * @brief Four unsigned normalized 8-bit components, mapping [0, 1] to
+ * [0, 255]. Typically used for colors.
+ */
+struct abcg::Unorm8x4 {
+  /** @brief Components. */
+  std::array<std::uint8_t, 4> components{};
+
+  constexpr Unorm8x4() noexcept = default;
+  /** @brief Quantizes a vector with components in [0, 1]. */
+  explicit Unorm8x4(glm::vec4 const &value) noexcept
+      : components{glm::packUnorm1x8(value.x), glm::packUnorm1x8(value.y),
+                   glm::packUnorm1x8(value.z), glm::packUnorm1x8(value.w)} {}
+
+  /** @brief Converts back to floating point. */
+  [[nodiscard]] glm::vec4 unpack() const noexcept {
+    return {glm::unpackUnorm1x8(components[0]),
+            glm::unpackUnorm1x8(components[1]),
+            glm::unpackUnorm1x8(components[2]),
+            glm::unpackUnorm1x8(components[3])};
+  }
+
+  friend bool operator==(Unorm8x4 const &, Unorm8x4 const &) = default;
+};
+
+/**
+ * @brief Three signed normalized 10-bit components packed in 32 bits.
+ * Typically used for unit normals and tangents.
+ *
+ * The two most significant bits hold a fourth component with values -1, 0 or
+ * 1, which can store the handedness of a tangent frame.
+ */
+struct abcg::Snorm10x3 {
+  /** @brief Packed components. */
+  std::uint32_t bits{};
+
+  constexpr Snorm10x3() noexcept = default;
+  /** @brief Quantizes a vector with components in [-1, 1]. */
+  explicit Snorm10x3(glm::vec3 const &value, float w = 0.0f) noexcept
+      : bits{glm::packSnorm3x10_1x2(glm::vec4{value, w})} {}
+
+  /** @brief Converts back to floating point. */
+  [[nodiscard]] glm::vec4 unpack() const noexcept {
+    return glm::unpackSnorm3x10_1x2(bits);
+  }
+
+  friend bool operator==(Snorm10x3 const &, Snorm10x3 const &) = default;
+};
+
+/**
+ * @brief Maps an attribute type to its vertex format.
+ *
+ * Specialized for `float`, `glm::vec2`, `glm::vec3`, `glm::vec4` and the
+ * compact attribute types of this file.
+ *
+ * @tparam T Attribute type.
+ */
+template <typename T> struct abcg::VertexFormatOf {
+  static_assert(!std::is_same_v<T, T>, "Unsupported vertex attribute type");
+};
+
+/** @cond */
+template <> struct abcg::VertexFormatOf<float> {
+  static constexpr VertexFormat value{VertexFormat::Float32x1};
+};
+template <> struct abcg::VertexFormatOf<glm::vec2> {
+  static constexpr VertexFormat value{VertexFormat::Float32x2};
+};
+template <> struct abcg::VertexFormatOf<glm::vec3> {
+  static constexpr VertexFormat value{VertexFormat::Float32x3};
+};
+template <> struct abcg::VertexFormatOf<glm::vec4> {
+  static constexpr VertexFormat value{VertexFormat::Float32x4};
+};
+template <> struct abcg::VertexFormatOf<abcg::Float16x2> {
+  static constexpr VertexFormat value{VertexFormat::Float16x2};
+};
+template <> struct abcg::VertexFormatOf<abcg::Float16x4> {
+  static constexpr VertexFormat value{VertexFormat::Float16x4};
+};
+template <> struct abcg::VertexFormatOf<abcg::Snorm16x2> {
+  static constexpr VertexFormat value{VertexFormat::Snorm16x2};
+};
+template <> struct abcg::VertexFormatOf<abcg::Snorm16x4> {
+  static constexpr VertexFormat value{VertexFormat::Snorm16x4};
+};
+template <> struct abcg::VertexFormatOf<abcg::Unorm8x4> {
+  static constexpr VertexFormat value{VertexFormat::Unorm8x4};
+};
+template <> struct abcg::VertexFormatOf<abcg::Snorm10x3> {
+  static constexpr VertexFormat value{VertexFormat::Snorm10x3};
+};
+/** @endcond */
+
+/**
+ * @brief Attribute of a vertex layout.
+ */
+struct abcg::VertexAttribute {
+  /** @brief Shader input location. */
+  std::uint32_t location{};
+  /** @brief Format of the attribute. */
+  VertexFormat format{};
+  /** @brief Offset of the attribute within a vertex, in bytes. */
+  std::uint32_t offset{};
+
+  /**
+   * @brief Creates the description of an attribute of type `T`.
+   *
+   * @tparam T Attribute type, such as `decltype(Vertex::normal)`.
+   *
+   * @param location Shader input location.
+   * @param offset Offset of the attribute, usually `offsetof(Vertex, member)`.
+   *
+   * @return Attribute with the format of `T`.
+   */
+  template <typename T>
+  [[nodiscard]] static constexpr VertexAttribute
+  of(std::uint32_t location, std::size_t offset) noexcept {
+    return {.location = location,
+            .format = VertexFormatOf<std::remove_cv_t<T>>::value,
+            .offset = static_cast<std::uint32_t>(offset)};
+  }
+};
+
+/**
+ * @brief Layout of a vertex type, to be specialized for each vertex
+ * structure.
+ *
+ * A specialization must define a `static constexpr` array named `attributes`
+ * with an abcg::VertexAttribute for each member, built with
+ * abcg::VertexAttribute::of so that formats follow the member types:
+ *
+ * @code
+ * struct Vertex {
+ *   abcg::Float16x4 position;
+ *   abcg::Snorm10x3 normal;
+ *   abcg::Float16x2 texCoord;
+ * };
+ *
+ * template <> struct abcg::VertexLayout<Vertex> {
+ *   static constexpr std::array attributes{
+ *       VertexAttribute::of<decltype(Vertex::position)>(
+ *           0, offsetof(Vertex, position)),
+ *       VertexAttribute::of<decltype(Vertex::normal)>(
+ *           1, offsetof(Vertex, normal)),
+ *       VertexAttribute::of<decltype(Vertex::texCoord)>(
+ *           2, offsetof(Vertex, texCoord))};
+ * };
+ * @endcode
+ *
+ * The layout is then consumed by abcg::setupOpenGLVertexAttributes and
+ * abcg::getVulkanVertexAttributeDescriptions.
+ *
+ * @tparam Vertex Vertex type.
+ */
+template <typename Vertex> struct abcg::VertexLayout {};
+
+/**
+ * @brief Index array stored with the smallest index format that can address
+ * all vertices. Created by abcg::packIndices.
+ */
+struct abcg::PackedIndices {
+  /** @brief Format of the indices. */
+  IndexFormat format{IndexFormat::Uint32};
+  /** @brief Number of indices. */
+  std::size_t count{};
+  /** @brief Bytes of the index array, ready to be uploaded to an index
+   * buffer. */
+  std::vector<std::byte> data;
+};
+
+/**
+ * @brief Stores indices as 16-bit values when the vertex count allows it.
+ *
+ * @param indices Index array.
+ * @param vertexCount Number of vertices addressed by the indices.
+ *
+ * @return Indices in abcg::IndexFormat::Uint16 if `vertexCount` is at most
+ * 65535, or in abcg::IndexFormat::Uint32 otherwise. The value 65535 is not
+ * used as an index so that primitive restart remains available.
+ */
+inline abcg::PackedIndices
+abcg::packIndices(std::span<std::uint32_t const> indices,
+                  std::size_t vertexCount) {
+  PackedIndices packed{
+      .format = IndexFormat::Uint32, .count = indices.size(), .data = {}};
+  if (vertexCount <= std::numeric_limits<std::uint16_t>::max()) {
+    packed.format = IndexFormat::Uint16;
+    packed.data.resize(indices.size() * sizeof(std::uint16_t));
+    for (std::size_t index{}; index < indices.size(); ++index) {
+      auto const value{static_cast<std::uint16_t>(indices[index])};
+      std::memcpy(&packed.data[index * sizeof(value)], &value, sizeof(value));
+    }
+  } else {
+    auto const bytes{std::as_bytes(indices)};
+    packed.data.assign(bytes.begin(), bytes.end());
+  }
+  return packed;
+}
+
+#endif
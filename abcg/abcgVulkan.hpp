@@ -16,10 +16,14 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 
 #include "abcg.hpp"
+#include "abcgVulkanAllocator.hpp"
 #include "abcgVulkanBuffer.hpp"
 #include "abcgVulkanImage.hpp"
 #include "abcgVulkanPipeline.hpp"
 #include "abcgVulkanShader.hpp"
+#include "abcgVulkanTextureQueue.hpp"
+#include "abcgVulkanUploadContext.hpp"
+#include "abcgVulkanVertexLayout.hpp"
 #include "abcgVulkanWindow.hpp"
 
 #endif
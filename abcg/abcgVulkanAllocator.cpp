@@ -0,0 +1,499 @@
+/**
+ * @file abcgVulkanAllocator.cpp
+ * @brief Definition of abcg::VulkanAllocator members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgVulkanAllocator.hpp"
+
+#include <cppitertools/itertools.hpp>
+#include <fmt/core.h>
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <optional>
+
+#include "abcgException.hpp"
+
+namespace {
+[[nodiscard]] constexpr vk::DeviceSize alignUp(vk::DeviceSize value,
+                                               vk::DeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+[[nodiscard]] constexpr vk::DeviceSize alignDown(vk::DeviceSize value,
+                                                 vk::DeviceSize alignment) {
+  return value / alignment * alignment;
+}
+
+// Contiguous range of a memory block
+struct MemorySegment {
+  vk::DeviceSize offset{};
+  vk::DeviceSize size{};
+  // Kind of the resource using the range, or std::nullopt if free
+  std::optional<abcg::VulkanResourceKind> kind{};
+};
+} // namespace
+
+/**
+ * @brief Block of device memory divided into free and used ranges.
+ */
+struct abcg::VulkanMemoryBlock {
+  vk::DeviceMemory memory{};
+  vk::DeviceSize size{};
+  void *mappedData{};
+  uint32_t memoryTypeIndex{};
+  // Whether the block holds a single resource
+  bool dedicated{};
+  // Segments sorted by offset, covering the whole block. Adjacent free
+  // segments are always merged.
+  std::vector<MemorySegment> segments{};
+
+  // Returns the offset of a new range, or std::nullopt if it doesn't fit
+  [[nodiscard]] std::optional<vk::DeviceSize>
+  allocate(vk::DeviceSize rangeSize, vk::DeviceSize alignment,
+           VulkanResourceKind kind, vk::DeviceSize granularity);
+  void release(vk::DeviceSize offset);
+  [[nodiscard]] bool isEmpty() const noexcept;
+};
+
+std::optional<vk::DeviceSize>
+abcg::VulkanMemoryBlock::allocate(vk::DeviceSize rangeSize,
+                                  vk::DeviceSize alignment,
+                                  VulkanResourceKind kind,
+                                  vk::DeviceSize granularity) {
+  // Whether a used segment holds a resource of a kind other than `kind`
+  auto const conflicts{[kind](MemorySegment const &segment) {
+    return segment.kind.has_value() && *segment.kind != kind;
+  }};
+  auto const samePage{[granularity](vk::DeviceSize lhs, vk::DeviceSize rhs) {
+    return lhs / granularity == rhs / granularity;
+  }};
+
+  // First fit
+  for (auto const index : iter::range(segments.size())) {
+    auto const segment{segments[index]};
+    if (segment.kind.has_value() || segment.size < rangeSize) {
+      continue;
+    }
+
+    auto offset{alignUp(segment.offset, alignment)};
+
+    // Linear and optimal resources must not share a page of
+    // bufferImageGranularity bytes
+    if (index > 0) {
+      auto const &previous{segments[index - 1]};
+      if (conflicts(previous) &&
+          samePage(previous.offset + previous.size - 1, offset)) {
+        offset = alignUp(offset, granularity);
+      }
+    }
+    auto const end{offset + rangeSize};
+    if (end > segment.offset + segment.size) {
+      continue;
+    }
+    if (index + 1 < segments.size()) {
+      auto const &next{segments[index + 1]};
+      if (conflicts(next) && samePage(end - 1, next.offset)) {
+        continue;
+      }
+    }
+
+    // Split the free segment into [padding] used [remainder]
+    std::vector<MemorySegment> parts;
+    if (offset > segment.offset) {
+      parts.push_back({.offset = segment.offset,
+                       .size = offset - segment.offset,
+                       .kind = std::nullopt});
+    }
+    parts.push_back({.offset = offset, .size = rangeSize, .kind = kind});
+    if (auto const segmentEnd{segment.offset + segment.size};
+        end < segmentEnd) {
+      parts.push_back(
+          {.offset = end, .size = segmentEnd - end, .kind = std::nullopt});
+    }
+    auto const position{
+        segments.erase(segments.begin() + gsl::narrow<std::ptrdiff_t>(index))};
+    segments.insert(position, parts.begin(), parts.end());
+
+    return offset;
+  }
+
+  return std::nullopt;
+}
+
+void abcg::VulkanMemoryBlock::release(vk::DeviceSize offset) {
+  auto segment{std::ranges::lower_bound(segments, offset, {},
+                                        &MemorySegment::offset)};
+  if (segment == segments.end() || segment->offset != offset ||
+      !segment->kind.has_value()) {
+    throw abcg::RuntimeError("Invalid device memory range");
+  }
+  segment->kind.reset();
+
+  // Merge with the next segment
+  if (auto next{std::next(segment)};
+      next != segments.end() && !next->kind.has_value()) {
+    segment->size += next->size;
+    segment = std::prev(segments.erase(next));
+  }
+  // Merge with the previous segment
+  if (segment != segments.begin()) {
+    if (auto previous{std::prev(segment)}; !previous->kind.has_value()) {
+      previous->size += segment->size;
+      segments.erase(segment);
+    }
+  }
+}
+
+bool abcg::VulkanMemoryBlock::isEmpty() const noexcept {
+  return segments.size() == 1 && !segments.front().kind.has_value();
+}
+
+/**
+ * @brief Returns the external fragmentation of the free memory.
+ *
+ * @return Value in the range [0, 1]. 0 means that all free memory is in a
+ * single range. Values close to 1 mean that the free memory is scattered in
+ * many small ranges.
+ */
+double abcg::VulkanMemoryStats::getFragmentation() const noexcept {
+  auto const bytesFree{bytesReserved - bytesUsed};
+  if (bytesFree == 0) {
+    return 0.0;
+  }
+  return 1.0 - static_cast<double>(largestFreeRange) /
+                   static_cast<double>(bytesFree);
+}
+
+abcg::VulkanAllocator::VulkanAllocator() = default;
+
+abcg::VulkanAllocator::~VulkanAllocator() = default;
+
+/**
+ * @brief Initializes the allocator.
+ *
+ * No device memory is allocated until the first call to
+ * abcg::VulkanAllocator::allocate.
+ *
+ * @param device Logical device used to allocate memory.
+ * @param physicalDevice Physical device of `device`.
+ * @param blockSize Size of the blocks, in bytes. Blocks are made smaller on
+ * small memory heaps.
+ */
+void abcg::VulkanAllocator::create(vk::Device const &device,
+                                   VulkanPhysicalDevice const &physicalDevice,
+                                   vk::DeviceSize blockSize) {
+  m_device = device;
+  m_physicalDevice = physicalDevice;
+
+  auto const &vkPhysicalDevice{
+      static_cast<vk::PhysicalDevice>(m_physicalDevice)};
+  m_memoryProperties = vkPhysicalDevice.getMemoryProperties();
+  auto const properties{vkPhysicalDevice.getProperties()};
+  auto const &limits{properties.limits};
+  m_bufferImageGranularity =
+      std::max(limits.bufferImageGranularity, vk::DeviceSize{1});
+  m_nonCoherentAtomSize =
+      std::max(limits.nonCoherentAtomSize, vk::DeviceSize{1});
+  m_blockSize = blockSize;
+
+  m_blocks.clear();
+  m_blocks.resize(m_memoryProperties.memoryTypeCount);
+}
+
+/**
+ * @brief Releases all device memory.
+ *
+ * Resources still bound to memory from this allocator must be destroyed
+ * before calling this function.
+ */
+void abcg::VulkanAllocator::destroy() {
+  std::scoped_lock const lock{m_mutex};
+
+  std::size_t leaked{};
+  for (auto &blocks : m_blocks) {
+    for (auto &block : blocks) {
+      leaked += gsl::narrow<std::size_t>(std::ranges::count_if(
+          block->segments,
+          [](auto const &segment) { return segment.kind.has_value(); }));
+      destroyBlock(*block);
+    }
+  }
+  m_blocks.clear();
+
+  if (leaked > 0) {
+    fmt::print("Warning: {} device memory allocations were not freed\n",
+               leaked);
+  }
+}
+
+/**
+ * @brief Allocates a range of device memory.
+ *
+ * @param requirements Size, alignment, and allowed memory types of the range.
+ * @param properties Required memory properties.
+ * @param kind Kind of resource that will be bound to the range.
+ *
+ * @throw abcg::RuntimeError if no memory type satisfies the requirements.
+ * @throw vk::SystemError if device memory could not be allocated.
+ *
+ * @return Allocated range. It must be released with
+ * abcg::VulkanAllocator::free.
+ */
+abcg::VulkanAllocation
+abcg::VulkanAllocator::allocate(vk::MemoryRequirements const &requirements,
+                                vk::MemoryPropertyFlags properties,
+                                VulkanResourceKind kind) {
+  auto const memoryTypeIndex{m_physicalDevice.findMemoryType(
+      requirements.memoryTypeBits, properties)};
+  if (!memoryTypeIndex.has_value()) {
+    throw abcg::RuntimeError("Failed to find suitable memory type");
+  }
+
+  std::scoped_lock const lock{m_mutex};
+  auto &blocks{m_blocks.at(*memoryTypeIndex)};
+
+  auto const makeAllocation{[memoryTypeIndex](VulkanMemoryBlock &block,
+                                              vk::DeviceSize offset,
+                                              vk::DeviceSize size) {
+    return VulkanAllocation{
+        .memory = block.memory,
+        .offset = offset,
+        .size = size,
+        .mappedData = block.mappedData == nullptr
+                          ? nullptr
+                          : static_cast<char *>(block.mappedData) + offset,
+        .memoryTypeIndex = *memoryTypeIndex,
+        .block = &block};
+  }};
+
+  // Large resources get a block of their own
+  if (requirements.size > m_blockSize / 2) {
+    auto &block{*blocks.emplace_back(
+        createBlock(*memoryTypeIndex, requirements.size))};
+    block.dedicated = true;
+    auto const offset{
+        block.allocate(requirements.size, 1, kind, m_bufferImageGranularity)};
+    return makeAllocation(block, offset.value(), requirements.size);
+  }
+
+  auto const alignment{std::max(requirements.alignment, vk::DeviceSize{1})};
+  for (auto &block : blocks) {
+    if (block->dedicated) {
+      continue;
+    }
+    if (auto const offset{block->allocate(requirements.size, alignment, kind,
+                                          m_bufferImageGranularity)}) {
+      return makeAllocation(*block, *offset, requirements.size);
+    }
+  }
+
+  // Keep blocks small on small heaps (e.g., host visible device local memory)
+  auto const heapIndex{
+      m_memoryProperties.memoryTypes.at(*memoryTypeIndex).heapIndex};
+  auto const heapSize{m_memoryProperties.memoryHeaps.at(heapIndex).size};
+  auto const blockSize{std::max(std::min(m_blockSize, heapSize / 8),
+                                alignUp(requirements.size, alignment))};
+
+  auto &block{*blocks.emplace_back(createBlock(*memoryTypeIndex, blockSize))};
+  auto const offset{block.allocate(requirements.size, alignment, kind,
+                                   m_bufferImageGranularity)};
+  return makeAllocation(block, offset.value(), requirements.size);
+}
+
+/**
+ * @brief Allocates device memory for a buffer and binds it to the buffer.
+ *
+ * @param buffer Buffer object.
+ * @param properties Required memory properties.
+ *
+ * @return Allocated range. It must be released with
+ * abcg::VulkanAllocator::free after the buffer is destroyed.
+ */
+abcg::VulkanAllocation
+abcg::VulkanAllocator::allocateForBuffer(vk::Buffer const &buffer,
+                                         vk::MemoryPropertyFlags properties) {
+  auto const allocation{allocate(m_device.getBufferMemoryRequirements(buffer),
+                                 properties, VulkanResourceKind::Linear)};
+  m_device.bindBufferMemory(buffer, allocation.memory, allocation.offset);
+  return allocation;
+}
+
+/**
+ * @brief Allocates device memory for an image and binds it to the image.
+ *
+ * @param image Image object.
+ * @param tiling Tiling used to create the image.
+ * @param properties Required memory properties.
+ *
+ * @return Allocated range. It must be released with
+ * abcg::VulkanAllocator::free after the image is destroyed.
+ */
+abcg::VulkanAllocation
+abcg::VulkanAllocator::allocateForImage(vk::Image const &image,
+                                        vk::ImageTiling tiling,
+                                        vk::MemoryPropertyFlags properties) {
+  auto const allocation{allocate(m_device.getImageMemoryRequirements(image),
+                                 properties,
+                                 tiling == vk::ImageTiling::eOptimal
+                                     ? VulkanResourceKind::Optimal
+                                     : VulkanResourceKind::Linear)};
+  m_device.bindImageMemory(image, allocation.memory, allocation.offset);
+  return allocation;
+}
+
+/**
+ * @brief Releases a range of device memory.
+ *
+ * Empty blocks are returned to the device, except for the last block of each
+ * memory type.
+ *
+ * @param allocation Range returned by abcg::VulkanAllocator::allocate. It is
+ * reset to an empty range. Calling this function with an empty range does
+ * nothing.
+ */
+void abcg::VulkanAllocator::free(VulkanAllocation &allocation) {
+  if (allocation.block == nullptr) {
+    return;
+  }
+
+  std::scoped_lock const lock{m_mutex};
+  auto &block{*allocation.block};
+  block.release(allocation.offset);
+
+  if (block.isEmpty()) {
+    auto &blocks{m_blocks.at(block.memoryTypeIndex)};
+    auto const sharedBlocks{std::ranges::count_if(
+        blocks, [](auto const &other) { return !other->dedicated; })};
+    if (block.dedicated || sharedBlocks > 1) {
+      destroyBlock(block);
+      std::erase_if(blocks, [&block](auto const &other) {
+        return other.get() == &block;
+      });
+    }
+  }
+
+  allocation = {};
+}
+
+/**
+ * @brief Makes host writes to a range visible to the device.
+ *
+ * This is only needed for memory types without the `eHostCoherent` property.
+ * For coherent memory, the function does nothing.
+ *
+ * @param allocation Host visible range.
+ * @param offset Offset from the beginning of the range.
+ * @param size Number of bytes to flush, or `VK_WHOLE_SIZE` to flush up to the
+ * end of the range.
+ */
+void abcg::VulkanAllocator::flush(VulkanAllocation const &allocation,
+                                  vk::DeviceSize offset,
+                                  vk::DeviceSize size) const {
+  if (allocation.block == nullptr || isCoherent(allocation.memoryTypeIndex)) {
+    return;
+  }
+
+  // The range must be a multiple of nonCoherentAtomSize, or end at the end of
+  // the memory object
+  auto const begin{
+      alignDown(allocation.offset + offset, m_nonCoherentAtomSize)};
+  auto const end{std::min(
+      alignUp(allocation.offset +
+                  (size == VK_WHOLE_SIZE ? allocation.size : offset + size),
+              m_nonCoherentAtomSize),
+      allocation.block->size)};
+  vk::MappedMemoryRange const range{
+      .memory = allocation.memory, .offset = begin, .size = end - begin};
+  m_device.flushMappedMemoryRanges(range);
+}
+
+/**
+ * @brief Returns whether a memory type is host coherent.
+ *
+ * @param memoryTypeIndex Index of the memory type.
+ *
+ * @return `true` if host writes are visible to the device without
+ * abcg::VulkanAllocator::flush; `false` otherwise.
+ */
+bool abcg::VulkanAllocator::isCoherent(
+    uint32_t memoryTypeIndex) const noexcept {
+  return (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags &
+          vk::MemoryPropertyFlagBits::eHostCoherent) ==
+         vk::MemoryPropertyFlagBits::eHostCoherent;
+}
+
+/**
+ * @brief Returns usage and fragmentation statistics.
+ *
+ * @return Statistics of each memory type and of all memory types combined.
+ */
+abcg::VulkanAllocatorStats abcg::VulkanAllocator::getStats() const {
+  std::scoped_lock const lock{m_mutex};
+
+  VulkanAllocatorStats stats;
+  stats.memoryTypes.resize(m_blocks.size());
+  for (auto &&[memoryTypeIndex, blocks] : iter::enumerate(m_blocks)) {
+    auto &typeStats{stats.memoryTypes[memoryTypeIndex]};
+    for (auto const &block : blocks) {
+      ++typeStats.blockCount;
+      typeStats.bytesReserved += block->size;
+      for (auto const &segment : block->segments) {
+        if (segment.kind.has_value()) {
+          ++typeStats.allocationCount;
+          typeStats.bytesUsed += segment.size;
+        } else {
+          ++typeStats.freeRangeCount;
+          typeStats.largestFreeRange =
+              std::max(typeStats.largestFreeRange, segment.size);
+        }
+      }
+    }
+
+    auto &total{stats.total};
+    total.blockCount += typeStats.blockCount;
+    total.allocationCount += typeStats.allocationCount;
+    total.bytesReserved += typeStats.bytesReserved;
+    total.bytesUsed += typeStats.bytesUsed;
+    total.freeRangeCount += typeStats.freeRangeCount;
+    total.largestFreeRange =
+        std::max(total.largestFreeRange, typeStats.largestFreeRange);
+  }
+  return stats;
+}
+
+std::unique_ptr<abcg::VulkanMemoryBlock>
+abcg::VulkanAllocator::createBlock(uint32_t memoryTypeIndex,
+                                   vk::DeviceSize size) const {
+  auto block{std::make_unique<VulkanMemoryBlock>()};
+  block->memory = m_device.allocateMemory(
+      {.allocationSize = size, .memoryTypeIndex = memoryTypeIndex});
+  block->size = size;
+  block->memoryTypeIndex = memoryTypeIndex;
+  block->segments.push_back({.offset = 0, .size = size, .kind = std::nullopt});
+
+  // Host visible blocks stay mapped until destroyed, since a memory object
+  // cannot be mapped more than once at a time
+  if (auto const flags{
+          m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags};
+      flags & vk::MemoryPropertyFlagBits::eHostVisible) {
+    block->mappedData =
+        m_device.mapMemory(block->memory, vk::DeviceSize{0}, VK_WHOLE_SIZE);
+  }
+
+  return block;
+}
+
+void abcg::VulkanAllocator::destroyBlock(VulkanMemoryBlock &block) const {
+  if (block.mappedData != nullptr) {
+    m_device.unmapMemory(block.memory);
+    block.mappedData = nullptr;
+  }
+  m_device.freeMemory(block.memory);
+  block.memory = vk::DeviceMemory{};
+}
@@ -0,0 +1,164 @@
+/**
+ * @file abcgVulkanAllocator.hpp
+ * @brief Header file of abcg::VulkanAllocator.
+ *
+ * Declaration of abcg::VulkanAllocator and related types.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_VULKAN_ALLOCATOR_HPP_
+#define ABCG_VULKAN_ALLOCATOR_HPP_
+
+#include "abcgVulkanPhysicalDevice.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace abcg {
+enum class VulkanResourceKind;
+struct VulkanAllocation;
+struct VulkanMemoryStats;
+struct VulkanAllocatorStats;
+class VulkanAllocator;
+struct VulkanMemoryBlock;
+} // namespace abcg
+
+/**
+ * @brief Kind of resource bound to a memory allocation.
+ *
+ * Linear and optimal resources placed next to each other in the same block
+ * are kept `bufferImageGranularity` bytes apart.
+ */
+enum class abcg::VulkanResourceKind {
+  /** @brief Buffer or image with linear tiling. */
+  Linear,
+  /** @brief Image with optimal tiling. */
+  Optimal
+};
+
+/**
+ * @brief Range of device memory handed out by abcg::VulkanAllocator.
+ */
+struct abcg::VulkanAllocation {
+  /** @brief Device memory object of the block containing the range. */
+  vk::DeviceMemory memory{};
+  /** @brief Offset of the range from the beginning of the device memory. */
+  vk::DeviceSize offset{};
+  /** @brief Size of the range, in bytes. */
+  vk::DeviceSize size{};
+  /** @brief Host address of the beginning of the range, or `nullptr` if the
+   * memory is not host visible. */
+  void *mappedData{};
+  /** @brief Index of the memory type of the range. */
+  uint32_t memoryTypeIndex{};
+  /** @brief Block containing the range. For internal use. */
+  VulkanMemoryBlock *block{};
+};
+
+/**
+ * @brief Usage statistics of device memory.
+ *
+ * @sa abcg::VulkanAllocator::getStats.
+ */
+struct abcg::VulkanMemoryStats {
+  /** @brief Number of device memory objects (blocks). */
+  std::size_t blockCount{};
+  /** @brief Number of live allocations. */
+  std::size_t allocationCount{};
+  /** @brief Total size of the blocks, in bytes. */
+  vk::DeviceSize bytesReserved{};
+  /** @brief Total size of the live allocations, in bytes. */
+  vk::DeviceSize bytesUsed{};
+  /** @brief Number of free ranges between allocations. */
+  std::size_t freeRangeCount{};
+  /** @brief Size of the largest free range, in bytes. */
+  vk::DeviceSize largestFreeRange{};
+
+  [[nodiscard]] double getFragmentation() const noexcept;
+};
+
+/**
+ * @brief Usage statistics of an abcg::VulkanAllocator.
+ */
+struct abcg::VulkanAllocatorStats {
+  /** @brief Statistics of each memory type, indexed by memory type index. */
+  std::vector<VulkanMemoryStats> memoryTypes{};
+  /** @brief Statistics of all memory types combined. */
+  VulkanMemoryStats total{};
+};
+
+/**
+ * @brief Device memory sub-allocator.
+ *
+ * Instead of calling `vkAllocateMemory` for each resource, this class
+ * allocates large blocks of device memory for each memory type and hands out
+ * aligned ranges of them. This keeps the number of device memory objects well
+ * below `maxMemoryAllocationCount`, and makes most allocations a CPU-only
+ * operation.
+ *
+ * Host visible blocks are persistently mapped. Resources larger than half the
+ * block size get a block of their own.
+ *
+ * abcg::VulkanDevice owns an allocator that is used by abcg::VulkanBuffer and
+ * abcg::VulkanImage. Its functions are thread-safe.
+ *
+ * @sa abcg::VulkanDevice::getAllocator.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::VulkanAllocator {
+public:
+  /** @brief Default size of the blocks, in bytes. */
+  static constexpr vk::DeviceSize defaultBlockSize{64ULL * 1024 * 1024};
+
+  VulkanAllocator();
+  VulkanAllocator(VulkanAllocator const &) = delete;
+  VulkanAllocator(VulkanAllocator &&) = delete;
+  VulkanAllocator &operator=(VulkanAllocator const &) = delete;
+  VulkanAllocator &operator=(VulkanAllocator &&) = delete;
+  ~VulkanAllocator();
+
+  void create(vk::Device const &device,
+              VulkanPhysicalDevice const &physicalDevice,
+              vk::DeviceSize blockSize = defaultBlockSize);
+  void destroy();
+
+  [[nodiscard]] VulkanAllocation
+  allocate(vk::MemoryRequirements const &requirements,
+           vk::MemoryPropertyFlags properties, VulkanResourceKind kind);
+  [[nodiscard]] VulkanAllocation
+  allocateForBuffer(vk::Buffer const &buffer,
+                    vk::MemoryPropertyFlags properties);
+  [[nodiscard]] VulkanAllocation
+  allocateForImage(vk::Image const &image, vk::ImageTiling tiling,
+                   vk::MemoryPropertyFlags properties);
+  void free(VulkanAllocation &allocation);
+  void flush(VulkanAllocation const &allocation, vk::DeviceSize offset = 0,
+             vk::DeviceSize size = VK_WHOLE_SIZE) const;
+
+  [[nodiscard]] bool isCoherent(uint32_t memoryTypeIndex) const noexcept;
+  [[nodiscard]] VulkanAllocatorStats getStats() const;
+
+private:
+  [[nodiscard]] std::unique_ptr<VulkanMemoryBlock>
+  createBlock(uint32_t memoryTypeIndex, vk::DeviceSize size) const;
+  void destroyBlock(VulkanMemoryBlock &block) const;
+
+  vk::Device m_device;
+  VulkanPhysicalDevice m_physicalDevice;
+  vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+  vk::DeviceSize m_bufferImageGranularity{1};
+  vk::DeviceSize m_nonCoherentAtomSize{1};
+  vk::DeviceSize m_blockSize{defaultBlockSize};
+
+  // Blocks of each memory type
+  std::vector<std::vector<std::unique_ptr<VulkanMemoryBlock>>> m_blocks;
+  mutable std::mutex m_mutex;
+};
+
+#endif
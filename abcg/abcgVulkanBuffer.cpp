@@ -10,6 +10,7 @@
 
 #include "abcgVulkanBuffer.hpp"
 
+#include <cppitertools/itertools.hpp>
 #include <gsl/gsl>
 
 #include <set>
@@ -19,53 +20,69 @@
 void abcg::VulkanBuffer::create(VulkanDevice const &device,
                                 VulkanBufferCreateInfo const &createInfo) {
   m_device = static_cast<vk::Device>(device);
+  m_allocator = &device.getAllocator();
+  m_size = createInfo.size;
+  m_ringStride = createInfo.size;
+  m_ringSize = 1;
 
   if (createInfo.properties & vk::MemoryPropertyFlagBits::eHostVisible) {
-    std::tie(m_buffer, m_deviceMemory) = createBuffer(
-        device, createInfo.size, createInfo.usage, createInfo.properties);
+    // Align the regions of the ring for use as dynamic offsets, and for
+    // flushing one region without touching the others
+    m_ringSize = std::max(createInfo.ringSize, 1U);
+    if (m_ringSize > 1) {
+      auto const limits{
+          static_cast<vk::PhysicalDevice>(device.getPhysicalDevice())
+              .getProperties()
+              .limits};
+      auto alignment{limits.nonCoherentAtomSize};
+      if (createInfo.usage & vk::BufferUsageFlagBits::eUniformBuffer) {
+        alignment =
+            std::max(alignment, limits.minUniformBufferOffsetAlignment);
+      }
+      if (createInfo.usage & vk::BufferUsageFlagBits::eStorageBuffer) {
+        alignment =
+            std::max(alignment, limits.minStorageBufferOffsetAlignment);
+      }
+      alignment = std::max(alignment, vk::DeviceSize{1});
+      m_ringStride = (createInfo.size + alignment - 1) / alignment * alignment;
+    }
+
+    std::tie(m_buffer, m_allocation) =
+        createBuffer(device, m_ringStride * m_ringSize, createInfo.usage,
+                     createInfo.properties);
 
     if (createInfo.data.has_value()) {
-      loadData(createInfo.data.value(), createInfo.size);
+      for (auto const ringIndex : iter::range(m_ringSize)) {
+        loadData(createInfo.data.value(), createInfo.size,
+                 getRingOffset(ringIndex));
+      }
     }
   } else if (createInfo.data.has_value()) {
-    // Use a staging buffer for mapping, and a device local buffer as the final
-    // destination
-    auto [stagingBuffer, stagingBufferMemory]{createBuffer(
-        device, createInfo.size, vk::BufferUsageFlagBits::eTransferSrc,
-        vk::MemoryPropertyFlagBits::eHostVisible |
-            vk::MemoryPropertyFlagBits::eHostCoherent)};
-
-    // Copy data to mapped staging buffer
-    // Transfer of data to the GPU will happen in the background before the next
-    // call to vkQueueSubmit
-    void *data{m_device.mapMemory(stagingBufferMemory, vk::DeviceSize{0},
-                                  createInfo.size)};
-    memcpy(data, createInfo.data->get(), createInfo.size);
-    m_device.unmapMemory(stagingBufferMemory);
-
     // Create buffer in device local memory
-    std::tie(m_buffer, m_deviceMemory) =
+    std::tie(m_buffer, m_allocation) =
         createBuffer(device, createInfo.size,
                      createInfo.usage | vk::BufferUsageFlagBits::eTransferDst,
                      vk::MemoryPropertyFlagBits::eDeviceLocal);
 
-    // Copy from staging buffer to device local buffer
-    device.withCommandBuffer(
-        [this, &stagingBuffer, &createInfo](const auto &commandBuffer) {
-          commandBuffer.copyBuffer(stagingBuffer, m_buffer,
-                                   {{.size = createInfo.size}});
-        },
-        vk::QueueFlagBits::eTransfer);
-
-    // Release staging buffer
-    m_device.destroyBuffer(stagingBuffer);
-    m_device.freeMemory(stagingBufferMemory);
+    // Copy through the staging memory of the upload context
+    m_upload = device.getUploadContext().uploadBuffer(
+        m_buffer,
+        {static_cast<std::byte const *>(createInfo.data->get()),
+         gsl::narrow<std::size_t>(createInfo.size)});
+    if (!createInfo.asyncUpload) {
+      m_upload.wait();
+    }
   }
 }
 
 void abcg::VulkanBuffer::destroy() {
+  // The buffer must not be in use by a pending upload
+  m_upload.wait();
+  m_upload = {};
   m_device.destroyBuffer(m_buffer);
-  m_device.freeMemory(m_deviceMemory);
+  if (m_allocator != nullptr) {
+    m_allocator->free(m_allocation);
+  }
 }
 
 /**
@@ -74,17 +91,37 @@ void abcg::VulkanBuffer::destroy() {
  * @param data Pointer to the beginning of the data.
  * @param size Size of the data fo the copied, in bytes.
  * @param offset Offset from the beginning of the buffer memory.
+ *
+ * @throw abcg::RuntimeError if the buffer memory is not host visible.
  */
 void abcg::VulkanBuffer::loadData(gsl::not_null<void const *> data,
                                   vk::DeviceSize size, vk::DeviceSize offset) {
+  if (m_allocation.mappedData == nullptr) {
+    throw abcg::RuntimeError("Buffer memory is not host visible");
+  }
+
   // Transfer of data to the GPU will happen in the background before the next
   // call to vkQueueSubmit
-  auto *mappedData{m_device.mapMemory(m_deviceMemory, offset, size)};
-  memcpy(mappedData, data, size);
-  m_device.unmapMemory(m_deviceMemory);
+  memcpy(static_cast<char *>(m_allocation.mappedData) + offset, data, size);
+  m_allocator->flush(m_allocation, offset, size);
+}
+
+/**
+ * @brief Makes host writes to a region of the ring visible to the device.
+ *
+ * This is needed after writing through abcg::VulkanBuffer::getMappedSpan or
+ * abcg::VulkanBuffer::getMappedData, unless the memory is host coherent. For
+ * coherent memory, the function does nothing.
+ *
+ * @param ringIndex Index of the region of the ring.
+ */
+void abcg::VulkanBuffer::flush(uint32_t ringIndex) const {
+  if (m_allocator != nullptr) {
+    m_allocator->flush(m_allocation, getRingOffset(ringIndex), m_size);
+  }
 }
 
-std::pair<vk::Buffer, vk::DeviceMemory> abcg::VulkanBuffer::createBuffer(
+std::pair<vk::Buffer, abcg::VulkanAllocation> abcg::VulkanBuffer::createBuffer(
     VulkanDevice const &device, vk::DeviceSize size, vk::BufferUsageFlags usage,
     vk::MemoryPropertyFlags properties) const {
   auto const &physicalDevice{device.getPhysicalDevice()};
@@ -111,23 +148,11 @@ std::pair<vk::Buffer, vk::DeviceMemory> abcg::VulkanBuffer::createBuffer(
            gsl::narrow<uint32_t>(queueFamilyIndices.size()),
        .pQueueFamilyIndices = queueFamilyIndices.data()})};
 
-  // Get memory requirements
-  auto const memoryRequirements{m_device.getBufferMemoryRequirements(buffer)};
-
-  // Allocate buffer memory
-  auto const memoryType{physicalDevice.findMemoryType(
-      memoryRequirements.memoryTypeBits, properties)};
-  if (!memoryType.has_value()) {
-    throw abcg::RuntimeError("Failed to find suitable memory type");
-  }
-  auto bufferMemory{
-      m_device.allocateMemory({.allocationSize = memoryRequirements.size,
-                               .memoryTypeIndex = memoryType.value()})};
+  // Allocate buffer memory from a shared block and bind it to the buffer
+  auto const allocation{
+      device.getAllocator().allocateForBuffer(buffer, properties)};
 
-  // Associate buffer memory to buffer
-  m_device.bindBufferMemory(buffer, bufferMemory, 0);
-
-  return {buffer, bufferMemory};
+  return {buffer, allocation};
 }
 
 /**
@@ -144,5 +169,76 @@ abcg::VulkanBuffer::operator vk::Buffer const &() const noexcept {
  * @return Device memory object.
  */
 vk::DeviceMemory const &abcg::VulkanBuffer::getDeviceMemory() const noexcept {
-  return m_deviceMemory;
+  return m_allocation.memory;
+}
+
+/**
+ * @brief Returns the range of device memory bound to the buffer.
+ *
+ * The device memory object returned by abcg::VulkanBuffer::getDeviceMemory is
+ * shared with other resources. The buffer starts at
+ * abcg::VulkanAllocation::offset.
+ *
+ * @return Memory range.
+ */
+abcg::VulkanAllocation const &
+abcg::VulkanBuffer::getAllocation() const noexcept {
+  return m_allocation;
+}
+
+/**
+ * @brief Returns the handle to the upload of the initial data of the buffer.
+ *
+ * The handle is only meaningful for buffers created with data in device local
+ * memory and abcg::VulkanBufferCreateInfo::asyncUpload set to `true`. The
+ * buffer must not be used by the device before the upload completes.
+ *
+ * @return Upload handle.
+ */
+abcg::VulkanUploadHandle const &abcg::VulkanBuffer::getUpload() const noexcept {
+  return m_upload;
+}
+
+/**
+ * @brief Returns the host address of a region of the buffer.
+ *
+ * The address is valid until the buffer is destroyed.
+ *
+ * @param ringIndex Index of the region of the ring.
+ *
+ * @throw abcg::RuntimeError if the buffer memory is not host visible.
+ *
+ * @return Pointer to the beginning of the region.
+ */
+void *abcg::VulkanBuffer::getMappedData(uint32_t ringIndex) const {
+  if (m_allocation.mappedData == nullptr) {
+    throw abcg::RuntimeError("Buffer memory is not host visible");
+  }
+  return static_cast<char *>(m_allocation.mappedData) +
+         getRingOffset(ringIndex);
+}
+
+/**
+ * @brief Returns the offset of a region of the ring from the beginning of the
+ * buffer.
+ *
+ * Use it as the dynamic offset of a uniform or storage buffer descriptor, or
+ * as the offset of a vertex buffer binding.
+ *
+ * @param ringIndex Index of the region. Indices wrap around the ring size.
+ *
+ * @return Offset in bytes.
+ */
+vk::DeviceSize abcg::VulkanBuffer::getRingOffset(uint32_t ringIndex) const {
+  return (ringIndex % m_ringSize) * m_ringStride;
+}
+
+/**
+ * @brief Returns the number of regions of the ring.
+ *
+ * @return Value of abcg::VulkanBufferCreateInfo::ringSize used to create a
+ * host visible buffer, or 1 for other buffers.
+ */
+uint32_t abcg::VulkanBuffer::getRingSize() const noexcept {
+  return m_ringSize;
 }
\ No newline at end of file
@@ -13,10 +13,15 @@
 #ifndef ABCG_VULKAN_BUFFER_HPP_
 #define ABCG_VULKAN_BUFFER_HPP_
 
+#include "abcgVulkanAllocator.hpp"
 #include "abcgVulkanDevice.hpp"
+#include "abcgVulkanUploadContext.hpp"
 
+#include <gsl/gsl_util>
 #include <gsl/pointers>
 
+#include <span>
+
 namespace abcg {
 struct VulkanBufferCreateInfo;
 class VulkanBuffer;
@@ -26,10 +31,22 @@ class VulkanBuffer;
  * @brief Creation info structure for abcg::VulkanBuffer::create.
  */
 struct abcg::VulkanBufferCreateInfo {
+  /** @brief Size of the buffer, or of each region of the ring, in bytes. */
   vk::DeviceSize size{};
   vk::BufferUsageFlags usage{};
   vk::MemoryPropertyFlags properties{};
   std::optional<gsl::not_null<void const *>> data{};
+  /** @brief Whether abcg::VulkanBuffer::create returns without waiting for
+   * the data to be copied to device local memory. Use
+   * abcg::VulkanBuffer::getUpload to check for completion. */
+  bool asyncUpload{};
+  /** @brief Number of regions of `size` bytes in a host visible buffer.
+   *
+   * Use one region per frame in flight to update per-frame data without
+   * waiting for the device. Regions are aligned for use as dynamic uniform or
+   * storage buffer offsets. See abcg::VulkanBuffer::getRingOffset. The initial
+   * data, if any, is copied to every region. */
+  uint32_t ringSize{1};
 };
 
 /**
@@ -37,6 +54,11 @@ struct abcg::VulkanBufferCreateInfo {
  *
  * This class provides helper functions for creating and managing vk::Buffer
  * objects.
+ *
+ * Host visible buffers are persistently mapped: they can be written through
+ * abcg::VulkanBuffer::getMappedSpan at any time, without map calls. Writes to
+ * memory that is not host coherent must be followed by a call to
+ * abcg::VulkanBuffer::flush.
  */
 class abcg::VulkanBuffer {
 public:
@@ -45,20 +67,52 @@ public:
   void destroy();
   void loadData(gsl::not_null<void const *> data, vk::DeviceSize size,
                 vk::DeviceSize offset = 0UL);
+  void flush(uint32_t ringIndex = 0) const;
+
+  template <typename T>
+  [[nodiscard]] std::span<T> getMappedSpan(uint32_t ringIndex = 0) const;
 
   explicit operator vk::Buffer const &() const noexcept;
 
   [[nodiscard]] vk::DeviceMemory const &getDeviceMemory() const noexcept;
+  [[nodiscard]] VulkanAllocation const &getAllocation() const noexcept;
+  [[nodiscard]] VulkanUploadHandle const &getUpload() const noexcept;
+  [[nodiscard]] void *getMappedData(uint32_t ringIndex = 0) const;
+  [[nodiscard]] vk::DeviceSize getRingOffset(uint32_t ringIndex) const;
+  [[nodiscard]] uint32_t getRingSize() const noexcept;
 
 private:
-  [[nodiscard]] std::pair<vk::Buffer, vk::DeviceMemory>
+  [[nodiscard]] std::pair<vk::Buffer, VulkanAllocation>
   createBuffer(VulkanDevice const &device, vk::DeviceSize size,
                vk::BufferUsageFlags usage,
                vk::MemoryPropertyFlags properties) const;
 
   vk::Buffer m_buffer;
-  vk::DeviceMemory m_deviceMemory;
+  VulkanAllocation m_allocation;
+  VulkanAllocator *m_allocator{};
+  VulkanUploadHandle m_upload;
+  vk::DeviceSize m_size{};
+  // Distance between the beginning of consecutive regions of the ring
+  vk::DeviceSize m_ringStride{};
+  uint32_t m_ringSize{1};
   vk::Device m_device;
 };
 
+/**
+ * @brief Returns a typed view of a region of the mapped buffer memory.
+ *
+ * @tparam T Element type.
+ *
+ * @param ringIndex Index of the region of the ring.
+ *
+ * @throw abcg::RuntimeError if the buffer memory is not host visible.
+ *
+ * @return Span of the elements of type `T` that fit in the region.
+ */
+template <typename T>
+std::span<T> abcg::VulkanBuffer::getMappedSpan(uint32_t ringIndex) const {
+  return {static_cast<T *>(getMappedData(ringIndex)),
+          gsl::narrow<std::size_t>(m_size / sizeof(T))};
+}
+
 #endif
\ No newline at end of file
@@ -9,14 +9,56 @@
  */
 
 #include "abcgVulkanDevice.hpp"
+#include "abcgVulkanAllocator.hpp"
+#include "abcgVulkanUploadContext.hpp"
 
+#include <fmt/core.h>
 #include <gsl/gsl>
 
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <set>
 
+namespace {
+// Returns whether the pipeline cache data was created by the same driver and
+// device. See the pipeline cache header layout in the Vulkan specification.
+[[nodiscard]] bool
+isPipelineCacheCompatible(std::vector<char> const &data,
+                          vk::PhysicalDeviceProperties const &properties) {
+  std::array<uint32_t, 4> header{}; // headerSize, version, vendor, device
+  auto const headerBytes{sizeof(header) + VK_UUID_SIZE};
+  if (data.size() < headerBytes) {
+    return false;
+  }
+  std::memcpy(header.data(), data.data(), sizeof(header));
+  auto const &[headerSize, headerVersion, vendorID, deviceID] = header;
+  return headerSize >= headerBytes &&
+         headerVersion == static_cast<uint32_t>(
+                              vk::PipelineCacheHeaderVersion::eOne) &&
+         vendorID == properties.vendorID && deviceID == properties.deviceID &&
+         std::memcmp(data.data() + sizeof(header),
+                     properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+} // namespace
+
+/**
+ * @brief Creates the logical device.
+ *
+ * @param physicalDevice Physical device to be used.
+ * @param extensions Device extensions to be enabled.
+ * @param pipelineCachePath Path to the file used to persist the pipeline cache
+ * across runs. The cache is loaded from this file if it was created by the
+ * same driver and device, and saved back to it in
+ * abcg::VulkanDevice::destroy. If empty, the pipeline cache is kept only in
+ * memory.
+ */
 void abcg::VulkanDevice::create(VulkanPhysicalDevice const &physicalDevice,
-                                std::vector<char const *> const &extensions) {
+                                std::vector<char const *> const &extensions,
+                                std::string_view pipelineCachePath) {
   m_physicalDevice = physicalDevice;
+  m_pipelineCachePath = pipelineCachePath;
   auto const &queuesFamilies{m_physicalDevice.getQueuesFamilies()};
   auto const graphicsQueueFamily{queuesFamilies.graphics.value_or(0)};
   auto const presentQueueFamily{queuesFamilies.present.value_or(0)};
@@ -66,9 +108,38 @@ void abcg::VulkanDevice::create(VulkanPhysicalDevice const &physicalDevice,
   }
 
   createCommandPools();
+  createPipelineCache();
+
+  m_allocator = std::make_shared<VulkanAllocator>();
+  m_allocator->create(m_device, m_physicalDevice);
+
+  // Uploads go to the transfer queue, if there is one
+  m_uploadContext = std::make_shared<VulkanUploadContext>();
+  if (m_queues.transfer) {
+    m_uploadContext->create(m_device, *m_allocator, m_queues.transfer,
+                            queuesFamilies.transfer.value());
+  } else {
+    m_uploadContext->create(m_device, *m_allocator, m_queues.graphics,
+                            graphicsQueueFamily);
+  }
 }
 
+/**
+ * @brief Destroys the logical device.
+ *
+ * Pending uploads are completed first. The pipeline cache is saved to disk
+ * before being destroyed. All memory handed out by the allocator is released.
+ */
 void abcg::VulkanDevice::destroy() {
+  if (m_uploadContext) {
+    m_uploadContext->destroy();
+    m_uploadContext.reset();
+  }
+  if (m_allocator) {
+    m_allocator->destroy();
+    m_allocator.reset();
+  }
+  destroyPipelineCache();
   destroyCommandPools();
   m_device.destroy();
 }
@@ -109,6 +180,42 @@ abcg::VulkanDevice::getCommandPools() const noexcept {
   return m_commandPools;
 }
 
+/**
+ * @brief Returns the pipeline cache of this device.
+ *
+ * The cache is used by abcg::VulkanPipeline::create unless another cache is
+ * given in abcg::VulkanPipelineCreateInfo::pipelineCache.
+ *
+ * @return Pipeline cache.
+ */
+vk::PipelineCache const &abcg::VulkanDevice::getPipelineCache() const noexcept {
+  return m_pipelineCache;
+}
+
+/**
+ * @brief Returns the device memory allocator of this device.
+ *
+ * The allocator is shared by all copies of this object.
+ *
+ * @return Memory allocator.
+ */
+abcg::VulkanAllocator &abcg::VulkanDevice::getAllocator() const noexcept {
+  return *m_allocator;
+}
+
+/**
+ * @brief Returns the upload context of this device.
+ *
+ * The context is shared by all copies of this object. abcg::VulkanWindow
+ * submits its pending uploads once per frame.
+ *
+ * @return Upload context.
+ */
+abcg::VulkanUploadContext &
+abcg::VulkanDevice::getUploadContext() const noexcept {
+  return *m_uploadContext;
+}
+
 /**
  * @brief Allocates and creates a command buffer to be immediately submitted and
  * released.
@@ -119,6 +226,10 @@ abcg::VulkanDevice::getCommandPools() const noexcept {
  * command pool is the default.
  * @param level Whether a primary (default) or secondary command buffer will be
  * created.
+ *
+ * @remark This function blocks until the queue is idle. Use
+ * abcg::VulkanDevice::getUploadContext to record transfers that overlap with
+ * rendering.
  */
 void abcg::VulkanDevice::withCommandBuffer(
     std::function<void(vk::CommandBuffer const &commandBuffer)> const &fun,
@@ -213,3 +324,72 @@ void abcg::VulkanDevice::destroyCommandPools() {
 
   m_device.destroyCommandPool(m_commandPools.graphics);
 }
+
+void abcg::VulkanDevice::createPipelineCache() {
+  std::vector<char> data;
+  if (!m_pipelineCachePath.empty()) {
+    if (std::ifstream stream(m_pipelineCachePath,
+                             std::ios::binary | std::ios::ate);
+        stream) {
+      data.resize(static_cast<std::size_t>(stream.tellg()));
+      stream.seekg(0);
+      stream.read(data.data(), gsl::narrow<std::streamsize>(data.size()));
+      if (!stream) {
+        data.clear();
+      }
+    }
+  }
+
+  // Discard data from another driver or device. The driver would ignore it
+  // anyway, but not every driver validates the header.
+  auto const properties{
+      static_cast<vk::PhysicalDevice>(m_physicalDevice).getProperties()};
+  if (!data.empty() && !isPipelineCacheCompatible(data, properties)) {
+    fmt::print("Discarding incompatible pipeline cache {}\n",
+               m_pipelineCachePath);
+    data.clear();
+  }
+
+  m_pipelineCache = m_device.createPipelineCache(
+      {.initialDataSize = data.size(), .pInitialData = data.data()});
+}
+
+void abcg::VulkanDevice::destroyPipelineCache() {
+  if (!m_pipelineCache) {
+    return;
+  }
+
+  if (!m_pipelineCachePath.empty()) {
+    auto const data{m_device.getPipelineCacheData(m_pipelineCache)};
+
+    // Write to a temporary file first so that a crash never leaves a partial
+    // cache behind
+    std::filesystem::path const path{m_pipelineCachePath};
+    auto tempPath{path};
+    tempPath += ".tmp";
+    std::error_code errorCode;
+    if (path.has_parent_path()) {
+      std::filesystem::create_directories(path.parent_path(), errorCode);
+    }
+    auto saved{false};
+    if (std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        stream) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      stream.write(reinterpret_cast<char const *>(data.data()),
+                   gsl::narrow<std::streamsize>(data.size()));
+      stream.close();
+      saved = !stream.fail();
+    }
+    if (saved) {
+      std::filesystem::rename(tempPath, path, errorCode);
+      saved = !errorCode;
+    }
+    if (!saved) {
+      std::filesystem::remove(tempPath, errorCode);
+      fmt::print("Failed to save pipeline cache {}\n", m_pipelineCachePath);
+    }
+  }
+
+  m_device.destroyPipelineCache(m_pipelineCache);
+  m_pipelineCache = vk::PipelineCache{};
+}
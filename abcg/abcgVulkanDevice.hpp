@@ -16,13 +16,18 @@
 #include "abcgVulkanPhysicalDevice.hpp"
 
 #include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
 
 namespace abcg {
+class VulkanAllocator;
 struct VulkanCommandPools;
 struct VulkanQueues;
 class VulkanDevice;
 class VulkanPipeline;
 class VulkanSwapchain;
+class VulkanUploadContext;
 class VulkanWindow;
 } // namespace abcg
 
@@ -50,12 +55,13 @@ struct abcg::VulkanQueues {
  * resources.
  *
  * This class creates and manages the Vulkan logical device, queues, descriptor
- * pool, and command pools.
+ * pool, command pools, pipeline cache, memory allocator, and upload context.
  */
 class abcg::VulkanDevice {
 public:
   void create(VulkanPhysicalDevice const &physicalDevice,
-              std::vector<char const *> const &extensions = {});
+              std::vector<char const *> const &extensions = {},
+              std::string_view pipelineCachePath = {});
   void destroy();
 
   explicit operator vk::Device const &() const noexcept;
@@ -63,6 +69,9 @@ public:
   [[nodiscard]] VulkanPhysicalDevice const &getPhysicalDevice() const noexcept;
   [[nodiscard]] VulkanQueues const &getQueues() const noexcept;
   [[nodiscard]] VulkanCommandPools const &getCommandPools() const noexcept;
+  [[nodiscard]] vk::PipelineCache const &getPipelineCache() const noexcept;
+  [[nodiscard]] VulkanAllocator &getAllocator() const noexcept;
+  [[nodiscard]] VulkanUploadContext &getUploadContext() const noexcept;
 
   void withCommandBuffer(
       std::function<void(vk::CommandBuffer const &commandBuffer)> const &fun,
@@ -72,11 +81,18 @@ public:
 private:
   void createCommandPools();
   void destroyCommandPools();
+  void createPipelineCache();
+  void destroyPipelineCache();
 
   vk::Device m_device;
   VulkanPhysicalDevice m_physicalDevice;
   VulkanCommandPools m_commandPools;
   VulkanQueues m_queues;
+  vk::PipelineCache m_pipelineCache;
+  std::string m_pipelineCachePath;
+  // Shared by all copies of this device
+  std::shared_ptr<VulkanAllocator> m_allocator;
+  std::shared_ptr<VulkanUploadContext> m_uploadContext;
 };
 
 #endif
\ No newline at end of file
@@ -9,161 +9,457 @@
  */
 
 #include "abcgVulkanImage.hpp"
+#include "abcgThreadPool.hpp"
 #include "abcgVulkanBuffer.hpp"
+#include "abcgVulkanShader.hpp"
 
-#include <SDL_image.h>
 #include <cppitertools/itertools.hpp>
-#include <fmt/core.h>
 #include <gsl/gsl>
 
+#include <array>
+#include <cmath>
+#include <future>
+#include <string>
+
 #include "abcgException.hpp"
 
-void abcg::VulkanImage::create(VulkanDevice const &device,
-                               std::string_view path, bool generateMipmaps) {
-  m_device = static_cast<vk::Device>(device);
+namespace {
 
-  // Load the bitmap
-  if (SDL_Surface *const surface{IMG_Load(path.data())}) {
-    // Enforce RGBA
-    SDL_Surface *formattedSurface{
-        SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0)};
-    SDL_FreeSurface(surface);
-
-    auto const texWidth{gsl::narrow<uint32_t>(formattedSurface->w)};
-    auto const texHeight{gsl::narrow<uint32_t>(formattedSurface->h)};
-    vk::DeviceSize const imageSize{
-        static_cast<vk::DeviceSize>(texWidth * texHeight * 4)};
-
-    if (generateMipmaps) {
-      m_mipLevels = gsl::narrow<uint32_t>(
-                        std::floor(std::log2(std::max(texWidth, texHeight)))) +
-                    1;
-    }
+// Writes a mipmap level from the previous one with a 2x2 box filter. The
+// levels are accessed through UNORM views of the sRGB image, as storage
+// images in sRGB formats are seldom supported. Thus, colors are converted to
+// linear space before averaging, and back to sRGB before storing.
+constexpr auto downsampleShader{R"glsl(#version 450
 
-    // Create staging buffer
-    abcg::VulkanBuffer stagingBuffer{};
-    stagingBuffer.create(
-        device, {.size = imageSize,
-                 .usage = vk::BufferUsageFlagBits::eTransferSrc,
-                 .properties = vk::MemoryPropertyFlagBits::eHostVisible |
-                               vk::MemoryPropertyFlagBits::eHostCoherent,
-                 .data = formattedSurface->pixels});
-
-    SDL_FreeSurface(formattedSurface);
-
-    // TODO: Look for other formats if RGBA8 is not supported
-    auto const imageFormat{vk::Format::eR8G8B8A8Srgb};
-
-    // Create image buffer
-    std::tie(m_image, m_deviceMemory) = createImage(
-        device,
-        {.imageType = vk::ImageType::e2D,
-         .format = imageFormat,
-         .extent = {.width = texWidth, .height = texHeight, .depth = 1},
-         .mipLevels = m_mipLevels,
-         .arrayLayers = 1,
-         .samples = vk::SampleCountFlagBits::e1,
-         .tiling = vk::ImageTiling::eOptimal,
-         .usage = (m_mipLevels > 1 // Required for blit ops
-                       ? vk::ImageUsageFlagBits::eTransferSrc
-                       : vk::ImageUsageFlagBits::eTransferDst) |
-                  vk::ImageUsageFlagBits::eTransferDst |
-                  vk::ImageUsageFlagBits::eSampled,
-         .initialLayout = vk::ImageLayout::eUndefined},
-        vk::MemoryPropertyFlagBits::eDeviceLocal);
-
-    transitionImageLayout(device, vk::ImageLayout::eUndefined,
-                          vk::ImageLayout::eTransferDstOptimal,
-                          {.aspectMask = vk::ImageAspectFlagBits::eColor,
-                           .levelCount = m_mipLevels,
-                           .layerCount = 1});
+layout(local_size_x = 8, local_size_y = 8) in;
 
-    vk::BufferImageCopy const region{
-        .imageSubresource = {.aspectMask = vk::ImageAspectFlagBits::eColor,
-                             .layerCount = 1},
-        .imageExtent = {texWidth, texHeight, 1}};
+layout(set = 0, binding = 0, rgba8) uniform readonly image2D srcLevel;
+layout(set = 0, binding = 1, rgba8) uniform writeonly image2D dstLevel;
 
-    // Execute the layout transition
-    device.withCommandBuffer(
-        [&stagingBuffer, this,
-         &region](vk::CommandBuffer const &commandBuffer) {
-          commandBuffer.copyBufferToImage(
-              static_cast<vk::Buffer>(stagingBuffer), m_image,
-              vk::ImageLayout::eTransferDstOptimal, region);
-        },
-        vk::QueueFlagBits::eTransfer);
-
-    // Generate the mipmap levels
-    if (m_mipLevels > 1) {
-      // Transitioned to vk::ImageLayout::eShaderReadOnlyOptimal while
-      // generating the mipmaps
-      createMipmaps(device, m_image, imageFormat, texWidth, texHeight,
-                    m_mipLevels);
-    } else {
-      transitionImageLayout(device, vk::ImageLayout::eTransferDstOptimal,
-                            vk::ImageLayout::eReadOnlyOptimal,
-                            {.aspectMask = vk::ImageAspectFlagBits::eColor,
-                             .levelCount = m_mipLevels,
-                             .layerCount = 1});
+layout(push_constant) uniform PushConstants { ivec2 dstSize; };
+
+vec3 toLinear(vec3 c) {
+  return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)),
+             greaterThan(c, vec3(0.04045)));
+}
+
+vec3 toSRGB(vec3 c) {
+  return mix(c * 12.92, 1.055 * pow(c, vec3(1.0 / 2.4)) - 0.055,
+             greaterThan(c, vec3(0.0031308)));
+}
+
+void main() {
+  ivec2 dst = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(dst, dstSize))) return;
+
+  // Clamp for levels of odd size
+  ivec2 srcMax = imageSize(srcLevel) - 1;
+  vec4 sum = vec4(0.0);
+  for (int j = 0; j < 2; ++j) {
+    for (int i = 0; i < 2; ++i) {
+      vec4 color = imageLoad(srcLevel, min(dst * 2 + ivec2(i, j), srcMax));
+      sum += vec4(toLinear(color.rgb), color.a);
     }
+  }
+  sum *= 0.25;
+
+  imageStore(dstLevel, dst, vec4(toSRGB(sum.rgb), sum.a));
+})glsl"};
+
+constexpr uint32_t downsampleGroupSize{8};
+
+// Compute pipeline and per-level resources used to generate the mipmaps of a
+// batch of images. Must be kept alive until the command buffer completes.
+class ComputeDownsampler {
+public:
+  void create(abcg::VulkanDevice const &device, uint32_t dispatchCount);
+  void destroy();
+  void record(vk::CommandBuffer const &commandBuffer, vk::Image image,
+              vk::Extent2D const &extent, uint32_t mipLevels);
+
+private:
+  vk::Device m_device;
+  abcg::VulkanShader m_shader;
+  vk::DescriptorSetLayout m_descriptorSetLayout;
+  vk::PipelineLayout m_pipelineLayout;
+  vk::Pipeline m_pipeline;
+  vk::DescriptorPool m_descriptorPool;
+  std::vector<vk::ImageView> m_levelViews;
+};
+
+void ComputeDownsampler::create(abcg::VulkanDevice const &device,
+                                uint32_t dispatchCount) {
+  m_device = static_cast<vk::Device>(device);
+
+  m_shader.create(device, {.source = downsampleShader,
+                           .stage = abcg::ShaderStage::Compute});
+
+  std::array const bindings{
+      vk::DescriptorSetLayoutBinding{
+          .binding = 0,
+          .descriptorType = vk::DescriptorType::eStorageImage,
+          .descriptorCount = 1,
+          .stageFlags = vk::ShaderStageFlagBits::eCompute},
+      vk::DescriptorSetLayoutBinding{
+          .binding = 1,
+          .descriptorType = vk::DescriptorType::eStorageImage,
+          .descriptorCount = 1,
+          .stageFlags = vk::ShaderStageFlagBits::eCompute}};
+  m_descriptorSetLayout = m_device.createDescriptorSetLayout(
+      {.bindingCount = gsl::narrow<uint32_t>(bindings.size()),
+       .pBindings = bindings.data()});
+
+  vk::PushConstantRange const pushConstantRange{
+      .stageFlags = vk::ShaderStageFlagBits::eCompute,
+      .offset = 0,
+      .size = sizeof(std::array<int32_t, 2>)};
+  m_pipelineLayout = m_device.createPipelineLayout(
+      {.setLayoutCount = 1,
+       .pSetLayouts = &m_descriptorSetLayout,
+       .pushConstantRangeCount = 1,
+       .pPushConstantRanges = &pushConstantRange});
+
+  auto result{m_device.createComputePipeline(
+      device.getPipelineCache(),
+      {.stage = {.stage = vk::ShaderStageFlagBits::eCompute,
+                 .module = m_shader.getModule(),
+                 .pName = "main"},
+       .layout = m_pipelineLayout})};
+  m_pipeline = result.value;
+
+  // One descriptor set per dispatch
+  vk::DescriptorPoolSize const poolSize{
+      .type = vk::DescriptorType::eStorageImage,
+      .descriptorCount = 2 * dispatchCount};
+  m_descriptorPool = m_device.createDescriptorPool({.maxSets = dispatchCount,
+                                                    .poolSizeCount = 1,
+                                                    .pPoolSizes = &poolSize});
+}
 
-    stagingBuffer.destroy();
+void ComputeDownsampler::destroy() {
+  if (!m_device) {
+    return;
+  }
+
+  for (auto const &levelView : m_levelViews) {
+    m_device.destroyImageView(levelView);
+  }
+  m_levelViews.clear();
+  m_device.destroyDescriptorPool(m_descriptorPool);
+  m_device.destroyPipeline(m_pipeline);
+  m_device.destroyPipelineLayout(m_pipelineLayout);
+  m_device.destroyDescriptorSetLayout(m_descriptorSetLayout);
+  m_shader.destroy();
+  m_device = vk::Device{};
+}
 
-    // Create image view
-    m_imageView = m_device.createImageView(
-        {.image = m_image,
+// Expects all levels of image in vk::ImageLayout::eTransferDstOptimal, with
+// level 0 already written. Leaves all levels in
+// vk::ImageLayout::eShaderReadOnlyOptimal.
+void ComputeDownsampler::record(vk::CommandBuffer const &commandBuffer,
+                                vk::Image image, vk::Extent2D const &extent,
+                                uint32_t mipLevels) {
+  // Storage views of each level
+  auto const firstView{m_levelViews.size()};
+  for (auto const mipLevel : iter::range(mipLevels)) {
+    vk::ImageViewUsageCreateInfo const usageInfo{
+        .usage = vk::ImageUsageFlagBits::eStorage};
+    m_levelViews.push_back(m_device.createImageView(
+        {.pNext = &usageInfo,
+         .image = image,
          .viewType = vk::ImageViewType::e2D,
-         .format = imageFormat,
+         .format = vk::Format::eR8G8B8A8Unorm,
          .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                              .baseMipLevel = mipLevel,
                               .levelCount = 1,
-                              .layerCount = 1}});
-
-    // Create sampler
-    vk::SamplerCreateInfo samplerCreateInfo{
-        .magFilter = vk::Filter::eLinear,
-        .minFilter = vk::Filter::eLinear,
-        .mipmapMode = vk::SamplerMipmapMode::eLinear,
-        .addressModeU = vk::SamplerAddressMode::eRepeat,
-        .addressModeV = vk::SamplerAddressMode::eRepeat,
-        .addressModeW = vk::SamplerAddressMode::eRepeat,
-        .mipLodBias = 0.0f,
-        .anisotropyEnable = VK_TRUE,
-        .maxAnisotropy =
-            static_cast<vk::PhysicalDevice>(device.getPhysicalDevice())
-                .getProperties()
-                .limits.maxSamplerAnisotropy,
-        .compareEnable = VK_FALSE,
-        .compareOp = vk::CompareOp::eAlways,
-        .minLod = 0.0f,
-        .maxLod = 0.0f,
-        .borderColor = vk::BorderColor::eIntOpaqueBlack,
-        .unnormalizedCoordinates = VK_FALSE};
-
-    if (m_mipLevels > 1) {
-      samplerCreateInfo.mipmapMode = vk::SamplerMipmapMode::eLinear;
-      samplerCreateInfo.maxLod = gsl::narrow<float>(m_mipLevels);
-      // samplerCreateInfo.minLod = gsl::narrow<float>(m_mipLevels >> 1);
+                              .layerCount = 1}}));
+  }
+
+  std::vector const setLayouts(mipLevels - 1, m_descriptorSetLayout);
+  auto const descriptorSets{m_device.allocateDescriptorSets(
+      {.descriptorPool = m_descriptorPool,
+       .descriptorSetCount = gsl::narrow<uint32_t>(setLayouts.size()),
+       .pSetLayouts = setLayouts.data()})};
+
+  vk::ImageMemoryBarrier barrier{
+      .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+      .dstAccessMask =
+          vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+      .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+      .newLayout = vk::ImageLayout::eGeneral,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image,
+      .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                           .levelCount = mipLevels,
+                           .layerCount = 1}};
+  commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                vk::PipelineStageFlagBits::eComputeShader,
+                                vk::DependencyFlagBits{}, {}, {}, {barrier});
+
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+
+  auto mipWidth{extent.width};
+  auto mipHeight{extent.height};
+
+  for (auto const mipLevel : iter::range(1U, mipLevels)) {
+    mipWidth = std::max(mipWidth / 2, 1U);
+    mipHeight = std::max(mipHeight / 2, 1U);
+
+    auto const &descriptorSet{descriptorSets.at(mipLevel - 1)};
+    std::array const imageInfos{
+        vk::DescriptorImageInfo{
+            .imageView = m_levelViews.at(firstView + mipLevel - 1),
+            .imageLayout = vk::ImageLayout::eGeneral},
+        vk::DescriptorImageInfo{.imageView =
+                                    m_levelViews.at(firstView + mipLevel),
+                                .imageLayout = vk::ImageLayout::eGeneral}};
+    std::array const writes{
+        vk::WriteDescriptorSet{.dstSet = descriptorSet,
+                               .dstBinding = 0,
+                               .descriptorCount = 1,
+                               .descriptorType =
+                                   vk::DescriptorType::eStorageImage,
+                               .pImageInfo = &imageInfos.at(0)},
+        vk::WriteDescriptorSet{.dstSet = descriptorSet,
+                               .dstBinding = 1,
+                               .descriptorCount = 1,
+                               .descriptorType =
+                                   vk::DescriptorType::eStorageImage,
+                               .pImageInfo = &imageInfos.at(1)}};
+    m_device.updateDescriptorSets(writes, nullptr);
+
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+                                     m_pipelineLayout, 0, descriptorSet,
+                                     nullptr);
+    std::array const dstSize{gsl::narrow<int32_t>(mipWidth),
+                             gsl::narrow<int32_t>(mipHeight)};
+    commandBuffer.pushConstants(m_pipelineLayout,
+                                vk::ShaderStageFlagBits::eCompute, 0,
+                                sizeof(dstSize), dstSize.data());
+    commandBuffer.dispatch(
+        (mipWidth + downsampleGroupSize - 1) / downsampleGroupSize,
+        (mipHeight + downsampleGroupSize - 1) / downsampleGroupSize, 1);
+
+    // Make the level visible to the next dispatch
+    barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+    barrier.oldLayout = vk::ImageLayout::eGeneral;
+    barrier.subresourceRange.baseMipLevel = mipLevel;
+    barrier.subresourceRange.levelCount = 1;
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                  vk::PipelineStageFlagBits::eComputeShader,
+                                  vk::DependencyFlagBits{}, {}, {}, {barrier});
+  }
+
+  barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+  barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+  barrier.oldLayout = vk::ImageLayout::eGeneral;
+  barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = mipLevels;
+  commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                vk::PipelineStageFlagBits::eFragmentShader,
+                                vk::DependencyFlagBits{}, {}, {}, {barrier});
+}
+
+} // namespace
+
+/**
+ * @brief Creates a texture from an image file.
+ *
+ * To create several textures, abcg::VulkanImage::createBatch is faster.
+ *
+ * @param device Logical device.
+ * @param path Path to the image file.
+ * @param generateMipmaps Whether to generate mipmap levels.
+ * @param mipmapMode Method used to generate the mipmap levels.
+ *
+ * @throw abcg::RuntimeError if the image could not be loaded.
+ */
+void abcg::VulkanImage::create(VulkanDevice const &device,
+                               std::string_view path, bool generateMipmaps,
+                               VulkanMipmapMode mipmapMode) {
+  *this = createBatch(device, {path}, generateMipmaps, mipmapMode).front();
+}
+
+/**
+ * @brief Creates textures from image files with a single submission.
+ *
+ * The image files are decoded in parallel by the worker threads of
+ * abcg::getThreadPool. The textures are then created as with the overload
+ * that takes decoded images.
+ *
+ * @param device Logical device.
+ * @param paths Paths to the image files.
+ * @param generateMipmaps Whether to generate mipmap levels.
+ * @param mipmapMode Method used to generate the mipmap levels.
+ *
+ * @throw abcg::RuntimeError if an image could not be loaded, or if mipmaps
+ * are requested and the image format supports neither the requested method
+ * nor, with abcg::VulkanMipmapMode::Auto, any of them.
+ *
+ * @return Textures in the same order as `paths`.
+ */
+std::vector<abcg::VulkanImage>
+abcg::VulkanImage::createBatch(VulkanDevice const &device,
+                               std::vector<std::string_view> const &paths,
+                               bool generateMipmaps,
+                               VulkanMipmapMode mipmapMode) {
+  std::vector<std::future<SurfacePtr>> decodes;
+  decodes.reserve(paths.size());
+  for (auto const &path : paths) {
+    decodes.push_back(getThreadPool().submit(
+        [path = std::string{path}] { return decode(path); }));
+  }
+
+  std::vector<SurfacePtr> images;
+  std::vector<SDL_Surface const *> surfaces;
+  images.reserve(paths.size());
+  surfaces.reserve(paths.size());
+  for (auto &decoded : decodes) {
+    surfaces.push_back(images.emplace_back(decoded.get()).get());
+  }
+
+  return createBatch(device, surfaces, generateMipmaps, mipmapMode);
+}
+
+/**
+ * @brief Creates textures from decoded images with a single submission.
+ *
+ * The layout transitions, copies and mipmap generation of all images are
+ * recorded into one command buffer, which is submitted once. The staging
+ * memory of all images is kept until the submission completes.
+ *
+ * Mipmap levels are generated with linear blits when the image format
+ * supports linear filtering. Otherwise, or if `mipmapMode` is
+ * abcg::VulkanMipmapMode::Compute, they are generated with a compute shader
+ * that writes to the image through storage views.
+ *
+ * @param device Logical device.
+ * @param images Images decoded by abcg::VulkanImage::decode.
+ * @param generateMipmaps Whether to generate mipmap levels.
+ * @param mipmapMode Method used to generate the mipmap levels.
+ *
+ * @throw abcg::RuntimeError if mipmaps are requested and the image format
+ * supports neither the requested method nor, with
+ * abcg::VulkanMipmapMode::Auto, any of them.
+ *
+ * @return Textures in the same order as `images`.
+ */
+std::vector<abcg::VulkanImage>
+abcg::VulkanImage::createBatch(VulkanDevice const &device,
+                               std::span<SDL_Surface const *const> images,
+                               bool generateMipmaps,
+                               VulkanMipmapMode mipmapMode) {
+  // TODO: Look for other formats if RGBA8 is not supported
+  auto const imageFormat{vk::Format::eR8G8B8A8Srgb};
+
+  if (generateMipmaps) {
+    mipmapMode = selectMipmapMode(device, imageFormat, mipmapMode);
+  }
+
+  std::vector<VulkanImage> textures;
+  std::vector<VulkanBuffer> stagingBuffers;
+  std::vector<vk::Extent2D> extents;
+  textures.reserve(images.size());
+  stagingBuffers.reserve(images.size());
+  extents.reserve(images.size());
+
+  auto const releaseStaging{gsl::finally([&stagingBuffers] {
+    for (auto &stagingBuffer : stagingBuffers) {
+      stagingBuffer.destroy();
     }
-    m_sampler = m_device.createSampler(samplerCreateInfo);
-
-    // Create descriptor info
-    m_descriptorImageInfo = {.sampler = m_sampler,
-                             .imageView = m_imageView,
-                             .imageLayout =
-                                 vk::ImageLayout::eShaderReadOnlyOptimal};
-  } else {
-    throw abcg::RuntimeError(
-        fmt::format("Failed to load texture file {}", path));
+  })};
+
+  try {
+    for (auto const &image : images) {
+      auto const &extent{extents.emplace_back(
+          vk::Extent2D{.width = gsl::narrow<uint32_t>(image->w),
+                       .height = gsl::narrow<uint32_t>(image->h)})};
+      vk::DeviceSize const imageSize{
+          static_cast<vk::DeviceSize>(extent.width * extent.height * 4)};
+
+      // Create staging buffer
+      stagingBuffers.emplace_back().create(
+          device, {.size = imageSize,
+                   .usage = vk::BufferUsageFlagBits::eTransferSrc,
+                   .properties = vk::MemoryPropertyFlagBits::eHostVisible |
+                                 vk::MemoryPropertyFlagBits::eHostCoherent,
+                   .data = image->pixels});
+
+      textures.emplace_back().createTexture(device, extent, imageFormat,
+                                            generateMipmaps, mipmapMode);
+    }
+
+    ComputeDownsampler downsampler;
+    auto const releaseDownsampler{
+        gsl::finally([&downsampler] { downsampler.destroy(); })};
+    if (generateMipmaps && mipmapMode == VulkanMipmapMode::Compute) {
+      uint32_t dispatchCount{};
+      for (auto const &texture : textures) {
+        dispatchCount += texture.m_mipLevels - 1;
+      }
+      if (dispatchCount > 0) {
+        downsampler.create(device, dispatchCount);
+      }
+    }
+
+    // Record the uploads of all images
+    device.withCommandBuffer(
+        [&](vk::CommandBuffer const &commandBuffer) {
+          for (auto &&[texture, stagingBuffer, extent] :
+               iter::zip(textures, stagingBuffers, extents)) {
+            texture.recordUpload(commandBuffer,
+                                 static_cast<vk::Buffer>(stagingBuffer),
+                                 extent);
+            if (texture.m_mipLevels == 1) {
+              continue;
+            }
+            if (mipmapMode == VulkanMipmapMode::Compute) {
+              downsampler.record(commandBuffer, texture.m_image, extent,
+                                 texture.m_mipLevels);
+            } else {
+              recordMipmaps(commandBuffer, texture.m_image, extent,
+                            texture.m_mipLevels);
+            }
+          }
+        },
+        vk::QueueFlagBits::eGraphics);
+  } catch (...) {
+    for (auto &texture : textures) {
+      texture.destroy();
+    }
+    throw;
   }
+
+  return textures;
+}
+
+/**
+ * @brief Decodes an image file into the pixel format of the textures.
+ *
+ * This function does not call Vulkan and can be called from any thread.
+ *
+ * @param path Path to the image file.
+ *
+ * @throw abcg::RuntimeError if the image could not be loaded.
+ *
+ * @return RGBA image to be passed to abcg::VulkanImage::createBatch.
+ */
+abcg::SurfacePtr abcg::VulkanImage::decode(std::string_view path) {
+  // Enforce RGBA
+  return convertImage(*loadImage(path), SDL_PIXELFORMAT_RGBA32);
 }
 
 void abcg::VulkanImage::create(VulkanDevice const &device,
                                VulkanImageCreateInfo const &createInfo) {
   m_device = static_cast<vk::Device>(device);
+  m_allocator = &device.getAllocator();
 
   // Create image only if createInfo.viewInfo.image is undefined
   if (!createInfo.viewInfo.image) {
-    std::tie(m_image, m_deviceMemory) =
+    std::tie(m_image, m_allocation) =
         createImage(device, createInfo.info, createInfo.properties);
   }
 
@@ -185,8 +481,8 @@ void abcg::VulkanImage::destroy() {
   if (m_image) {
     m_device.destroyImage(m_image);
   }
-  if (m_deviceMemory) {
-    m_device.freeMemory(m_deviceMemory);
+  if (m_allocator != nullptr) {
+    m_allocator->free(m_allocation);
   }
 }
 
@@ -204,7 +500,21 @@ abcg::VulkanImage::operator vk::Image const &() const noexcept {
  * @return Device memory object.
  */
 vk::DeviceMemory const &abcg::VulkanImage::getDeviceMemory() const noexcept {
-  return m_deviceMemory;
+  return m_allocation.memory;
+}
+
+/**
+ * @brief Returns the range of device memory bound to this image.
+ *
+ * The device memory object returned by abcg::VulkanImage::getDeviceMemory is
+ * shared with other resources. The image starts at
+ * abcg::VulkanAllocation::offset.
+ *
+ * @return Memory range.
+ */
+abcg::VulkanAllocation const &
+abcg::VulkanImage::getAllocation() const noexcept {
+  return m_allocation;
 }
 
 /**
@@ -241,187 +551,254 @@ uint32_t abcg::VulkanImage::getMipLevels() const noexcept {
   return m_mipLevels;
 }
 
-std::pair<vk::Image, vk::DeviceMemory>
+std::pair<vk::Image, abcg::VulkanAllocation>
 abcg::VulkanImage::createImage(VulkanDevice const &device,
                                vk::ImageCreateInfo const &imageInfo,
                                vk::MemoryPropertyFlags properties) const {
   // Create image object
   auto image{m_device.createImage(imageInfo)};
 
-  // Get memory requirements
-  auto const memoryRequirements{m_device.getImageMemoryRequirements(image)};
+  // Allocate image memory from a shared block and bind it to the image
+  auto const allocation{device.getAllocator().allocateForImage(
+      image, imageInfo.tiling, properties)};
+
+  return {image, allocation};
+}
 
-  // Allocate image memory
-  auto const memoryType{device.getPhysicalDevice().findMemoryType(
-      memoryRequirements.memoryTypeBits, properties)};
-  if (!memoryType.has_value()) {
-    throw abcg::RuntimeError("Failed to find suitable memory type");
+abcg::VulkanMipmapMode
+abcg::VulkanImage::selectMipmapMode(VulkanDevice const &device,
+                                    vk::Format format,
+                                    VulkanMipmapMode mipmapMode) {
+  auto const physicalDevice{
+      static_cast<vk::PhysicalDevice>(device.getPhysicalDevice())};
+
+  // Blits require linear filtering of the image format
+  auto const blitSupported{static_cast<bool>(
+      physicalDevice.getFormatProperties(format).optimalTilingFeatures &
+      vk::FormatFeatureFlagBits::eSampledImageFilterLinear)};
+  // The compute shader writes to the image through UNORM storage views
+  auto const computeSupported{static_cast<bool>(
+      physicalDevice.getFormatProperties(vk::Format::eR8G8B8A8Unorm)
+          .optimalTilingFeatures &
+      vk::FormatFeatureFlagBits::eStorageImage)};
+
+  if (mipmapMode == VulkanMipmapMode::Auto) {
+    mipmapMode =
+        blitSupported ? VulkanMipmapMode::Blit : VulkanMipmapMode::Compute;
   }
-  auto imageMemory{
-      m_device.allocateMemory({.allocationSize = memoryRequirements.size,
-                               .memoryTypeIndex = memoryType.value()})};
 
-  // Associate image memory to image
-  m_device.bindImageMemory(image, imageMemory, 0);
+  if (mipmapMode == VulkanMipmapMode::Blit && !blitSupported) {
+    throw abcg::RuntimeError(
+        "Texture image format does not support linear blitting");
+  }
+  if (mipmapMode == VulkanMipmapMode::Compute && !computeSupported) {
+    throw abcg::RuntimeError(
+        "Texture image format does not support storage images");
+  }
 
-  return {image, imageMemory};
+  return mipmapMode;
 }
 
-void abcg::VulkanImage::transitionImageLayout(
-    VulkanDevice const &device, vk::ImageLayout oldImageLayout,
-    vk::ImageLayout newImageLayout,
-    vk::ImageSubresourceRange subresourceRange) const {
-
-  // Gets the corresponding access mask for a given image layout
-  auto accessMask{[](vk::ImageLayout layout) {
-    switch (layout) {
-    case vk::ImageLayout::eColorAttachmentOptimal:
-      return vk::AccessFlagBits::eColorAttachmentWrite;
-    case vk::ImageLayout::eDepthStencilAttachmentOptimal:
-      return vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-    case vk::ImageLayout::eShaderReadOnlyOptimal:
-      return vk::AccessFlagBits::eShaderRead;
-    case vk::ImageLayout::eTransferSrcOptimal:
-      return vk::AccessFlagBits::eTransferRead;
-    case vk::ImageLayout::eTransferDstOptimal:
-      return vk::AccessFlagBits::eTransferWrite;
-    case vk::ImageLayout::ePreinitialized:
-      return vk::AccessFlagBits::eHostWrite;
-    default:
-      return vk::AccessFlagBits::eNone;
-    }
-  }};
-
-  // Gets the corresponding pipeline stage for a given image layout
-  auto stageMask{[](vk::ImageLayout layout) {
-    switch (layout) {
-    case vk::ImageLayout::eTransferDstOptimal:
-    case vk::ImageLayout::eTransferSrcOptimal:
-      return vk::PipelineStageFlagBits::eTransfer;
-    case vk::ImageLayout::eColorAttachmentOptimal:
-      return vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    case vk::ImageLayout::eDepthStencilAttachmentOptimal:
-      return vk::PipelineStageFlagBits::eEarlyFragmentTests;
-    case vk::ImageLayout::eShaderReadOnlyOptimal:
-      return vk::PipelineStageFlagBits::eFragmentShader;
-    case vk::ImageLayout::ePreinitialized:
-      return vk::PipelineStageFlagBits::eHost;
-    case vk::ImageLayout::eUndefined:
-      return vk::PipelineStageFlagBits::eTopOfPipe;
-    default:
-      return vk::PipelineStageFlagBits::eBottomOfPipe;
-    }
-  }};
-
-  // Create image barrier
-  vk::ImageMemoryBarrier imageMemoryBarrier{
-      .srcAccessMask = accessMask(oldImageLayout),
-      .dstAccessMask = accessMask(newImageLayout),
-      .oldLayout = oldImageLayout,
-      .newLayout = newImageLayout,
+void abcg::VulkanImage::createTexture(VulkanDevice const &device,
+                                      vk::Extent2D const &extent,
+                                      vk::Format format, bool generateMipmaps,
+                                      VulkanMipmapMode mipmapMode) {
+  m_device = static_cast<vk::Device>(device);
+  m_allocator = &device.getAllocator();
+
+  m_mipLevels = 1;
+  if (generateMipmaps) {
+    m_mipLevels = gsl::narrow<uint32_t>(std::floor(
+                      std::log2(std::max(extent.width, extent.height)))) +
+                  1;
+  }
+
+  // Generating mipmaps with a compute shader requires storage views in another
+  // format. The views used for sampling are restricted to sampled usage.
+  auto const computeMipmaps{m_mipLevels > 1 &&
+                            mipmapMode == VulkanMipmapMode::Compute};
+  vk::ImageViewUsageCreateInfo const viewUsageInfo{
+      .usage = vk::ImageUsageFlagBits::eSampled};
+
+  // Create image buffer
+  std::tie(m_image, m_allocation) = createImage(
+      device,
+      {.flags = computeMipmaps ? vk::ImageCreateFlagBits::eMutableFormat |
+                                     vk::ImageCreateFlagBits::eExtendedUsage
+                               : vk::ImageCreateFlags{},
+       .imageType = vk::ImageType::e2D,
+       .format = format,
+       .extent = {.width = extent.width, .height = extent.height, .depth = 1},
+       .mipLevels = m_mipLevels,
+       .arrayLayers = 1,
+       .samples = vk::SampleCountFlagBits::e1,
+       .tiling = vk::ImageTiling::eOptimal,
+       .usage = (m_mipLevels > 1 // Required for blit ops
+                     ? vk::ImageUsageFlagBits::eTransferSrc
+                     : vk::ImageUsageFlagBits::eTransferDst) |
+                (computeMipmaps ? vk::ImageUsageFlagBits::eStorage
+                                : vk::ImageUsageFlagBits::eTransferDst) |
+                vk::ImageUsageFlagBits::eTransferDst |
+                vk::ImageUsageFlagBits::eSampled,
+       .initialLayout = vk::ImageLayout::eUndefined},
+      vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+  // Create image view
+  m_imageView = m_device.createImageView(
+      {.pNext = computeMipmaps ? &viewUsageInfo : nullptr,
+       .image = m_image,
+       .viewType = vk::ImageViewType::e2D,
+       .format = format,
+       .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                            .levelCount = m_mipLevels,
+                            .layerCount = 1}});
+
+  // Create sampler
+  vk::SamplerCreateInfo samplerCreateInfo{
+      .magFilter = vk::Filter::eLinear,
+      .minFilter = vk::Filter::eLinear,
+      .mipmapMode = vk::SamplerMipmapMode::eLinear,
+      .addressModeU = vk::SamplerAddressMode::eRepeat,
+      .addressModeV = vk::SamplerAddressMode::eRepeat,
+      .addressModeW = vk::SamplerAddressMode::eRepeat,
+      .mipLodBias = 0.0f,
+      .anisotropyEnable = VK_TRUE,
+      .maxAnisotropy =
+          static_cast<vk::PhysicalDevice>(device.getPhysicalDevice())
+              .getProperties()
+              .limits.maxSamplerAnisotropy,
+      .compareEnable = VK_FALSE,
+      .compareOp = vk::CompareOp::eAlways,
+      .minLod = 0.0f,
+      .maxLod = 0.0f,
+      .borderColor = vk::BorderColor::eIntOpaqueBlack,
+      .unnormalizedCoordinates = VK_FALSE};
+
+  if (m_mipLevels > 1) {
+    samplerCreateInfo.mipmapMode = vk::SamplerMipmapMode::eLinear;
+    samplerCreateInfo.maxLod = gsl::narrow<float>(m_mipLevels);
+    // samplerCreateInfo.minLod = gsl::narrow<float>(m_mipLevels >> 1);
+  }
+  m_sampler = m_device.createSampler(samplerCreateInfo);
+
+  // Create descriptor info
+  m_descriptorImageInfo = {.sampler = m_sampler,
+                           .imageView = m_imageView,
+                           .imageLayout =
+                               vk::ImageLayout::eShaderReadOnlyOptimal};
+}
+
+void abcg::VulkanImage::recordUpload(vk::CommandBuffer const &commandBuffer,
+                                     vk::Buffer const &stagingBuffer,
+                                     vk::Extent2D const &extent) const {
+  vk::ImageMemoryBarrier barrier{
+      .srcAccessMask = vk::AccessFlagBits::eNone,
+      .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+      .oldLayout = vk::ImageLayout::eUndefined,
+      .newLayout = vk::ImageLayout::eTransferDstOptimal,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
       .image = m_image,
-      .subresourceRange = subresourceRange};
-  auto srcStageMask{stageMask(oldImageLayout)};
-  auto destStageMask{stageMask(newImageLayout)};
-
-  // Execute the layout transition
-  device.withCommandBuffer(
-      [&](const auto &commandBuffer) {
-        commandBuffer.pipelineBarrier(srcStageMask, destStageMask,
-                                      vk::DependencyFlags(), nullptr, nullptr,
-                                      imageMemoryBarrier);
-      },
-      vk::QueueFlagBits::eTransfer);
+      .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                           .levelCount = m_mipLevels,
+                           .layerCount = 1}};
+
+  commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                                vk::PipelineStageFlagBits::eTransfer,
+                                vk::DependencyFlagBits{}, {}, {}, {barrier});
+
+  vk::BufferImageCopy const region{
+      .imageSubresource = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                           .layerCount = 1},
+      .imageExtent = {extent.width, extent.height, 1}};
+  commandBuffer.copyBufferToImage(stagingBuffer, m_image,
+                                  vk::ImageLayout::eTransferDstOptimal,
+                                  region);
+
+  if (m_mipLevels > 1) {
+    // Transitioned to vk::ImageLayout::eShaderReadOnlyOptimal by the caller
+    // while generating the mipmaps
+    return;
+  }
+
+  barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+  barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+  barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+  barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                vk::PipelineStageFlagBits::eFragmentShader,
+                                vk::DependencyFlagBits{}, {}, {}, {barrier});
 }
 
-void abcg::VulkanImage::createMipmaps(VulkanDevice const &device,
-                                      vk::Image image, vk::Format imageFormat,
-                                      uint32_t texWidth, uint32_t texHeight,
+void abcg::VulkanImage::recordMipmaps(vk::CommandBuffer const &commandBuffer,
+                                      vk::Image image,
+                                      vk::Extent2D const &extent,
                                       uint32_t mipLevels) {
-  // Check if image format supports linear blitting
-  vk::FormatProperties const formatProperties{
-      static_cast<vk::PhysicalDevice>(device.getPhysicalDevice())
-          .getFormatProperties(imageFormat)};
-
-  if (!(formatProperties.optimalTilingFeatures &
-        vk::FormatFeatureFlagBits::eSampledImageFilterLinear)) {
-    // TODO: generate mip maps in software
-    throw abcg::RuntimeError(
-        "Texture image format does not support linear blitting");
+  vk::ImageMemoryBarrier barrier{
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image,
+      .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                           .levelCount = 1,
+                           .baseArrayLayer = 0,
+                           .layerCount = 1}};
+
+  auto mipWidth{gsl::narrow<int32_t>(extent.width)};
+  auto mipHeight{gsl::narrow<int32_t>(extent.height)};
+
+  for (auto const mipLevel : iter::range(1U, mipLevels)) {
+    barrier.subresourceRange.baseMipLevel = mipLevel - 1;
+    barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                  vk::PipelineStageFlagBits::eTransfer,
+                                  vk::DependencyFlagBits{}, {}, {},
+                                  {{barrier}});
+
+    vk::ImageBlit blit{};
+    blit.srcOffsets[0] = vk::Offset3D{0, 0, 0};
+    blit.srcOffsets[1] = vk::Offset3D{mipWidth, mipHeight, 1};
+    blit.srcSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+    blit.srcSubresource.mipLevel = mipLevel - 1;
+    blit.srcSubresource.baseArrayLayer = 0;
+    blit.srcSubresource.layerCount = 1;
+    blit.dstOffsets[0] = vk::Offset3D{0, 0, 0};
+    blit.dstOffsets[1] = vk::Offset3D{mipWidth > 1 ? mipWidth / 2 : 1,
+                                      mipHeight > 1 ? mipHeight / 2 : 1, 1};
+    blit.dstSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+    blit.dstSubresource.mipLevel = mipLevel;
+    blit.dstSubresource.baseArrayLayer = 0;
+    blit.dstSubresource.layerCount = 1;
+
+    commandBuffer.blitImage(image, vk::ImageLayout::eTransferSrcOptimal,
+                            image, vk::ImageLayout::eTransferDstOptimal,
+                            {blit}, vk::Filter::eLinear);
+
+    barrier.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
+    barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+    barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                  vk::PipelineStageFlagBits::eFragmentShader,
+                                  vk::DependencyFlagBits{}, {}, {}, {barrier});
+
+    if (mipWidth > 1)
+      mipWidth /= 2;
+    if (mipHeight > 1)
+      mipHeight /= 2;
   }
 
-  device.withCommandBuffer(
-      [&](vk::CommandBuffer const &commandBuffer) {
-        vk::ImageMemoryBarrier barrier{
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .image = image,
-            .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
-                                 .levelCount = 1,
-                                 .baseArrayLayer = 0,
-                                 .layerCount = 1}};
-
-        auto mipWidth{gsl::narrow<int32_t>(texWidth)};
-        auto mipHeight{gsl::narrow<int32_t>(texHeight)};
-
-        for (auto const mipLevel : iter::range(1U, mipLevels)) {
-          barrier.subresourceRange.baseMipLevel = mipLevel - 1;
-          barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
-          barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
-          barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-          barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
-
-          commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
-                                        vk::PipelineStageFlagBits::eTransfer,
-                                        vk::DependencyFlagBits{}, {}, {},
-                                        {{barrier}});
-
-          vk::ImageBlit blit{};
-          blit.srcOffsets[0] = vk::Offset3D{0, 0, 0};
-          blit.srcOffsets[1] = vk::Offset3D{mipWidth, mipHeight, 1};
-          blit.srcSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-          blit.srcSubresource.mipLevel = mipLevel - 1;
-          blit.srcSubresource.baseArrayLayer = 0;
-          blit.srcSubresource.layerCount = 1;
-          blit.dstOffsets[0] = vk::Offset3D{0, 0, 0};
-          blit.dstOffsets[1] =
-              vk::Offset3D{mipWidth > 1 ? mipWidth / 2 : 1,
-                           mipHeight > 1 ? mipHeight / 2 : 1, 1};
-          blit.dstSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-          blit.dstSubresource.mipLevel = mipLevel;
-          blit.dstSubresource.baseArrayLayer = 0;
-          blit.dstSubresource.layerCount = 1;
-
-          commandBuffer.blitImage(image, vk::ImageLayout::eTransferSrcOptimal,
-                                  image, vk::ImageLayout::eTransferDstOptimal,
-                                  {blit}, vk::Filter::eLinear);
-
-          barrier.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
-          barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-          barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
-          barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-
-          commandBuffer.pipelineBarrier(
-              vk::PipelineStageFlagBits::eTransfer,
-              vk::PipelineStageFlagBits::eFragmentShader,
-              vk::DependencyFlagBits{}, {}, {}, {barrier});
-
-          if (mipWidth > 1)
-            mipWidth /= 2;
-          if (mipHeight > 1)
-            mipHeight /= 2;
-        }
-
-        barrier.subresourceRange.baseMipLevel = mipLevels - 1;
-        barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
-        barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-
-        commandBuffer.pipelineBarrier(
-            vk::PipelineStageFlagBits::eTransfer,
-            vk::PipelineStageFlagBits::eFragmentShader,
-            vk::DependencyFlagBits{}, {}, {}, {barrier});
-      },
-      vk::QueueFlagBits::eGraphics);
+  barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+  barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+  barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+  barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+  commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                vk::PipelineStageFlagBits::eFragmentShader,
+                                vk::DependencyFlagBits{}, {}, {}, {barrier});
 }
@@ -13,15 +13,38 @@
 #ifndef ABCG_VULKAN_IMAGE_HPP_
 #define ABCG_VULKAN_IMAGE_HPP_
 
+#include "abcgImage.hpp"
+#include "abcgVulkanAllocator.hpp"
 #include "abcgVulkanDevice.hpp"
 
 #include <gsl/pointers>
 
+#include <span>
+#include <string_view>
+#include <vector>
+
 namespace abcg {
+enum class VulkanMipmapMode;
 struct VulkanImageCreateInfo;
 class VulkanImage;
 } // namespace abcg
 
+/**
+ * @brief Method used to generate the mipmap levels of a texture.
+ *
+ * @sa abcg::VulkanImage::createBatch.
+ */
+enum class abcg::VulkanMipmapMode {
+  /** @brief Blit if the image format supports linear filtering, otherwise
+   * use a compute shader. */
+  Auto,
+  /** @brief Successive linear blits from each level to the next. */
+  Blit,
+  /** @brief Compute shader dispatches that downsample each level to the
+   * next with a 2x2 box filter. */
+  Compute
+};
+
 /**
  * @brief Creation info structure for abcg::VulkanImage
  */
@@ -40,7 +63,19 @@ struct abcg::VulkanImageCreateInfo {
 class abcg::VulkanImage {
 public:
   void create(VulkanDevice const &device, std::string_view path,
-              bool generateMipmaps = true);
+              bool generateMipmaps = true,
+              VulkanMipmapMode mipmapMode = VulkanMipmapMode::Auto);
+  [[nodiscard]] static std::vector<VulkanImage>
+  createBatch(VulkanDevice const &device,
+              std::vector<std::string_view> const &paths,
+              bool generateMipmaps = true,
+              VulkanMipmapMode mipmapMode = VulkanMipmapMode::Auto);
+  [[nodiscard]] static std::vector<VulkanImage>
+  createBatch(VulkanDevice const &device,
+              std::span<SDL_Surface const *const> images,
+              bool generateMipmaps = true,
+              VulkanMipmapMode mipmapMode = VulkanMipmapMode::Auto);
+  [[nodiscard]] static SurfacePtr decode(std::string_view path);
   void create(VulkanDevice const &device,
               VulkanImageCreateInfo const &createInfo);
   void destroy();
@@ -48,29 +83,32 @@ public:
   explicit operator vk::Image const &() const noexcept;
 
   [[nodiscard]] vk::DeviceMemory const &getDeviceMemory() const noexcept;
+  [[nodiscard]] VulkanAllocation const &getAllocation() const noexcept;
   [[nodiscard]] vk::ImageView const &getView() const noexcept;
   [[nodiscard]] vk::DescriptorImageInfo const &
   getDescriptorImageInfo() const noexcept;
   [[nodiscard]] uint32_t getMipLevels() const noexcept;
 
 private:
-  [[nodiscard]] std::pair<vk::Image, vk::DeviceMemory>
+  [[nodiscard]] std::pair<vk::Image, VulkanAllocation>
   createImage(VulkanDevice const &device, vk::ImageCreateInfo const &imageInfo,
               vk::MemoryPropertyFlags properties) const;
-  void transitionImageLayout(VulkanDevice const &device,
-                             vk::ImageLayout oldImageLayout,
-                             vk::ImageLayout newImageLayout,
-                             vk::ImageSubresourceRange subresourceRange = {
-                                 .aspectMask = vk::ImageAspectFlagBits::eColor,
-                                 .levelCount = 1,
-                                 .layerCount = 1}) const;
-
-  static void createMipmaps(VulkanDevice const &device, vk::Image image,
-                            vk::Format imageFormat, uint32_t texWidth,
-                            uint32_t texHeight, uint32_t mipLevels);
+  [[nodiscard]] static VulkanMipmapMode
+  selectMipmapMode(VulkanDevice const &device, vk::Format format,
+                   VulkanMipmapMode mipmapMode);
+  void createTexture(VulkanDevice const &device, vk::Extent2D const &extent,
+                     vk::Format format, bool generateMipmaps,
+                     VulkanMipmapMode mipmapMode);
+  void recordUpload(vk::CommandBuffer const &commandBuffer,
+                    vk::Buffer const &stagingBuffer,
+                    vk::Extent2D const &extent) const;
+  static void recordMipmaps(vk::CommandBuffer const &commandBuffer,
+                            vk::Image image, vk::Extent2D const &extent,
+                            uint32_t mipLevels);
 
   vk::Image m_image;
-  vk::DeviceMemory m_deviceMemory;
+  VulkanAllocation m_allocation;
+  VulkanAllocator *m_allocator{};
   vk::ImageView m_imageView;
   vk::Sampler m_sampler;
   vk::DescriptorImageInfo m_descriptorImageInfo;
@@ -38,6 +38,7 @@ struct abcg::VulkanPipelineCreateInfo {
   std::optional<vk::PipelineColorBlendStateCreateInfo> colorBlendState{};
   std::vector<vk::DynamicState> dynamicStates{};
   vk::PipelineLayoutCreateInfo pipelineLayout{};
+  /** @brief Pipeline cache. If null, the cache of the device is used. */
   vk::PipelineCache pipelineCache{};
 };
 
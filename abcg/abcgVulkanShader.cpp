@@ -10,14 +10,21 @@
 
 #include "abcgVulkanShader.hpp"
 #include "abcgException.hpp"
+#include "abcgUtil.hpp"
 
 #include <glslang/SPIRV/GlslangToSpv.h>
+#include <glslang/SPIRV/spirv.hpp>
 
 #include <fmt/core.h>
 #include <gsl/gsl>
 
+#include <cppitertools/itertools.hpp>
+
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <optional>
+#include <thread>
 
 namespace {
 TBuiltInResource InitResources() {
@@ -252,20 +259,113 @@ abcgStageToVulkanStage(abcg::ShaderStage stage) {
   }
   return source.str();
 }
+
+// Initializes glslang on first use. The process is finalized at exit.
+void initializeGlslang() {
+  struct GlslangProcess {
+    GlslangProcess() { glslang::InitializeProcess(); }
+    GlslangProcess(GlslangProcess const &) = delete;
+    GlslangProcess(GlslangProcess &&) = delete;
+    GlslangProcess &operator=(GlslangProcess const &) = delete;
+    GlslangProcess &operator=(GlslangProcess &&) = delete;
+    ~GlslangProcess() { glslang::FinalizeProcess(); }
+  };
+  static GlslangProcess const process;
+}
+
+// Directory of the SPIR-V cache. Empty if the cache is disabled.
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::string spirvCacheDirectory;
+
+// Returns the path of the cache entry of a GLSL shader. The key covers
+// everything that affects the generated code: source, stage, and compiler
+// version.
+[[nodiscard]] std::filesystem::path
+spirvCachePath(abcg::ShaderSource const &shaderSource) {
+  auto const version{glslang::GetVersion()};
+  auto hash{abcg::hashFNV1a(shaderSource.source)};
+  hash = abcg::hashFNV1a(
+      fmt::format("\n{}\n{}.{}.{}{}\n{}",
+                  static_cast<int>(shaderSource.stage), version.major,
+                  version.minor, version.patch, version.flavor,
+                  glslang::GetSpirvGeneratorVersion()),
+      hash);
+  return std::filesystem::path{spirvCacheDirectory} /
+         fmt::format("{:016x}.spv", hash);
+}
+
+// Returns the SPIR-V code stored in the cache, if any. Invalid entries are
+// removed.
+[[nodiscard]] std::optional<std::vector<uint32_t>>
+loadCachedSPIRV(std::filesystem::path const &path) {
+  std::ifstream stream(path, std::ios::binary | std::ios::ate);
+  if (!stream) {
+    return std::nullopt;
+  }
+
+  auto const size{static_cast<std::size_t>(stream.tellg())};
+  std::vector<uint32_t> code(size / sizeof(uint32_t));
+  stream.seekg(0);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  stream.read(reinterpret_cast<char *>(code.data()),
+              gsl::narrow<std::streamsize>(code.size() * sizeof(uint32_t)));
+  if (!stream || code.empty() || size % sizeof(uint32_t) != 0 ||
+      code.front() != spv::MagicNumber) {
+    stream.close();
+    std::error_code errorCode;
+    std::filesystem::remove(path, errorCode);
+    return std::nullopt;
+  }
+  return code;
+}
+
+// Writes SPIR-V code to the cache. Failures are ignored.
+void storeCachedSPIRV(std::filesystem::path const &path,
+                      std::vector<uint32_t> const &code) {
+  std::error_code errorCode;
+  std::filesystem::create_directories(path.parent_path(), errorCode);
+
+  // Write to a temporary file first so that readers never see a partial entry
+  auto tempPath{path};
+  tempPath += fmt::format(".{}.tmp", std::hash<std::thread::id>{}(
+                                          std::this_thread::get_id()));
+  {
+    std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    stream.write(reinterpret_cast<char const *>(code.data()),
+                 gsl::narrow<std::streamsize>(code.size() * sizeof(uint32_t)));
+    if (!stream) {
+      stream.close();
+      std::filesystem::remove(tempPath, errorCode);
+      return;
+    }
+  }
+  std::filesystem::rename(tempPath, path, errorCode);
+  if (errorCode) {
+    std::filesystem::remove(tempPath, errorCode);
+  }
+}
 } // namespace
 
-// Compiles the given GLSL shader source into Vulkan SPIR-V.
-std::vector<uint32_t> GLSLtoSPV(abcg::ShaderSource shaderSource) {
-  // Prints out log info for compiling and linking
-  auto printLog{[](glslang::TShader &shader, std::string_view name) {
+// Compiles the given GLSL shader source into Vulkan SPIR-V. Compile and link
+// logs are appended to infoLog instead of being printed, so that shaders can
+// be compiled concurrently.
+std::vector<uint32_t> GLSLtoSPV(abcg::ShaderSource shaderSource,
+                                std::string &infoLog) {
+  // Appends log info for compiling and linking
+  auto printLog{[&infoLog](glslang::TShader &shader, std::string_view name) {
     if (std::string const log{shader.getInfoLog()}; !log.empty()) {
-      fmt::print("Shader information log ({} shader):\n{}\n", name, log);
+      infoLog += fmt::format("Shader information log ({} shader):\n{}\n",
+                             name, log);
     }
     if (std::string const log{shader.getInfoDebugLog()}; !log.empty()) {
-      fmt::print("Shader information debug log ({} shader):\n{}\n", name, log);
+      infoLog += fmt::format(
+          "Shader information debug log ({} shader):\n{}\n", name, log);
     }
   }};
 
+  initializeGlslang();
+
   auto const *data{shaderSource.source.data()};
   auto const stage{abcgStageToGlslangStage(shaderSource.stage)};
   glslang::TShader shader(stage);
@@ -301,9 +401,94 @@ std::vector<uint32_t> GLSLtoSPV(abcg::ShaderSource shaderSource) {
   return outCode;
 }
 
+namespace {
+// Returns the SPIR-V code of the given GLSL shader source, either from the
+// cache or by compiling it.
+[[nodiscard]] std::vector<uint32_t>
+loadOrCompileSPIRV(abcg::ShaderSource const &shaderSource,
+                   std::string &infoLog) {
+  if (spirvCacheDirectory.empty()) {
+    return GLSLtoSPV(shaderSource, infoLog);
+  }
+
+  auto const path{spirvCachePath(shaderSource)};
+  if (auto code{loadCachedSPIRV(path)}; code.has_value()) {
+    return std::move(*code);
+  }
+  auto code{GLSLtoSPV(shaderSource, infoLog)};
+  storeCachedSPIRV(path, code);
+  return code;
+}
+
+// Result of compiling a shader, possibly in a worker thread
+struct SPIRVResult {
+  std::vector<uint32_t> code;
+  std::string infoLog;
+  std::exception_ptr error;
+};
+
+// Reads and compiles a shader. Exceptions are captured in the result.
+[[nodiscard]] SPIRVResult
+compileHelper(abcg::ShaderSource const &pathOrSource) noexcept {
+  SPIRVResult result;
+  try {
+    abcg::ShaderSource const source{.source = toSource(pathOrSource.source),
+                                    .stage = pathOrSource.stage};
+    result.code = loadOrCompileSPIRV(source, result.infoLog);
+  } catch (...) {
+    result.error = std::current_exception();
+  }
+  return result;
+}
+
+// Prints the info log of a compiled shader and rethrows its error, if any
+void printAndRethrow(SPIRVResult const &result) {
+  if (!result.infoLog.empty()) {
+    fmt::print("{}", result.infoLog);
+  }
+  if (result.error) {
+    std::rethrow_exception(result.error);
+  }
+}
+} // namespace
+
+/**
+ * @brief Enables or disables the on-disk SPIR-V cache used by
+ * abcg::VulkanShader::create.
+ *
+ * When enabled, the SPIR-V code generated from a GLSL shader is stored in a
+ * file named after a hash of the shader source, stage, and glslang version.
+ * Subsequent calls to abcg::VulkanShader::create with the same shader load the
+ * code from that file instead of running glslang.
+ *
+ * The cache is disabled by default.
+ *
+ * @param directory Path to the directory where the SPIR-V files will be
+ * stored. The directory is created if it does not exist. An empty string
+ * disables the cache.
+ */
+void abcg::setVulkanShaderCacheDirectory(std::string_view directory) {
+  spirvCacheDirectory = directory;
+}
+
+/**
+ * @brief Returns the directory of the SPIR-V cache.
+ *
+ * @return Path to the cache directory, or an empty string if the cache is
+ * disabled.
+ *
+ * @sa abcg::setVulkanShaderCacheDirectory.
+ */
+std::string const &abcg::getVulkanShaderCacheDirectory() noexcept {
+  return spirvCacheDirectory;
+}
+
 /**
  * @brief Compiles a GLSL shader to SPIR-V and creates its module.
  *
+ * If the SPIR-V cache is enabled, the code is loaded from the cache when
+ * available.
+ *
  * @param device Vulkan device to be used to create the shader module.
  * @param pathOrSource Path or source code of the GLSL shader to be compiled to
  * SPIR-V.
@@ -313,18 +498,80 @@ std::vector<uint32_t> GLSLtoSPV(abcg::ShaderSource shaderSource) {
  */
 void abcg::VulkanShader::create(VulkanDevice const &device,
                                 ShaderSource const &pathOrSource) {
-  m_device = static_cast<vk::Device>(device);
+  auto const result{compileHelper(pathOrSource)};
+  printAndRethrow(result);
+  createModule(device, pathOrSource.stage, result.code);
+}
 
-  ShaderSource const source{.source = toSource(pathOrSource.source),
-                            .stage = pathOrSource.stage};
+/**
+ * @brief Compiles a batch of GLSL shaders to SPIR-V concurrently and creates
+ * their modules.
+ *
+ * The shaders are read and compiled by the worker threads of `threadPool`
+ * and the calling thread. Once all shaders are compiled, their information
+ * logs are printed in the order of the input, and the modules are created on
+ * the calling thread.
+ *
+ * @param device Vulkan device to be used to create the shader modules.
+ * @param pathsOrSources Paths or source codes of the GLSL shaders to be
+ * compiled to SPIR-V.
+ * @param threadPool Thread pool used to compile the shaders.
+ *
+ * @throw abcg::RuntimeError if any shader could not be read from file or has
+ * failed to compile. In this case, no module is created.
+ *
+ * @return Shaders in the same order as `pathsOrSources`.
+ */
+std::vector<abcg::VulkanShader>
+abcg::VulkanShader::createBatch(VulkanDevice const &device,
+                                std::vector<ShaderSource> const &pathsOrSources,
+                                ThreadPool &threadPool) {
+  std::vector<SPIRVResult> results(pathsOrSources.size());
+  threadPool.parallelFor(results.size(),
+                         [&](std::size_t first, std::size_t last) {
+                           for (auto const index : iter::range(first, last)) {
+                             results[index] =
+                                 compileHelper(pathsOrSources[index]);
+                           }
+                         });
+
+  // Print the logs and report the first error, if any
+  std::exception_ptr error;
+  for (auto const &result : results) {
+    if (!result.infoLog.empty()) {
+      fmt::print("{}", result.infoLog);
+    }
+    if (result.error && !error) {
+      error = result.error;
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
 
-  glslang::InitializeProcess();
-  std::vector<uint32_t> shader{GLSLtoSPV(source)};
-  m_stage = abcgStageToVulkanStage(source.stage);
-  glslang::FinalizeProcess();
+  std::vector<VulkanShader> shaders(pathsOrSources.size());
+  try {
+    for (auto const index : iter::range(shaders.size())) {
+      shaders[index].createModule(device, pathsOrSources[index].stage,
+                                  results[index].code);
+    }
+  } catch (...) {
+    // Shaders whose module was not created hold a null handle or device
+    for (auto &shader : shaders) {
+      shader.destroy();
+    }
+    throw;
+  }
+  return shaders;
+}
 
+void abcg::VulkanShader::createModule(VulkanDevice const &device,
+                                      ShaderStage stage,
+                                      std::vector<uint32_t> const &code) {
+  m_device = static_cast<vk::Device>(device);
+  m_stage = abcgStageToVulkanStage(stage);
   m_module = m_device.createShaderModule(
-      {.codeSize = shader.size() * sizeof(uint32_t), .pCode = shader.data()});
+      {.codeSize = code.size() * sizeof(uint32_t), .pCode = code.data()});
 }
 
 /**
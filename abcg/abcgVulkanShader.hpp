@@ -12,10 +12,18 @@
 #define ABCG_VULKAN_SHADER_HPP_
 
 #include "abcgShader.hpp"
+#include "abcgThreadPool.hpp"
 #include "abcgVulkanDevice.hpp"
 
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace abcg {
 class VulkanShader;
+
+void setVulkanShaderCacheDirectory(std::string_view directory);
+[[nodiscard]] std::string const &getVulkanShaderCacheDirectory() noexcept;
 } // namespace abcg
 
 /**
@@ -27,12 +35,19 @@ class VulkanShader;
 class abcg::VulkanShader {
 public:
   void create(VulkanDevice const &device, ShaderSource const &pathOrSource);
+  [[nodiscard]] static std::vector<VulkanShader>
+  createBatch(VulkanDevice const &device,
+              std::vector<ShaderSource> const &pathsOrSources,
+              ThreadPool &threadPool = getThreadPool());
   void destroy();
 
   [[nodiscard]] vk::ShaderStageFlagBits const &getStage() const noexcept;
   [[nodiscard]] vk::ShaderModule const &getModule() const noexcept;
 
 private:
+  void createModule(VulkanDevice const &device, ShaderStage stage,
+                    std::vector<uint32_t> const &code);
+
   vk::ShaderStageFlagBits m_stage{};
   vk::ShaderModule m_module;
   vk::Device m_device;
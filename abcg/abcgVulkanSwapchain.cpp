@@ -121,6 +121,7 @@ void abcg::VulkanSwapchain::destroy() {
   destroyMSAAResources();
   destroyDepthResources();
   destroyFrames();
+  destroyImages();
   destroyRenderPasses();
 
   device.destroySwapchainKHR(m_swapchainKHR);
@@ -130,16 +131,22 @@ void abcg::VulkanSwapchain::render(
     std::function<void(VulkanFrame const &)> const &fun) {
   auto const &device{static_cast<vk::Device>(m_device)};
 
-  // Get current set of semaphores
-  auto [presentCompleteSemaphore,
-        renderCompleteSemaphore]{m_frameSemaphores.at(m_currentSemaphore)};
+  auto &frame{m_frames.at(m_currentFrame)};
+  auto const &presentCompleteSemaphore{
+      m_presentCompleteSemaphores.at(m_currentFrame)};
+
+  // Wait until the command buffers of this frame have finished executing
+  while (vk::Result::eTimeout ==
+         device.waitForFences(frame.fence, VK_TRUE,
+                              std::numeric_limits<uint64_t>::max()))
+    ;
 
   // Acquire an image from the swapchain
   vk::Result result{};
   try {
     result = device.acquireNextImageKHR(
         m_swapchainKHR, std::numeric_limits<uint64_t>::max(),
-        presentCompleteSemaphore, vk::Fence{}, &m_currentFrame);
+        presentCompleteSemaphore, vk::Fence{}, &frame.imageIndex);
   } catch (vk::OutOfDateKHRError const &) {
     result = vk::Result::eErrorOutOfDateKHR;
   }
@@ -149,15 +156,12 @@ void abcg::VulkanSwapchain::render(
     return;
   }
 
-  auto const &frame{m_frames.at(m_currentFrame)};
+  auto const &image{m_images.at(frame.imageIndex)};
+  frame.framebufferMain = image.framebufferMain;
 
-  // Wait until command buffer for acquired image has finished executing
-  while (vk::Result::eTimeout ==
-         device.waitForFences(frame.fence, VK_TRUE,
-                              std::numeric_limits<uint64_t>::max()))
-    ;
   device.resetFences(frame.fence);
   device.resetCommandPool(frame.commandPool);
+  device.resetDescriptorPool(frame.descriptorPool);
 
   // Main pass
   fun(frame);
@@ -187,7 +191,7 @@ void abcg::VulkanSwapchain::render(
   std::array waitStages{vk::PipelineStageFlags{
       vk::PipelineStageFlagBits::eColorAttachmentOutput}};
   std::array commandBuffers{frame.commandBuffer, frame.commandBufferUI};
-  std::array signalSemaphores{renderCompleteSemaphore};
+  std::array signalSemaphores{image.renderComplete};
 
   // Submit command buffer
   m_device.getQueues().graphics.submit(
@@ -205,9 +209,10 @@ void abcg::VulkanSwapchain::present() {
   if (m_swapChainRebuild)
     return;
 
+  auto const &frame{m_frames.at(m_currentFrame)};
+
   // Set semaphores to wait
-  auto &frameSemaphore{m_frameSemaphores.at(m_currentSemaphore)};
-  std::array waitSemaphores{frameSemaphore.renderComplete};
+  std::array waitSemaphores{m_images.at(frame.imageIndex).renderComplete};
 
   // Set swapchains
   std::array swapchains{m_swapchainKHR};
@@ -219,20 +224,18 @@ void abcg::VulkanSwapchain::present() {
         .pWaitSemaphores = waitSemaphores.data(),
         .swapchainCount = gsl::narrow<uint32_t>(swapchains.size()),
         .pSwapchains = swapchains.data(),
-        .pImageIndices = &m_currentFrame // Index of in-flight frame
-    });
+        .pImageIndices = &frame.imageIndex});
   } catch (vk::OutOfDateKHRError const &) {
     result = vk::Result::eErrorOutOfDateKHR;
   }
   if (result == vk::Result::eErrorOutOfDateKHR ||
       result == vk::Result::eSuboptimalKHR) {
     m_swapChainRebuild = true;
-    return;
   }
 
-  // Use the next set of semaphores
-  m_currentSemaphore =
-      (m_currentSemaphore + 1) % gsl::narrow<uint32_t>(m_frames.size());
+  // Use the next frame in flight
+  m_currentFrame =
+      (m_currentFrame + 1) % gsl::narrow<uint32_t>(m_frames.size());
 }
 
 bool abcg::VulkanSwapchain::checkRebuild(VulkanSettings const &settings,
@@ -354,7 +357,8 @@ bool abcg::VulkanSwapchain::checkRebuild(VulkanSettings const &settings,
 
   createRenderPasses(settings);
 
-  createFrames();
+  createImages();
+  createFrames(settings);
 
   if (settings.depthBufferSize > 0 || settings.stencilBufferSize > 0) {
     createDepthResources(settings);
@@ -391,7 +395,8 @@ abcg::VulkanDevice const &abcg::VulkanSwapchain::getDevice() const noexcept {
 /**
  * @brief Returns the in-flight frames.
  *
- * @return Container of in-flight frames.
+ * @return Container of in-flight frames. Its size is the number of frames in
+ * flight, not the number of swapchain images.
  */
 std::vector<abcg::VulkanFrame> const &
 abcg::VulkanSwapchain::getFrames() const noexcept {
@@ -408,6 +413,25 @@ abcg::VulkanSwapchain::getCurrentFrame() const noexcept {
   return m_frames[m_currentFrame];
 }
 
+/**
+ * @brief Returns the number of frames in flight.
+ *
+ * @return Number of frames that can be recorded by the CPU while previous
+ * frames are still being rendered.
+ */
+uint32_t abcg::VulkanSwapchain::getFramesInFlight() const noexcept {
+  return gsl::narrow_cast<uint32_t>(m_frames.size());
+}
+
+/**
+ * @brief Returns the number of swapchain images.
+ *
+ * @return Number of images created by the presentation engine.
+ */
+uint32_t abcg::VulkanSwapchain::getImageCount() const noexcept {
+  return gsl::narrow_cast<uint32_t>(m_images.size());
+}
+
 /**
  * @brief Returns the main render pass.
  *
@@ -445,20 +469,14 @@ abcg::VulkanImage const &abcg::VulkanSwapchain::getDepthImage() const noexcept {
   return m_depthImage;
 }
 
-void abcg::VulkanSwapchain::createFrames() {
-  auto const swapchainImages{
-      static_cast<vk::Device>(m_device).getSwapchainImagesKHR(m_swapchainKHR)};
+void abcg::VulkanSwapchain::createImages() {
+  auto const &device{static_cast<vk::Device>(m_device)};
+  auto const swapchainImages{device.getSwapchainImagesKHR(m_swapchainKHR)};
 
   // Create image views
-  m_currentFrame = 0;
-  m_frames.resize(swapchainImages.size());
-  m_currentSemaphore = 0;
-  m_frameSemaphores.resize(swapchainImages.size());
-
-  for (auto &&[frame, image, index] :
-       iter::zip(m_frames, swapchainImages, iter::range(m_frames.size()))) {
-    frame.index = gsl::narrow<uint32_t>(index);
-    frame.colorImage.create(
+  m_images.resize(swapchainImages.size());
+  for (auto &&[swapchainImage, image] : iter::zip(m_images, swapchainImages)) {
+    swapchainImage.colorImage.create(
         m_device,
         {.viewInfo = {
              .image = image,
@@ -467,6 +485,83 @@ void abcg::VulkanSwapchain::createFrames() {
              .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
                                   .levelCount = 1,
                                   .layerCount = 1}}});
+    swapchainImage.renderComplete = device.createSemaphore({});
+  }
+}
+
+void abcg::VulkanSwapchain::destroyImages() {
+  auto const &device{static_cast<vk::Device>(m_device)};
+
+  for (auto &image : m_images) {
+    device.destroyFramebuffer(image.framebufferMain);
+    device.destroySemaphore(image.renderComplete);
+    image.colorImage.destroy();
+  }
+
+  m_images.clear();
+}
+
+void abcg::VulkanSwapchain::createFrames(VulkanSettings const &settings) {
+  auto const &device{static_cast<vk::Device>(m_device)};
+  auto const &queuesFamilies{m_device.getPhysicalDevice().getQueuesFamilies()};
+
+  if (!queuesFamilies.graphics.has_value()) {
+    throw abcg::RuntimeError("Graphics queue family not found");
+  }
+  auto const graphicsQueueFamily{queuesFamilies.graphics.value()};
+
+  // Zero frames in flight means one frame per swapchain image
+  auto const framesInFlight{settings.framesInFlight > 0
+                                ? settings.framesInFlight
+                                : gsl::narrow<uint32_t>(m_images.size())};
+
+  // Small pool for descriptor sets that live for a single frame
+  std::vector<vk::DescriptorPoolSize> const poolSizes{
+      {{vk::DescriptorType::eUniformBuffer, 64},
+       {vk::DescriptorType::eUniformBufferDynamic, 64},
+       {vk::DescriptorType::eStorageBuffer, 64},
+       {vk::DescriptorType::eCombinedImageSampler, 64}}};
+
+  m_currentFrame = 0;
+  m_frames.resize(framesInFlight);
+  m_presentCompleteSemaphores.resize(framesInFlight);
+
+  for (auto &&[frame, semaphore, index] :
+       iter::zip(m_frames, m_presentCompleteSemaphores,
+                 iter::range(framesInFlight))) {
+    frame.index = index;
+
+    // Each frame has its own transient graphics command pool
+    frame.commandPool = device.createCommandPool(
+        {.flags = vk::CommandPoolCreateFlagBits::eTransient,
+         .queueFamilyIndex = graphicsQueueFamily});
+
+    // Create a primary command buffer
+    frame.commandBuffer =
+        device
+            .allocateCommandBuffers({.commandPool = frame.commandPool,
+                                     .level = vk::CommandBufferLevel::ePrimary,
+                                     .commandBufferCount = 1})
+            .front();
+
+    // Create a primary command buffer for the UI
+    frame.commandBufferUI =
+        device
+            .allocateCommandBuffers({.commandPool = frame.commandPool,
+                                     .level = vk::CommandBufferLevel::ePrimary,
+                                     .commandBufferCount = 1})
+            .front();
+
+    // Create fence
+    frame.fence =
+        device.createFence({.flags = vk::FenceCreateFlagBits::eSignaled});
+
+    frame.descriptorPool = device.createDescriptorPool(
+        {.maxSets = 64,
+         .poolSizeCount = gsl::narrow<uint32_t>(poolSizes.size()),
+         .pPoolSizes = poolSizes.data()});
+
+    semaphore = device.createSemaphore({});
   }
 }
 
@@ -474,19 +569,17 @@ void abcg::VulkanSwapchain::destroyFrames() {
   auto const &device{static_cast<vk::Device>(m_device)};
 
   for (auto &frame : m_frames) {
+    device.destroyDescriptorPool(frame.descriptorPool);
     device.destroyCommandPool(frame.commandPool);
     device.destroyFence(frame.fence);
-    frame.colorImage.destroy();
-    device.destroyFramebuffer(frame.framebufferMain);
   }
 
-  for (auto &frameSemaphore : m_frameSemaphores) {
-    device.destroySemaphore(frameSemaphore.presentComplete);
-    device.destroySemaphore(frameSemaphore.renderComplete);
+  for (auto &semaphore : m_presentCompleteSemaphores) {
+    device.destroySemaphore(semaphore);
   }
 
   m_frames.clear();
-  m_frameSemaphores.clear();
+  m_presentCompleteSemaphores.clear();
 }
 
 // TODO:
@@ -785,40 +878,9 @@ void abcg::VulkanSwapchain::destroyRenderPasses() {
 
 void abcg::VulkanSwapchain::createFramebuffers(VulkanSettings const &settings) {
   auto const &device{static_cast<vk::Device>(m_device)};
-  auto const &queuesFamilies{m_device.getPhysicalDevice().getQueuesFamilies()};
   auto const sampleCount{m_device.getPhysicalDevice().getSampleCount()};
 
-  if (!queuesFamilies.graphics.has_value()) {
-    throw abcg::RuntimeError("Graphics queue family not found");
-  }
-  auto const graphicsQueueFamily{queuesFamilies.graphics.value()};
-
-  for (auto &frame : m_frames) {
-    // Each frame has its own transient graphics command pool
-    frame.commandPool = device.createCommandPool(
-        {.flags = vk::CommandPoolCreateFlagBits::eTransient,
-         .queueFamilyIndex = graphicsQueueFamily});
-
-    // Create a primary command buffer
-    frame.commandBuffer =
-        device
-            .allocateCommandBuffers({.commandPool = frame.commandPool,
-                                     .level = vk::CommandBufferLevel::ePrimary,
-                                     .commandBufferCount = 1})
-            .front();
-
-    // Create a primary command buffer for the UI
-    frame.commandBufferUI =
-        device
-            .allocateCommandBuffers({.commandPool = frame.commandPool,
-                                     .level = vk::CommandBufferLevel::ePrimary,
-                                     .commandBufferCount = 1})
-            .front();
-
-    // Create fence
-    frame.fence =
-        device.createFence({.flags = vk::FenceCreateFlagBits::eSignaled});
-
+  for (auto &image : m_images) {
     // Set attachments
     std::vector<vk::ImageView> attachments{};
     if (sampleCount > vk::SampleCountFlagBits::e1) {
@@ -829,18 +891,18 @@ void abcg::VulkanSwapchain::createFramebuffers(VulkanSettings const &settings) {
       if (settings.depthBufferSize > 0 || settings.stencilBufferSize > 0) {
         attachments.push_back(m_depthImage.getView());
       }
-      attachments.push_back(frame.colorImage.getView());
+      attachments.push_back(image.colorImage.getView());
     } else {
       // 0: Color buffer
       // 1: Depth buffer (optional)
-      attachments.push_back(frame.colorImage.getView());
+      attachments.push_back(image.colorImage.getView());
       if (settings.depthBufferSize > 0 || settings.stencilBufferSize > 0) {
         attachments.push_back(m_depthImage.getView());
       }
     }
 
     // Create framebuffers
-    frame.framebufferMain = device.createFramebuffer(
+    image.framebufferMain = device.createFramebuffer(
         {.renderPass = m_renderPassMain,
          .attachmentCount = gsl::narrow<uint32_t>(attachments.size()),
          .pAttachments = attachments.data(),
@@ -848,10 +910,4 @@ void abcg::VulkanSwapchain::createFramebuffers(VulkanSettings const &settings) {
          .height = m_swapchainExtent.height,
          .layers = 1});
   }
-
-  // Create semaphores
-  for (auto &frameSemaphore : m_frameSemaphores) {
-    frameSemaphore.presentComplete = device.createSemaphore({});
-    frameSemaphore.renderComplete = device.createSemaphore({});
-  }
 }
@@ -30,14 +30,28 @@ class VulkanWindow;
 /**
  * @brief Data needed by a rendering frame.
  *
+ * Each frame in flight has its own command pool, command buffers, fence, and
+ * descriptor pool. The number of frames in flight is set by
+ * abcg::VulkanSettings::framesInFlight and is independent of the number of
+ * swapchain images. The resources of a frame are reused only after the device
+ * has finished executing the commands previously recorded with them.
  */
 struct abcg::VulkanFrame {
+  /** @brief Index of the frame in flight, smaller than
+   * abcg::VulkanSwapchain::getFramesInFlight. Use it to select per-frame
+   * data, such as the region of a buffer ring (see
+   * abcg::VulkanBuffer::getRingOffset). */
   uint32_t index{};
+  /** @brief Index of the swapchain image acquired for this frame. */
+  uint32_t imageIndex{};
   vk::CommandPool commandPool;
   vk::CommandBuffer commandBuffer;
   vk::CommandBuffer commandBufferUI;
   vk::Fence fence;
-  VulkanImage colorImage;
+  /** @brief Descriptor pool reset at the beginning of the frame, for
+   * descriptor sets used only during the frame. */
+  vk::DescriptorPool descriptorPool;
+  /** @brief Framebuffer of the main render pass for the acquired image. */
   vk::Framebuffer framebufferMain;
 };
 
@@ -62,13 +76,17 @@ public:
   [[nodiscard]] VulkanDevice const &getDevice() const noexcept;
   [[nodiscard]] std::vector<VulkanFrame> const &getFrames() const noexcept;
   [[nodiscard]] VulkanFrame const &getCurrentFrame() const noexcept;
+  [[nodiscard]] uint32_t getFramesInFlight() const noexcept;
+  [[nodiscard]] uint32_t getImageCount() const noexcept;
   [[nodiscard]] vk::RenderPass const &getMainRenderPass() const noexcept;
   [[nodiscard]] vk::RenderPass const &getUIRenderPass() const noexcept;
   [[nodiscard]] vk::Extent2D const &getExtent() const noexcept;
   [[nodiscard]] VulkanImage const &getDepthImage() const noexcept;
 
 private:
-  void createFrames();
+  void createImages();
+  void destroyImages();
+  void createFrames(VulkanSettings const &settings);
   void destroyFrames();
 
   [[nodiscard]] vk::Format getDepthFormat(VulkanSettings const &settings);
@@ -90,18 +108,22 @@ private:
   vk::Extent2D m_swapchainExtent;
   bool m_swapChainRebuild{};
 
-  // Data for swapchain synchronization
-  struct FrameSemaphores {
-    vk::Semaphore presentComplete;
+  // Data of each swapchain image
+  struct SwapchainImage {
+    VulkanImage colorImage;
+    vk::Framebuffer framebufferMain;
+    // Signaled when rendering to the image is complete. It is known to be no
+    // longer in use by the presentation engine only when the image is
+    // acquired again, so it can't belong to the frame in flight.
     vk::Semaphore renderComplete;
   };
+  std::vector<SwapchainImage> m_images;
 
+  // Frames in flight, and semaphores signaled when the image acquired by each
+  // frame is available
   uint32_t m_currentFrame{};
   std::vector<VulkanFrame> m_frames;
-  // Current set of swapchain wait semaphores we're using (needs to be distinct
-  // from per frame data)
-  uint32_t m_currentSemaphore{};
-  std::vector<FrameSemaphores> m_frameSemaphores;
+  std::vector<vk::Semaphore> m_presentCompleteSemaphores;
 
   VulkanImage m_depthImage;
   VulkanImage m_MSAAImage;
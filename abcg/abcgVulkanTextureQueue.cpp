@@ -0,0 +1,301 @@
+/**
+ * @file abcgVulkanTextureQueue.cpp
+ * @brief Definition of abcg::VulkanTextureQueue members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgVulkanTextureQueue.hpp"
+#include "abcgThreadPool.hpp"
+
+#include <cppitertools/itertools.hpp>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <span>
+#include <string>
+#include <utility>
+
+#include "abcgException.hpp"
+
+/**
+ * @brief State of a texture being loaded by abcg::VulkanTextureQueue. For
+ * internal use.
+ */
+struct abcg::VulkanTextureJob {
+  std::shared_future<SurfacePtr> decoded;
+  VulkanDevice const *device{};
+  bool generateMipmaps{};
+  VulkanMipmapMode mipmapMode{};
+  VulkanImage const *placeholder{};
+  VulkanImage image;
+  std::string error;
+  bool done{};
+};
+
+namespace {
+[[nodiscard]] bool isDecoded(abcg::VulkanTextureJob const &job) {
+  return job.decoded.wait_for(std::chrono::seconds::zero()) ==
+         std::future_status::ready;
+}
+
+// Creates the textures of the jobs, waiting for their images if needed. Jobs
+// with the same settings are created with a single submission.
+void uploadJobs(std::vector<abcg::VulkanTextureJob *> jobs) {
+  while (!jobs.empty()) {
+    auto const *first{jobs.front()};
+    auto const groupEnd{std::stable_partition(
+        jobs.begin(), jobs.end(), [first](auto const *job) {
+          return job->device == first->device &&
+                 job->generateMipmaps == first->generateMipmaps &&
+                 job->mipmapMode == first->mipmapMode;
+        })};
+
+    std::vector<abcg::VulkanTextureJob *> group;
+    std::vector<SDL_Surface const *> images;
+    for (auto *job : std::span{jobs.begin(), groupEnd}) {
+      try {
+        images.push_back(job->decoded.get().get());
+        group.push_back(job);
+      } catch (std::exception const &exception) {
+        job->error = exception.what();
+        job->done = true;
+      }
+    }
+
+    if (!group.empty()) {
+      try {
+        auto textures{abcg::VulkanImage::createBatch(
+            *first->device, images, first->generateMipmaps,
+            first->mipmapMode)};
+        for (auto &&[job, texture] : iter::zip(group, textures)) {
+          job->image = texture;
+        }
+      } catch (std::exception const &exception) {
+        for (auto *job : group) {
+          job->error = exception.what();
+        }
+      }
+    }
+
+    // Release the decoded images
+    for (auto *job : std::span{jobs.begin(), groupEnd}) {
+      job->decoded = {};
+      job->done = true;
+    }
+    jobs.erase(jobs.begin(), groupEnd);
+  }
+}
+} // namespace
+
+/**
+ * @brief Returns the texture.
+ *
+ * @throw abcg::RuntimeError if the handle is default-constructed.
+ *
+ * @return Texture if it is ready, or the placeholder texture otherwise.
+ */
+abcg::VulkanImage const &abcg::VulkanTextureHandle::getImage() const {
+  if (!m_job) {
+    throw abcg::RuntimeError("Invalid texture handle");
+  }
+  return isReady() ? m_job->image : *m_job->placeholder;
+}
+
+/**
+ * @brief Returns the descriptor image information of the texture.
+ *
+ * @throw abcg::RuntimeError if the handle is default-constructed.
+ *
+ * @return Descriptor image information of the texture if it is ready, or of
+ * the placeholder texture otherwise.
+ */
+vk::DescriptorImageInfo const &
+abcg::VulkanTextureHandle::getDescriptorImageInfo() const {
+  return getImage().getDescriptorImageInfo();
+}
+
+/**
+ * @brief Returns whether the texture is created.
+ *
+ * @return `true` if the texture is ready to use; `false` otherwise.
+ */
+bool abcg::VulkanTextureHandle::isReady() const noexcept {
+  return m_job && m_job->done && m_job->error.empty();
+}
+
+/**
+ * @brief Returns whether the texture failed to load.
+ *
+ * The placeholder texture remains in use if the texture failed to load.
+ *
+ * @return `true` if the texture could not be loaded; `false` otherwise.
+ */
+bool abcg::VulkanTextureHandle::hasFailed() const noexcept {
+  return m_job && m_job->done && !m_job->error.empty();
+}
+
+/**
+ * @brief Returns whether the handle refers to a texture.
+ *
+ * @return `false` if the handle is default-constructed; `true` otherwise.
+ */
+bool abcg::VulkanTextureHandle::isValid() const noexcept {
+  return m_job != nullptr;
+}
+
+/**
+ * @brief Waits for the texture and returns it.
+ *
+ * If the texture is not created yet, this waits for its image to be decoded
+ * and creates it immediately.
+ *
+ * @throw abcg::RuntimeError if the handle is default-constructed, or if the
+ * texture could not be loaded.
+ *
+ * @return Texture.
+ */
+abcg::VulkanImage const &abcg::VulkanTextureHandle::get() {
+  if (!m_job) {
+    throw abcg::RuntimeError("Invalid texture handle");
+  }
+  if (!m_job->done) {
+    uploadJobs({m_job.get()});
+  }
+  if (!m_job->error.empty()) {
+    throw abcg::RuntimeError(m_job->error);
+  }
+  return m_job->image;
+}
+
+/**
+ * @brief Creates the placeholder texture of the queue.
+ *
+ * @param device Logical device.
+ */
+void abcg::VulkanTextureQueue::create(VulkanDevice const &device) {
+  m_device = &device;
+
+  // 1x1 gray texture
+  SurfacePtr const surface{
+      SDL_CreateRGBSurfaceWithFormat(0, 1, 1, 32, SDL_PIXELFORMAT_RGBA32)};
+  if (!surface) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to create surface: {}", SDL_GetError()));
+  }
+  std::array<Uint8, 4> const gray{128, 128, 128, 255};
+  std::ranges::copy(gray, static_cast<Uint8 *>(surface->pixels));
+
+  std::array<SDL_Surface const *, 1> const images{surface.get()};
+  m_placeholder = VulkanImage::createBatch(device, images, false).front();
+}
+
+/**
+ * @brief Discards all textures in the queue and destroys the placeholder
+ * texture.
+ *
+ * Images being decoded are released once decoded.
+ */
+void abcg::VulkanTextureQueue::destroy() {
+  if (m_device == nullptr) {
+    return;
+  }
+  m_jobs.clear();
+  m_placeholder.destroy();
+  m_placeholder = {};
+  m_device = nullptr;
+}
+
+/**
+ * @brief Submits a texture to be loaded.
+ *
+ * The image is decoded in a worker thread. The function returns without
+ * waiting for it.
+ *
+ * @param path Path to the image file. The path is copied.
+ * @param generateMipmaps Whether to generate mipmap levels.
+ * @param mipmapMode Method used to generate the mipmap levels.
+ *
+ * @return Handle to the texture.
+ */
+abcg::VulkanTextureHandle
+abcg::VulkanTextureQueue::submit(std::string_view path, bool generateMipmaps,
+                                 VulkanMipmapMode mipmapMode) {
+  auto job{std::make_shared<VulkanTextureJob>()};
+  // The path is copied, as the view may not outlive the decoding
+  job->decoded = getThreadPool()
+                     .submit([path = std::string{path}] {
+                       return VulkanImage::decode(path);
+                     })
+                     .share();
+  job->device = m_device;
+  job->generateMipmaps = generateMipmaps;
+  job->mipmapMode = mipmapMode;
+  job->placeholder = &m_placeholder;
+
+  VulkanTextureHandle handle;
+  handle.m_job = job;
+  m_jobs.push_back(std::move(job));
+  return handle;
+}
+
+/**
+ * @brief Creates the textures whose images are decoded.
+ *
+ * Textures with the same settings are created with a single submission.
+ * Textures whose handles were destroyed are discarded without being created.
+ *
+ * @param maxUploads Maximum number of textures to create, to spread the cost
+ * of creating many textures across frames.
+ *
+ * @return Number of textures that finished loading, with or without errors.
+ */
+std::size_t abcg::VulkanTextureQueue::poll(std::size_t maxUploads) {
+  std::vector<VulkanTextureJob *> jobs;
+  for (auto &job : m_jobs) {
+    // The queue holds the only reference to jobs of destroyed handles
+    if (job.use_count() == 1) {
+      job.reset();
+      continue;
+    }
+    if (!job->done && jobs.size() < maxUploads && isDecoded(*job)) {
+      jobs.push_back(job.get());
+    }
+  }
+  uploadJobs(jobs);
+
+  std::erase_if(m_jobs, [](auto const &job) { return !job || job->done; });
+
+  return jobs.size();
+}
+
+/**
+ * @brief Waits until the images of all textures in the queue are decoded and
+ * creates them.
+ */
+void abcg::VulkanTextureQueue::finish() {
+  std::vector<VulkanTextureJob *> jobs;
+  for (auto const &job : m_jobs) {
+    if (!job->done) {
+      jobs.push_back(job.get());
+    }
+  }
+  uploadJobs(jobs);
+  m_jobs.clear();
+}
+
+/**
+ * @brief Returns the number of textures that are still being loaded.
+ *
+ * @return Number of textures in the queue.
+ */
+std::size_t abcg::VulkanTextureQueue::getPendingCount() const noexcept {
+  return m_jobs.size();
+}
@@ -0,0 +1,98 @@
+/**
+ * @file abcgVulkanTextureQueue.hpp
+ * @brief Header file of abcg::VulkanTextureQueue.
+ *
+ * Declaration of abcg::VulkanTextureQueue and abcg::VulkanTextureHandle.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_VULKAN_TEXTURE_QUEUE_HPP_
+#define ABCG_VULKAN_TEXTURE_QUEUE_HPP_
+
+#include "abcgVulkanImage.hpp"
+
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace abcg {
+struct VulkanTextureJob;
+class VulkanTextureHandle;
+class VulkanTextureQueue;
+} // namespace abcg
+
+/**
+ * @brief Handle to a texture being loaded by an abcg::VulkanTextureQueue.
+ *
+ * Until the texture is created, abcg::VulkanTextureHandle::getImage returns a
+ * placeholder texture owned by the queue. Descriptor sets that refer to the
+ * placeholder must be updated once the texture is ready. The texture is then
+ * owned by the caller and must be destroyed with abcg::VulkanImage::destroy.
+ * Textures of handles destroyed before the upload are never created.
+ *
+ * A default-constructed handle refers to no texture.
+ */
+class abcg::VulkanTextureHandle {
+public:
+  [[nodiscard]] VulkanImage const &getImage() const;
+  [[nodiscard]] vk::DescriptorImageInfo const &getDescriptorImageInfo() const;
+  [[nodiscard]] bool isReady() const noexcept;
+  [[nodiscard]] bool hasFailed() const noexcept;
+  [[nodiscard]] bool isValid() const noexcept;
+  VulkanImage const &get();
+
+private:
+  friend class VulkanTextureQueue;
+
+  std::shared_ptr<VulkanTextureJob> m_job;
+};
+
+/**
+ * @brief Loads Vulkan textures without blocking the render loop.
+ *
+ * Images submitted to the queue are decoded and converted by the worker
+ * threads of abcg::getThreadPool. Calls to abcg::VulkanTextureQueue::poll then
+ * create the textures whose images are ready, with a single submission per
+ * poll. Only the upload runs on the render thread.
+ *
+ * abcg::VulkanWindow owns a queue that is polled once per frame before
+ * abcg::VulkanWindow::onPaint, and destroyed after
+ * abcg::VulkanWindow::onDestroy.
+ *
+ * @sa abcg::VulkanWindow::getTextureQueue.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::VulkanTextureQueue {
+public:
+  VulkanTextureQueue() = default;
+  VulkanTextureQueue(VulkanTextureQueue const &) = delete;
+  VulkanTextureQueue(VulkanTextureQueue &&) = delete;
+  VulkanTextureQueue &operator=(VulkanTextureQueue const &) = delete;
+  VulkanTextureQueue &operator=(VulkanTextureQueue &&) = delete;
+  ~VulkanTextureQueue() = default;
+
+  void create(VulkanDevice const &device);
+  void destroy();
+
+  [[nodiscard]] VulkanTextureHandle
+  submit(std::string_view path, bool generateMipmaps = true,
+         VulkanMipmapMode mipmapMode = VulkanMipmapMode::Auto);
+  std::size_t
+  poll(std::size_t maxUploads = std::numeric_limits<std::size_t>::max());
+  void finish();
+
+  [[nodiscard]] std::size_t getPendingCount() const noexcept;
+
+private:
+  VulkanDevice const *m_device{};
+  VulkanImage m_placeholder;
+  std::vector<std::shared_ptr<VulkanTextureJob>> m_jobs;
+};
+
+#endif
@@ -0,0 +1,493 @@
+/**
+ * @file abcgVulkanUploadContext.cpp
+ * @brief Definition of abcg::VulkanUploadContext members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgVulkanUploadContext.hpp"
+
+#include <cppitertools/itertools.hpp>
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+[[nodiscard]] constexpr uint64_t alignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+/**
+ * @brief Command buffer and resources of a batch of transfers.
+ */
+struct abcg::VulkanUploadContext::Batch {
+  vk::CommandBuffer commandBuffer{};
+  vk::Fence fence{};
+  // Sequence number of the batch using this slot
+  uint64_t id{};
+  // Whether the command buffer is being recorded
+  bool recording{};
+  // Whether the command buffer was submitted and has not been retired yet
+  bool submitted{};
+  // End of the staging ring range read by the batch
+  uint64_t stagingEnd{};
+  // Staging buffers of data larger than the staging ring
+  std::vector<std::pair<vk::Buffer, VulkanAllocation>> overflow{};
+};
+
+/**
+ * @brief Returns whether the upload has completed.
+ *
+ * @return `true` if the commands of the upload finished executing on the
+ * device; `false` otherwise.
+ */
+bool abcg::VulkanUploadHandle::isComplete() const {
+  return m_context == nullptr || m_context->isComplete(*this);
+}
+
+/**
+ * @brief Blocks until the upload has completed.
+ *
+ * If the upload was not submitted yet, the current batch of the upload
+ * context is submitted.
+ */
+void abcg::VulkanUploadHandle::wait() const {
+  if (m_context != nullptr) {
+    m_context->wait(*this);
+  }
+}
+
+abcg::VulkanUploadContext::VulkanUploadContext() = default;
+
+abcg::VulkanUploadContext::~VulkanUploadContext() = default;
+
+/**
+ * @brief Creates the staging ring buffer and the command buffers.
+ *
+ * @param device Logical device.
+ * @param allocator Allocator used for the staging memory.
+ * @param queue Queue to which the batches are submitted.
+ * @param queueFamilyIndex Queue family of `queue`.
+ * @param stagingSize Size of the staging ring buffer, in bytes.
+ * @param batchCount Maximum number of batches in flight. Recording a new batch
+ * waits for the batch submitted `batchCount` submissions earlier.
+ */
+void abcg::VulkanUploadContext::create(vk::Device const &device,
+                                       VulkanAllocator &allocator,
+                                       vk::Queue const &queue,
+                                       uint32_t queueFamilyIndex,
+                                       vk::DeviceSize stagingSize,
+                                       uint32_t batchCount) {
+  std::scoped_lock const lock{m_mutex};
+
+  m_device = device;
+  m_allocator = &allocator;
+  m_queue = queue;
+
+  m_commandPool = m_device.createCommandPool(
+      {.flags = vk::CommandPoolCreateFlagBits::eTransient |
+                vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+       .queueFamilyIndex = queueFamilyIndex});
+
+  m_stagingSize = std::max(stagingSize, vk::DeviceSize{1});
+  std::tie(m_stagingBuffer, m_stagingAllocation) =
+      createStagingBuffer(m_stagingSize);
+  m_stagingHead = 0;
+  m_stagingTail = 0;
+
+  auto const commandBuffers{m_device.allocateCommandBuffers(
+      {.commandPool = m_commandPool,
+       .level = vk::CommandBufferLevel::ePrimary,
+       .commandBufferCount = std::max(batchCount, 1U)})};
+  m_batches.resize(commandBuffers.size());
+  for (auto &&[batch, commandBuffer] : iter::zip(m_batches, commandBuffers)) {
+    batch.commandBuffer = commandBuffer;
+    batch.fence = m_device.createFence({});
+  }
+  m_recordingBatch = 1;
+  m_completedBatch = 0;
+}
+
+/**
+ * @brief Waits for all uploads and releases the resources of the context.
+ */
+void abcg::VulkanUploadContext::destroy() {
+  std::scoped_lock const lock{m_mutex};
+  if (!m_commandPool) {
+    return;
+  }
+
+  waitIdle();
+
+  for (auto const &batch : m_batches) {
+    m_device.destroyFence(batch.fence);
+  }
+  m_batches.clear();
+
+  m_device.destroyBuffer(m_stagingBuffer);
+  m_allocator->free(m_stagingAllocation);
+  m_stagingBuffer = vk::Buffer{};
+
+  m_device.destroyCommandPool(m_commandPool);
+  m_commandPool = vk::CommandPool{};
+}
+
+/**
+ * @brief Copies data to staging memory.
+ *
+ * The staging memory is owned by the batch being recorded and is reused when
+ * the batch completes. Hence, transfer commands that read from the range must
+ * be recorded in the same batch, i.e., by calling this function from the
+ * function passed to abcg::VulkanUploadContext::record.
+ *
+ * @param data Data to be copied.
+ * @param alignment Alignment of the offset of the range, in bytes.
+ *
+ * @return Range of the staging memory containing a copy of `data`.
+ */
+abcg::VulkanStagingRange
+abcg::VulkanUploadContext::stage(std::span<std::byte const> data,
+                                 vk::DeviceSize alignment) {
+  std::scoped_lock const lock{m_mutex};
+  if (data.empty()) {
+    return {.buffer = m_stagingBuffer, .offset = 0, .size = 0};
+  }
+
+  std::optional<vk::DeviceSize> offset;
+  if (data.size() <= m_stagingSize) {
+    offset = allocateStaging(data.size(),
+                             std::max(alignment, vk::DeviceSize{1}));
+  }
+
+  auto &batch{getRecordingBatch()};
+
+  // Data that doesn't fit the ring goes to a buffer released with the batch
+  if (!offset.has_value()) {
+    auto &[buffer, allocation]{
+        batch.overflow.emplace_back(createStagingBuffer(data.size()))};
+    std::memcpy(allocation.mappedData, data.data(), data.size());
+    m_allocator->flush(allocation);
+    return {.buffer = buffer, .offset = 0, .size = data.size()};
+  }
+
+  std::memcpy(static_cast<std::byte *>(m_stagingAllocation.mappedData) +
+                  *offset,
+              data.data(), data.size());
+  m_allocator->flush(m_stagingAllocation, *offset, data.size());
+  return {.buffer = m_stagingBuffer, .offset = *offset, .size = data.size()};
+}
+
+/**
+ * @brief Records commands into the batch being recorded.
+ *
+ * The commands are submitted with the next call to
+ * abcg::VulkanUploadContext::submit.
+ *
+ * @param fun Function that records the commands. It may call
+ * abcg::VulkanUploadContext::stage, but must not submit the batch.
+ *
+ * @return Handle to the upload.
+ */
+abcg::VulkanUploadHandle abcg::VulkanUploadContext::record(
+    std::function<void(vk::CommandBuffer const &commandBuffer)> const &fun) {
+  std::scoped_lock const lock{m_mutex};
+
+  auto const &batch{getRecordingBatch()};
+  m_insideRecord = true;
+  auto const resetFlag{gsl::finally([this] { m_insideRecord = false; })};
+  fun(batch.commandBuffer);
+
+  return makeHandle();
+}
+
+/**
+ * @brief Records a copy of data to a buffer.
+ *
+ * @param buffer Destination buffer. It must have been created with the
+ * `eTransferDst` usage flag, and must be accessible by the queue of the
+ * context.
+ * @param data Data to be copied.
+ * @param offset Offset from the beginning of the buffer, in bytes.
+ *
+ * @return Handle to the upload.
+ */
+abcg::VulkanUploadHandle
+abcg::VulkanUploadContext::uploadBuffer(vk::Buffer const &buffer,
+                                        std::span<std::byte const> data,
+                                        vk::DeviceSize offset) {
+  return record([&](vk::CommandBuffer const &commandBuffer) {
+    auto const range{stage(data)};
+    commandBuffer.copyBuffer(range.buffer, buffer,
+                             {{.srcOffset = range.offset,
+                               .dstOffset = offset,
+                               .size = range.size}});
+  });
+}
+
+/**
+ * @brief Records a copy of data to an image, including the layout
+ * transitions.
+ *
+ * @param image Destination image. It must have been created with the
+ * `eTransferDst` usage flag, and must be accessible by the queue of the
+ * context.
+ * @param data Texel data.
+ * @param regions Regions to be copied. The buffer offsets are relative to the
+ * beginning of `data`.
+ * @param subresourceRange Subresources transitioned from the undefined layout
+ * to `finalLayout`.
+ * @param finalLayout Layout of the image after the copy.
+ *
+ * @return Handle to the upload.
+ */
+abcg::VulkanUploadHandle abcg::VulkanUploadContext::uploadImage(
+    vk::Image const &image, std::span<std::byte const> data,
+    std::span<vk::BufferImageCopy const> regions,
+    vk::ImageSubresourceRange const &subresourceRange,
+    vk::ImageLayout finalLayout) {
+  return record([&](vk::CommandBuffer const &commandBuffer) {
+    auto const range{stage(data)};
+
+    vk::ImageMemoryBarrier barrier{
+        .srcAccessMask = vk::AccessFlagBits::eNone,
+        .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .oldLayout = vk::ImageLayout::eUndefined,
+        .newLayout = vk::ImageLayout::eTransferDstOptimal,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = subresourceRange};
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                                  vk::PipelineStageFlagBits::eTransfer,
+                                  vk::DependencyFlags{}, {}, {}, {barrier});
+
+    std::vector<vk::BufferImageCopy> stagedRegions(regions.begin(),
+                                                   regions.end());
+    for (auto &region : stagedRegions) {
+      region.bufferOffset += range.offset;
+    }
+    commandBuffer.copyBufferToImage(range.buffer, image,
+                                    vk::ImageLayout::eTransferDstOptimal,
+                                    stagedRegions);
+
+    // Consumers wait for the fence of the batch, so there is no need to block
+    // any later stage of this queue
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eNone;
+    barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.newLayout = finalLayout;
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                  vk::PipelineStageFlagBits::eBottomOfPipe,
+                                  vk::DependencyFlags{}, {}, {}, {barrier});
+  });
+}
+
+/**
+ * @brief Submits the batch being recorded and retires completed batches.
+ *
+ * This function does not block, unless the number of batches in flight
+ * exceeds the batch count. It does nothing if no commands were recorded since
+ * the last submission.
+ */
+void abcg::VulkanUploadContext::submit() {
+  std::scoped_lock const lock{m_mutex};
+  if (m_batches.empty()) {
+    return;
+  }
+
+  if (slotOf(m_recordingBatch).recording) {
+    submitBatch();
+  }
+  retireBatches(m_recordingBatch - 1, false);
+}
+
+/**
+ * @brief Submits the batch being recorded and blocks until all uploads have
+ * completed.
+ */
+void abcg::VulkanUploadContext::waitIdle() {
+  std::scoped_lock const lock{m_mutex};
+  if (m_batches.empty()) {
+    return;
+  }
+
+  if (slotOf(m_recordingBatch).recording) {
+    submitBatch();
+  }
+  retireBatches(m_recordingBatch - 1, true);
+}
+
+/**
+ * @brief Returns whether an upload has completed.
+ *
+ * @param handle Handle returned by this context.
+ *
+ * @return `true` if the commands of the upload finished executing on the
+ * device; `false` otherwise.
+ */
+bool abcg::VulkanUploadContext::isComplete(VulkanUploadHandle const &handle) {
+  std::scoped_lock const lock{m_mutex};
+  if (handle.m_batch <= m_completedBatch) {
+    return true;
+  }
+  if (handle.m_batch >= m_recordingBatch) {
+    return false;
+  }
+
+  retireBatches(handle.m_batch, false);
+  return handle.m_batch <= m_completedBatch;
+}
+
+/**
+ * @brief Blocks until an upload has completed.
+ *
+ * If the upload was not submitted yet, the batch being recorded is submitted.
+ *
+ * @param handle Handle returned by this context.
+ */
+void abcg::VulkanUploadContext::wait(VulkanUploadHandle const &handle) {
+  std::scoped_lock const lock{m_mutex};
+  if (handle.m_batch <= m_completedBatch) {
+    return;
+  }
+
+  if (handle.m_batch == m_recordingBatch) {
+    submitBatch();
+  }
+  retireBatches(handle.m_batch, true);
+}
+
+abcg::VulkanUploadContext::Batch &
+abcg::VulkanUploadContext::slotOf(uint64_t batch) {
+  return m_batches.at(batch % m_batches.size());
+}
+
+abcg::VulkanUploadContext::Batch &
+abcg::VulkanUploadContext::getRecordingBatch() {
+  auto &batch{slotOf(m_recordingBatch)};
+  if (batch.recording) {
+    return batch;
+  }
+
+  // Wait for the batch that used the slot before
+  if (batch.submitted) {
+    retireBatches(batch.id, true);
+  }
+
+  batch.id = m_recordingBatch;
+  batch.commandBuffer.reset();
+  batch.commandBuffer.begin(
+      {.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+  batch.recording = true;
+  return batch;
+}
+
+abcg::VulkanUploadHandle abcg::VulkanUploadContext::makeHandle() noexcept {
+  VulkanUploadHandle handle;
+  handle.m_context = this;
+  handle.m_batch = m_recordingBatch;
+  return handle;
+}
+
+std::optional<vk::DeviceSize>
+abcg::VulkanUploadContext::allocateStaging(vk::DeviceSize size,
+                                           vk::DeviceSize alignment) {
+  while (true) {
+    // Restart from the beginning of the buffer when it is not in use
+    if (m_stagingTail == m_stagingHead) {
+      m_stagingHead = m_stagingTail = alignUp(m_stagingHead, m_stagingSize);
+    }
+
+    // Place the range after the head, or at the beginning of the buffer if it
+    // would wrap around
+    auto const headOffset{m_stagingHead % m_stagingSize};
+    auto offset{alignUp(headOffset, alignment)};
+    auto begin{m_stagingHead - headOffset + offset};
+    if (offset + size > m_stagingSize) {
+      offset = 0;
+      begin = alignUp(m_stagingHead, m_stagingSize);
+    }
+    if (begin + size - m_stagingTail <= m_stagingSize) {
+      m_stagingHead = begin + size;
+      return offset;
+    }
+
+    // Reclaim memory of completed batches, waiting for the oldest one if
+    // none has completed yet
+    if (m_completedBatch + 1 < m_recordingBatch) {
+      auto const completedBatch{m_completedBatch};
+      retireBatches(m_recordingBatch - 1, false);
+      if (m_completedBatch == completedBatch) {
+        retireBatches(m_completedBatch + 1, true);
+      }
+      continue;
+    }
+
+    // The remaining memory is used by the batch being recorded. It can be
+    // submitted only if no commands are being recorded into it.
+    if (m_insideRecord || !slotOf(m_recordingBatch).recording) {
+      return std::nullopt;
+    }
+    submitBatch();
+  }
+}
+
+std::pair<vk::Buffer, abcg::VulkanAllocation>
+abcg::VulkanUploadContext::createStagingBuffer(vk::DeviceSize size) const {
+  auto buffer{m_device.createBuffer(
+      {.size = size,
+       .usage = vk::BufferUsageFlagBits::eTransferSrc,
+       .sharingMode = vk::SharingMode::eExclusive})};
+  auto const allocation{m_allocator->allocateForBuffer(
+      buffer, vk::MemoryPropertyFlagBits::eHostVisible)};
+  return {buffer, allocation};
+}
+
+void abcg::VulkanUploadContext::submitBatch() {
+  auto &batch{slotOf(m_recordingBatch)};
+  batch.commandBuffer.end();
+
+  m_device.resetFences(batch.fence);
+  m_queue.submit(
+      {{.commandBufferCount = 1, .pCommandBuffers = &batch.commandBuffer}},
+      batch.fence);
+
+  batch.recording = false;
+  batch.submitted = true;
+  batch.stagingEnd = m_stagingHead;
+  ++m_recordingBatch;
+}
+
+void abcg::VulkanUploadContext::retireBatches(uint64_t batch, bool wait) {
+  // Batches complete in submission order
+  while (m_completedBatch < std::min(batch, m_recordingBatch - 1)) {
+    auto &oldest{slotOf(m_completedBatch + 1)};
+    if (wait) {
+      while (vk::Result::eTimeout ==
+             m_device.waitForFences(oldest.fence, VK_TRUE,
+                                    std::numeric_limits<uint64_t>::max()))
+        ;
+    } else if (m_device.getFenceStatus(oldest.fence) != vk::Result::eSuccess) {
+      return;
+    }
+    m_stagingTail = oldest.stagingEnd;
+    releaseBatch(oldest);
+    ++m_completedBatch;
+  }
+}
+
+void abcg::VulkanUploadContext::releaseBatch(Batch &batch) {
+  for (auto &[buffer, allocation] : batch.overflow) {
+    m_device.destroyBuffer(buffer);
+    m_allocator->free(allocation);
+  }
+  batch.overflow.clear();
+  batch.recording = false;
+  batch.submitted = false;
+}
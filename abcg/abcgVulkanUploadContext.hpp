@@ -0,0 +1,168 @@
+/**
+ * @file abcgVulkanUploadContext.hpp
+ * @brief Header file of abcg::VulkanUploadContext.
+ *
+ * Declaration of abcg::VulkanUploadContext and abcg::VulkanUploadHandle.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_VULKAN_UPLOAD_CONTEXT_HPP_
+#define ABCG_VULKAN_UPLOAD_CONTEXT_HPP_
+
+#include "abcgVulkanAllocator.hpp"
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace abcg {
+struct VulkanStagingRange;
+class VulkanUploadHandle;
+class VulkanUploadContext;
+} // namespace abcg
+
+/**
+ * @brief Range of the staging memory of an abcg::VulkanUploadContext.
+ *
+ * @sa abcg::VulkanUploadContext::stage.
+ */
+struct abcg::VulkanStagingRange {
+  /** @brief Staging buffer containing the range. */
+  vk::Buffer buffer{};
+  /** @brief Offset of the range from the beginning of the buffer. */
+  vk::DeviceSize offset{};
+  /** @brief Size of the range, in bytes. */
+  vk::DeviceSize size{};
+};
+
+/**
+ * @brief Handle to the commands recorded in an abcg::VulkanUploadContext.
+ *
+ * The handle refers to the batch of commands that contains the upload. A
+ * default-constructed handle refers to no upload and is always complete.
+ */
+class abcg::VulkanUploadHandle {
+public:
+  [[nodiscard]] bool isComplete() const;
+  void wait() const;
+
+private:
+  friend class VulkanUploadContext;
+
+  VulkanUploadContext *m_context{};
+  uint64_t m_batch{};
+};
+
+/**
+ * @brief Context for recording transfers to device local memory without
+ * stalling the CPU.
+ *
+ * Data is copied to a persistently mapped staging ring buffer, and transfer
+ * commands are recorded into the command buffer of the current batch. A batch
+ * is submitted to the transfer queue on abcg::VulkanUploadContext::submit,
+ * which abcg::VulkanWindow calls once per frame. Completion of each batch is
+ * tracked with a fence, and staging memory is reused as soon as the batch that
+ * read from it completes.
+ *
+ * Every recording function returns an abcg::VulkanUploadHandle that can be
+ * polled or waited on. Waiting on an upload that was not submitted yet
+ * submits the current batch.
+ *
+ * abcg::VulkanDevice owns an upload context. Its functions are thread-safe,
+ * but functions that submit must not run concurrently with other submissions
+ * to the same queue.
+ *
+ * @sa abcg::VulkanDevice::getUploadContext.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::VulkanUploadContext {
+public:
+  /** @brief Default size of the staging ring buffer, in bytes. */
+  static constexpr vk::DeviceSize defaultStagingSize{32ULL * 1024 * 1024};
+  /** @brief Default number of batches that can be in flight. */
+  static constexpr uint32_t defaultBatchCount{3};
+
+  VulkanUploadContext();
+  VulkanUploadContext(VulkanUploadContext const &) = delete;
+  VulkanUploadContext(VulkanUploadContext &&) = delete;
+  VulkanUploadContext &operator=(VulkanUploadContext const &) = delete;
+  VulkanUploadContext &operator=(VulkanUploadContext &&) = delete;
+  ~VulkanUploadContext();
+
+  void create(vk::Device const &device, VulkanAllocator &allocator,
+              vk::Queue const &queue, uint32_t queueFamilyIndex,
+              vk::DeviceSize stagingSize = defaultStagingSize,
+              uint32_t batchCount = defaultBatchCount);
+  void destroy();
+
+  [[nodiscard]] VulkanStagingRange stage(std::span<std::byte const> data,
+                                         vk::DeviceSize alignment = 16);
+  VulkanUploadHandle
+  record(std::function<void(vk::CommandBuffer const &commandBuffer)> const
+             &fun);
+
+  VulkanUploadHandle uploadBuffer(vk::Buffer const &buffer,
+                                  std::span<std::byte const> data,
+                                  vk::DeviceSize offset = 0);
+  VulkanUploadHandle
+  uploadImage(vk::Image const &image, std::span<std::byte const> data,
+              std::span<vk::BufferImageCopy const> regions,
+              vk::ImageSubresourceRange const &subresourceRange,
+              vk::ImageLayout finalLayout =
+                  vk::ImageLayout::eShaderReadOnlyOptimal);
+
+  void submit();
+  void waitIdle();
+
+  [[nodiscard]] bool isComplete(VulkanUploadHandle const &handle);
+  void wait(VulkanUploadHandle const &handle);
+
+private:
+  struct Batch;
+
+  [[nodiscard]] Batch &slotOf(uint64_t batch);
+  [[nodiscard]] Batch &getRecordingBatch();
+  [[nodiscard]] VulkanUploadHandle makeHandle() noexcept;
+  [[nodiscard]] std::optional<vk::DeviceSize>
+  allocateStaging(vk::DeviceSize size, vk::DeviceSize alignment);
+  [[nodiscard]] std::pair<vk::Buffer, VulkanAllocation>
+  createStagingBuffer(vk::DeviceSize size) const;
+  void submitBatch();
+  void retireBatches(uint64_t batch, bool wait);
+  void releaseBatch(Batch &batch);
+
+  vk::Device m_device;
+  VulkanAllocator *m_allocator{};
+  vk::Queue m_queue;
+  vk::CommandPool m_commandPool;
+
+  // Staging ring buffer. Offsets are virtual: they increase monotonically and
+  // wrap around modulo the buffer size.
+  vk::Buffer m_stagingBuffer;
+  VulkanAllocation m_stagingAllocation;
+  vk::DeviceSize m_stagingSize{};
+  uint64_t m_stagingHead{};
+  uint64_t m_stagingTail{};
+
+  // Batches are identified by a sequence number starting at 1. Batch N uses
+  // slot N % m_batches.size(). All batches up to m_completedBatch are
+  // complete, and m_recordingBatch is the batch being recorded.
+  std::vector<Batch> m_batches;
+  uint64_t m_recordingBatch{1};
+  uint64_t m_completedBatch{};
+  // Whether a function passed to record() is running
+  bool m_insideRecord{};
+
+  // Recursive, as functions passed to record() call stage()
+  std::recursive_mutex m_mutex;
+};
+
+#endif
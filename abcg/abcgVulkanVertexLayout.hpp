@@ -0,0 +1,125 @@
+/**
+ * @file abcgVulkanVertexLayout.hpp
+ * @brief Vulkan vertex input descriptions derived from abcg::VertexLayout.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2023 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_VULKAN_VERTEX_LAYOUT_HPP_
+#define ABCG_VULKAN_VERTEX_LAYOUT_HPP_
+
+#include "abcgVertexLayout.hpp"
+#include "abcgVulkanExternal.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace abcg {
+[[nodiscard]] constexpr vk::Format
+getVulkanVertexFormat(VertexFormat format) noexcept;
+[[nodiscard]] constexpr vk::IndexType
+getVulkanIndexType(IndexFormat format) noexcept;
+
+template <HasVertexLayout Vertex>
+[[nodiscard]] constexpr vk::VertexInputBindingDescription
+getVulkanVertexBindingDescription(std::uint32_t binding = 0);
+template <HasVertexLayout Vertex>
+[[nodiscard]] constexpr auto
+getVulkanVertexAttributeDescriptions(std::uint32_t binding = 0);
+} // namespace abcg
+
+/**
+ * @brief Returns the Vulkan format of a vertex format.
+ *
+ * @param format Vertex format.
+ *
+ * @return Vulkan format. abcg::VertexFormat::Snorm10x3 maps to
+ * `vk::Format::eA2B10G10R10SnormPack32`, whose support as a vertex buffer
+ * format is optional and should be checked with
+ * `vk::PhysicalDevice::getFormatProperties`.
+ */
+constexpr vk::Format abcg::getVulkanVertexFormat(VertexFormat format) noexcept {
+  switch (format) {
+  case VertexFormat::Float32x1:
+    return vk::Format::eR32Sfloat;
+  case VertexFormat::Float32x2:
+    return vk::Format::eR32G32Sfloat;
+  case VertexFormat::Float32x3:
+    return vk::Format::eR32G32B32Sfloat;
+  case VertexFormat::Float32x4:
+    return vk::Format::eR32G32B32A32Sfloat;
+  case VertexFormat::Float16x2:
+    return vk::Format::eR16G16Sfloat;
+  case VertexFormat::Float16x4:
+    return vk::Format::eR16G16B16A16Sfloat;
+  case VertexFormat::Snorm16x2:
+    return vk::Format::eR16G16Snorm;
+  case VertexFormat::Snorm16x4:
+    return vk::Format::eR16G16B16A16Snorm;
+  case VertexFormat::Unorm8x4:
+    return vk::Format::eR8G8B8A8Unorm;
+  case VertexFormat::Snorm10x3:
+    return vk::Format::eA2B10G10R10SnormPack32;
+  }
+  return vk::Format::eUndefined;
+}
+
+/**
+ * @brief Returns the Vulkan index type of an index format.
+ *
+ * @param format Index format.
+ *
+ * @return `vk::IndexType::eUint16` or `vk::IndexType::eUint32`.
+ */
+constexpr vk::IndexType abcg::getVulkanIndexType(IndexFormat format) noexcept {
+  return format == IndexFormat::Uint16 ? vk::IndexType::eUint16
+                                       : vk::IndexType::eUint32;
+}
+
+/**
+ * @brief Returns the vertex binding description of a vertex type.
+ *
+ * @tparam Vertex Vertex type with a specialization of abcg::VertexLayout.
+ *
+ * @param binding Binding number.
+ *
+ * @return Per-vertex binding with a stride of `sizeof(Vertex)`.
+ */
+template <abcg::HasVertexLayout Vertex>
+constexpr vk::VertexInputBindingDescription
+abcg::getVulkanVertexBindingDescription(std::uint32_t binding) {
+  return {.binding = binding,
+          .stride = static_cast<std::uint32_t>(sizeof(Vertex)),
+          .inputRate = vk::VertexInputRate::eVertex};
+}
+
+/**
+ * @brief Returns the vertex attribute descriptions of a vertex type.
+ *
+ * @tparam Vertex Vertex type with a specialization of abcg::VertexLayout.
+ *
+ * @param binding Binding number of the vertex buffer.
+ *
+ * @return `std::array` of `vk::VertexInputAttributeDescription`, one for
+ * each attribute of the layout.
+ */
+template <abcg::HasVertexLayout Vertex>
+constexpr auto
+abcg::getVulkanVertexAttributeDescriptions(std::uint32_t binding) {
+  constexpr auto const &attributes{VertexLayout<Vertex>::attributes};
+  std::array<vk::VertexInputAttributeDescription, attributes.size()>
+      descriptions{};
+  for (std::size_t index{}; index < attributes.size(); ++index) {
+    descriptions[index] = {
+        .location = attributes[index].location,
+        .binding = binding,
+        .format = getVulkanVertexFormat(attributes[index].format),
+        .offset = attributes[index].offset};
+  }
+  return descriptions;
+}
+
+#endif
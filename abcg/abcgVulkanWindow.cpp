@@ -20,6 +20,7 @@
 #include "abcgException.hpp"
 #include "abcgVulkanError.hpp"
 #include "abcgVulkanInstance.hpp"
+#include "abcgVulkanUploadContext.hpp"
 #include "abcgWindow.hpp"
 
 namespace {
@@ -110,6 +111,19 @@ abcg::VulkanSwapchain const &abcg::VulkanWindow::getSwapchain() const noexcept {
   return m_swapchain;
 }
 
+/**
+ * @brief Returns the queue of textures being loaded in the background.
+ *
+ * The queue is polled once per frame before abcg::VulkanWindow::onPaint, and
+ * the textures still pending are discarded after
+ * abcg::VulkanWindow::onDestroy.
+ *
+ * @return Reference to the abcg::VulkanTextureQueue of the window.
+ */
+abcg::VulkanTextureQueue &abcg::VulkanWindow::getTextureQueue() noexcept {
+  return m_textureQueue;
+}
+
 /**
  * @brief Custom event handler.
  *
@@ -302,11 +316,15 @@ void abcg::VulkanWindow::create() {
                           sampleCount);
 
   // Create logical device
-  m_device.create(m_physicalDevice, m_deviceExtensions);
+  m_device.create(m_physicalDevice, m_deviceExtensions,
+                  m_vulkanSettings.pipelineCachePath);
 
   // Create swapchain
   m_swapchain.create(m_device, m_vulkanSettings, getWindowSize());
 
+  // Create the queue of textures loaded in the background
+  m_textureQueue.create(m_device);
+
   // Create descriptor pool
   std::vector<vk::DescriptorPoolSize> const poolSizes{
       {{vk::DescriptorType::eSampler, 100},
@@ -352,11 +370,12 @@ void abcg::VulkanWindow::create() {
       .Device = static_cast<vk::Device>(m_device),
       .QueueFamily = m_physicalDevice.getQueuesFamilies().graphics.value_or(0),
       .Queue = m_device.getQueues().graphics,
-      .PipelineCache = VK_NULL_HANDLE,
+      .PipelineCache = m_device.getPipelineCache(),
       .DescriptorPool = m_UIdescriptorPool,
       .Subpass = 0,
       .MinImageCount = 2,
-      .ImageCount = gsl::narrow<uint32_t>(m_swapchain.getFrames().size()),
+      // Dear ImGui rotates its buffers once per frame in flight
+      .ImageCount = std::max(m_swapchain.getFramesInFlight(), 2U),
       .MSAASamples =
           static_cast<VkSampleCountFlagBits>(m_physicalDevice.getSampleCount()),
       .Allocator = nullptr,
@@ -401,6 +420,12 @@ void abcg::VulkanWindow::create() {
 void abcg::VulkanWindow::paint() {
   onUpdate();
 
+  // Create the textures decoded since the last frame
+  m_textureQueue.poll();
+
+  // Submit the transfers recorded since the last frame
+  m_device.getUploadContext().submit();
+
   if (m_hidden || m_minimized)
     return;
 
@@ -433,6 +458,7 @@ void abcg::VulkanWindow::destroy() {
   ImGui::DestroyContext();
 
   static_cast<vk::Device>(m_device).destroyDescriptorPool(m_UIdescriptorPool);
+  m_textureQueue.destroy();
   m_swapchain.destroy();
   m_device.destroy();
   m_physicalDevice.destroy();
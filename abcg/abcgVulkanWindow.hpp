@@ -13,10 +13,13 @@
 #ifndef ABCG_VULKAN_WINDOW_HPP_
 #define ABCG_VULKAN_WINDOW_HPP_
 
+#include <string>
+
 #include "abcgVulkanDevice.hpp"
 #include "abcgVulkanInstance.hpp"
 #include "abcgVulkanPhysicalDevice.hpp"
 #include "abcgVulkanSwapchain.hpp"
+#include "abcgVulkanTextureQueue.hpp"
 #include "abcgWindow.hpp"
 
 namespace abcg {
@@ -57,6 +60,24 @@ struct abcg::VulkanSettings {
    * comes first.
    */
   bool vSync{false};
+
+  /** @brief Number of frames that can be in flight.
+   *
+   * The CPU can record up to this number of frames while previous frames are
+   * still being rendered. Each frame in flight has its own command buffers
+   * and descriptor pool (see abcg::VulkanFrame). The number is independent of
+   * the number of swapchain images. If zero, one frame per swapchain image is
+   * used.
+   */
+  uint32_t framesInFlight{2};
+
+  /** @brief Path to the file used to persist the pipeline cache across runs.
+   *
+   * The pipeline cache is loaded from this file when the Vulkan device is
+   * created, and saved back to it when the device is destroyed. If empty, the
+   * pipeline cache is kept only in memory.
+   */
+  std::string pipelineCachePath{};
 };
 
 /**
@@ -84,6 +105,7 @@ public:
   [[nodiscard]] VulkanPhysicalDevice const &getPhysicalDevice() const noexcept;
   [[nodiscard]] VulkanDevice const &getDevice() const noexcept;
   [[nodiscard]] VulkanSwapchain const &getSwapchain() const noexcept;
+  [[nodiscard]] VulkanTextureQueue &getTextureQueue() noexcept;
 
 protected:
   virtual void onEvent(SDL_Event const &event);
@@ -113,6 +135,7 @@ private:
   VulkanPhysicalDevice m_physicalDevice;
   VulkanDevice m_device;
   VulkanSwapchain m_swapchain;
+  VulkanTextureQueue m_textureQueue;
   vk::SurfaceKHR m_surface;
   vk::DescriptorPool m_UIdescriptorPool;
   bool m_hidden{};
@@ -105,49 +105,44 @@ void Level::loadFromFile(std::string const &filename) {
 
   glGenBuffers(1, &m_VBO);
   glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+  auto const packedVertices{packVertices(vertices)};
+  glBufferData(GL_ARRAY_BUFFER, packedVertices.size() * sizeof(Vertex), packedVertices.data(), GL_STATIC_DRAW);
 
   glGenBuffers(1, &m_EBO);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+  // Índices de 16 bits quando o número de vértices permite
+  auto const packedIndices{abcg::packIndices(indices, packedVertices.size())};
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, packedIndices.data.size(), packedIndices.data.data(), GL_STATIC_DRAW);
+  m_indexType = abcg::getOpenGLIndexType(packedIndices.format);
 
-  // Atributos de vértice (posição, normal, coordenadas de textura)
-  GLint positionAttribute = 0;
-  GLint normalAttribute = 1;
-  GLint texCoordAttribute = 2;
-
-  // Posições
-  glEnableVertexAttribArray(positionAttribute);
-  glVertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
-
-  // Normais
-  glEnableVertexAttribArray(normalAttribute);
-  glVertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
-
-  // Coordenadas de textura
-  glEnableVertexAttribArray(texCoordAttribute);
-  glVertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
+  // Atributos de vértice (posição, normal, coordenadas de textura), derivados
+  // do layout de Vertex
+  abcg::setupOpenGLVertexAttributes<Vertex>();
 
   glBindVertexArray(0);
 
   m_indicesCount = static_cast<GLsizei>(indices.size());
 }
 
-void Level::render(GLuint program) const {
+void Level::initialize(abcg::OpenGLProgram const &program) {
+  // Consulta as localizações uma única vez, na tabela refletida do programa
+  m_modelMatrixLoc = program.getUniformLocation("modelMatrix");
+  m_objectColorLoc = program.getUniformLocation("objectColor");
+}
+
+void Level::render(abcg::OpenGLProgram const &program) const {
   // Renderiza os tiles do nível
   glBindVertexArray(m_VAO);
 
   // Define a cor do material (por exemplo, cinza)
-  GLint objectColorLoc = glGetUniformLocation(program, "objectColor");
   glm::vec3 objectColor = glm::vec3(0.6f, 0.6f, 0.6f);
-  glUniform3fv(objectColorLoc, 1, &objectColor[0]);
+  program.setUniform(m_objectColorLoc, objectColor);
 
   // Envia a matriz modelo (identidade neste caso)
-  GLint modelMatrixLoc = glGetUniformLocation(program, "modelMatrix");
   glm::mat4 modelMatrix = glm::mat4(1.0f);
-  glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, &modelMatrix[0][0]);
+  program.setUniform(m_modelMatrixLoc, modelMatrix);
 
-  glDrawElements(GL_TRIANGLES, m_indicesCount, GL_UNSIGNED_INT, nullptr);
+  glDrawElements(GL_TRIANGLES, m_indicesCount, m_indexType, nullptr);
 
   glBindVertexArray(0);
 }
@@ -8,11 +8,13 @@
 
 #include "abcg.hpp"
 #include "glm/glm.hpp"
+#include "vertex.hpp"
 
 class Level {
 public:
   void loadFromFile(std::string const &filename);
-  void render(GLuint program) const;
+  void initialize(abcg::OpenGLProgram const &program);
+  void render(abcg::OpenGLProgram const &program) const;
   void destroy();
 
   int getCurrentLevel() const { return m_currentLevel; }
@@ -36,6 +38,11 @@ private:
 
   // Número de índices para desenhar os tiles
   GLsizei m_indicesCount{};
+  GLenum m_indexType{GL_UNSIGNED_INT};
+
+  // Localização das variáveis uniformes
+  GLint m_modelMatrixLoc{-1};
+  GLint m_objectColorLoc{-1};
 };
 
 #endif
@@ -5,7 +5,12 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <cmath>
 
-void PlayerBlock::initialize(GLuint program, glm::ivec2 const &startPosition) {
+void PlayerBlock::initialize(abcg::OpenGLProgram const &program,
+                             glm::ivec2 const &startPosition) {
+  // Localização das variáveis uniformes
+  m_modelMatrixLoc = program.getUniformLocation("modelMatrix");
+  m_objectColorLoc = program.getUniformLocation("objectColor");
+
   // Inicializa a posição e a orientação do bloco
   m_position = glm::vec3(startPosition.x + 0.5f, 0.5f, startPosition.y + 0.5f);
   m_orientation = Orientation::Standing;
@@ -71,28 +76,19 @@ void PlayerBlock::initialize(GLuint program, glm::ivec2 const &startPosition) {
 
   glGenBuffers(1, &m_VBO);
   glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+  auto const packedVertices{packVertices(vertices)};
+  glBufferData(GL_ARRAY_BUFFER, packedVertices.size() * sizeof(Vertex), packedVertices.data(), GL_STATIC_DRAW);
 
   glGenBuffers(1, &m_EBO);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-  // Atributos de vértice (posição, normal, coordenadas de textura)
-  GLint positionAttribute = 0;
-  GLint normalAttribute = 1;
-  GLint texCoordAttribute = 2;
-
-  // Posições
-  glEnableVertexAttribArray(positionAttribute);
-  glVertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
-
-  // Normais
-  glEnableVertexAttribArray(normalAttribute);
-  glVertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
+  // Índices de 16 bits quando o número de vértices permite
+  auto const packedIndices{abcg::packIndices(indices, packedVertices.size())};
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, packedIndices.data.size(), packedIndices.data.data(), GL_STATIC_DRAW);
+  m_indexType = abcg::getOpenGLIndexType(packedIndices.format);
 
-  // Coordenadas de textura
-  glEnableVertexAttribArray(texCoordAttribute);
-  glVertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
+  // Atributos de vértice (posição, normal, coordenadas de textura), derivados
+  // do layout de Vertex
+  abcg::setupOpenGLVertexAttributes<Vertex>();
 
   glBindVertexArray(0);
 
@@ -194,7 +190,7 @@ void PlayerBlock::update(float deltaTime, Level const &level) {
   }
 }
 
-void PlayerBlock::render(GLuint program) const {
+void PlayerBlock::render(abcg::OpenGLProgram const &program) const {
   // Renderiza o bloco do jogador
   glBindVertexArray(m_VAO);
 
@@ -212,15 +208,13 @@ void PlayerBlock::render(GLuint program) const {
   }
 
   // Envia a matriz modelo para o shader
-  GLint modelMatrixLoc = glGetUniformLocation(program, "modelMatrix");
-  glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, &modelMatrix[0][0]);
+  program.setUniform(m_modelMatrixLoc, modelMatrix);
 
   // Define a cor do material (por exemplo, azul)
-  GLint objectColorLoc = glGetUniformLocation(program, "objectColor");
   glm::vec3 objectColor = glm::vec3(0.0f, 0.5f, 1.0f);
-  glUniform3fv(objectColorLoc, 1, &objectColor[0]);
+  program.setUniform(m_objectColorLoc, objectColor);
 
-  glDrawElements(GL_TRIANGLES, m_indicesCount, GL_UNSIGNED_INT, nullptr);
+  glDrawElements(GL_TRIANGLES, m_indicesCount, m_indexType, nullptr);
 
   glBindVertexArray(0);
 }
@@ -14,9 +14,10 @@ enum class Orientation { Standing, LyingX, LyingZ };
 
 class PlayerBlock {
 public:
-  void initialize(GLuint program, glm::ivec2 const &startPosition);
+  void initialize(abcg::OpenGLProgram const &program,
+                  glm::ivec2 const &startPosition);
   void update(float deltaTime, Level const &level);
-  void render(GLuint program) const;
+  void render(abcg::OpenGLProgram const &program) const;
   void destroy();
 
   void queueMove(Direction dir);
@@ -43,6 +44,11 @@ private:
 
   // Número de índices para desenhar o bloco
   GLsizei m_indicesCount{};
+  GLenum m_indexType{GL_UNSIGNED_INT};
+
+  // Localização das variáveis uniformes
+  GLint m_modelMatrixLoc{-1};
+  GLint m_objectColorLoc{-1};
 
   // Animação
   bool m_isMoving{false};
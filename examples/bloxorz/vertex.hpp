@@ -0,0 +1,46 @@
+// vertex.hpp
+
+#ifndef VERTEX_HPP_
+#define VERTEX_HPP_
+
+#include <span>
+#include <vector>
+
+#include "abcgOpenGL.hpp"
+
+// Vértice compacto com 16 bytes (em vez de 8 floats): posição e coordenadas
+// de textura em meia precisão e normal no formato 10:10:10:2
+struct Vertex {
+  abcg::Float16x4 position;
+  abcg::Snorm10x3 normal;
+  abcg::Float16x2 texCoord;
+};
+
+// Layout usado pelos atributos do shader phong.vert
+template <> struct abcg::VertexLayout<Vertex> {
+  static constexpr std::array attributes{
+      VertexAttribute::of<decltype(Vertex::position)>(
+          0, offsetof(Vertex, position)),
+      VertexAttribute::of<decltype(Vertex::normal)>(1,
+                                                    offsetof(Vertex, normal)),
+      VertexAttribute::of<decltype(Vertex::texCoord)>(
+          2, offsetof(Vertex, texCoord))};
+};
+
+// Converte vértices com 8 floats intercalados (posição, normal e coordenadas
+// de textura) para o formato compacto
+inline std::vector<Vertex> packVertices(std::span<float const> data) {
+  std::vector<Vertex> vertices;
+  vertices.reserve(data.size() / 8);
+  for (std::size_t i = 0; i + 8 <= data.size(); i += 8) {
+    vertices.push_back(
+        {.position = abcg::Float16x4{glm::vec3{data[i], data[i + 1],
+                                               data[i + 2]}},
+         .normal = abcg::Snorm10x3{glm::vec3{data[i + 3], data[i + 4],
+                                             data[i + 5]}},
+         .texCoord = abcg::Float16x2{glm::vec2{data[i + 6], data[i + 7]}}});
+  }
+  return vertices;
+}
+
+#endif
@@ -10,11 +10,18 @@ void Window::onCreate() {
   glEnable(GL_CULL_FACE);
 
   // Carrega os shaders
-  m_program = createProgramFromFile(getAssetsPath() + "shaders/phong.vert",
-                                    getAssetsPath() + "shaders/phong.frag");
+  auto const assetsPath{abcg::Application::getAssetsPath()};
+  m_program.create({{.source = assetsPath + "phong.vert",
+                     .stage = abcg::ShaderStage::Vertex},
+                    {.source = assetsPath + "phong.frag",
+                     .stage = abcg::ShaderStage::Fragment}});
+  m_viewMatrixLoc = m_program.getUniformLocation("viewMatrix");
+  m_projMatrixLoc = m_program.getUniformLocation("projectionMatrix");
+  m_lightPosLoc = m_program.getUniformLocation("lightPosition");
 
   // Inicializa o estado do jogo
   m_level.loadFromFile(getAssetsPath() + "levels/level1.txt");
+  m_level.initialize(m_program);
   m_playerBlock.initialize(m_program, m_level.getStartPosition());
   m_camera.initialize();
 
@@ -53,22 +60,18 @@ void Window::onPaint() {
   glViewport(0, 0, m_viewportWidth, m_viewportHeight);
 
   // Ativa o shader program
-  glUseProgram(m_program);
+  m_program.use();
 
   // Configura as matrizes de projeção e visualização
   glm::mat4 viewMatrix = m_camera.getViewMatrix();
   glm::mat4 projectionMatrix = m_camera.getProjectionMatrix(m_viewportWidth, m_viewportHeight);
 
-  GLint viewMatrixLoc = glGetUniformLocation(m_program, "viewMatrix");
-  GLint projMatrixLoc = glGetUniformLocation(m_program, "projectionMatrix");
-
-  glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, &viewMatrix[0][0]);
-  glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, &projectionMatrix[0][0]);
+  m_program.setUniform(m_viewMatrixLoc, viewMatrix);
+  m_program.setUniform(m_projMatrixLoc, projectionMatrix);
 
   // Configura a luz
-  GLint lightPosLoc = glGetUniformLocation(m_program, "lightPosition");
   glm::vec3 lightPosition = glm::vec3(10.0f, 10.0f, 10.0f);
-  glUniform3fv(lightPosLoc, 1, &lightPosition[0]);
+  m_program.setUniform(m_lightPosLoc, lightPosition);
 
   // Renderiza o nível
   m_level.render(m_program);
@@ -105,7 +108,7 @@ void Window::onDestroy() {
   m_level.destroy();
 
   // Deleta o shader program
-  glDeleteProgram(m_program);
+  m_program.destroy();
 }
 
 void Window::onEvent(SDL_Event const &event) {
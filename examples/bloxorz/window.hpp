@@ -24,8 +24,11 @@ private:
   Level m_level;
   Camera m_camera;
 
-  // Shader program
-  GLuint m_program{};
+  // Shader program e localização das variáveis uniformes
+  abcg::OpenGLProgram m_program;
+  GLint m_viewMatrixLoc{-1};
+  GLint m_projMatrixLoc{-1};
+  GLint m_lightPosLoc{-1};
 
   // Variáveis de projeção e visualização
   int m_viewportWidth{};
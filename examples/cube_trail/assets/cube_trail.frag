@@ -2,18 +2,18 @@
 
 precision mediump float;
 
-uniform vec4 color;
 uniform mat4 viewMatrix;
 uniform samplerCube cubeTex;
 
 in vec3 fragV;
+in vec4 fragColor;
 out vec4 outColor;
 
 void main() {
   if (gl_FrontFacing) {
-    outColor = color;
+    outColor = fragColor;
   } else {
-    float i = (color.r + color.g + color.b) / 3.0;
+    float i = (fragColor.r + fragColor.g + fragColor.b) / 3.0;
     outColor = vec4(i, 0, 0, 1.0);
   }
 }
@@ -4,13 +4,31 @@ precision mediump float;
 
 
 layout(location = 0) in vec3 inPosition;
+// Per-instance tile data: xy = offset in grid units, z = gray, w = hole flag
+layout(location = 1) in vec4 inTile;
 
 uniform mat4 modelMatrix;
 uniform mat4 viewMatrix;
 uniform mat4 projMatrix;
+uniform vec4 color;
+uniform bool instanced;
 
 out vec3 fragV;
+out vec4 fragColor;
 
 void main() {
-  gl_Position = projMatrix * viewMatrix * modelMatrix * vec4(inPosition, 1.0);
+  vec3 position = inPosition;
+  fragColor = color;
+
+  if (instanced) {
+    if (inTile.w > 0.5) {
+      // Collapse holes into a degenerate primitive
+      gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+      return;
+    }
+    position += vec3(inTile.x, 0.0, inTile.y);
+    fragColor = vec4(vec3(inTile.z), 1.0);
+  }
+
+  gl_Position = projMatrix * viewMatrix * modelMatrix * vec4(position, 1.0);
 }
@@ -18,7 +18,8 @@ template <> struct std::hash<Vertex> {
   }
 };
 
-void Cube::createBuffers() {
+void Cube::createBuffers(std::span<Vertex const> vertices,
+                         std::span<GLuint const> indices) {
   // Deleta buffers anteriores
   abcg::glDeleteBuffers(1, &m_EBO);
   abcg::glDeleteBuffers(1, &m_VBO);
@@ -27,17 +28,17 @@ void Cube::createBuffers() {
   // VBO
   abcg::glGenBuffers(1, &m_VBO);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-  abcg::glBufferData(GL_ARRAY_BUFFER,
-                     sizeof(m_vertices.at(0)) * m_vertices.size(),
-                     m_vertices.data(), GL_STATIC_DRAW);
+  abcg::glBufferData(GL_ARRAY_BUFFER, vertices.size_bytes(), vertices.data(),
+                     GL_STATIC_DRAW);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-  // EBO for filled rendering
+  // EBO for filled rendering, com índices de 16 bits quando possível
+  auto const packedIndices{abcg::packIndices(indices, vertices.size())};
+  m_indexFormat = packedIndices.format;
   abcg::glGenBuffers(1, &m_EBO);
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-  abcg::glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                     sizeof(m_indices.at(0)) * m_indices.size(),
-                     m_indices.data(), GL_STATIC_DRAW);
+  abcg::glBufferData(GL_ELEMENT_ARRAY_BUFFER, packedIndices.data.size(),
+                     packedIndices.data.data(), GL_STATIC_DRAW);
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
   // EBO for wireframe rendering
@@ -46,41 +47,40 @@ void Cube::createBuffers() {
 
   // Create wireframe indices
   std::vector<GLuint> wireframeIndices;
-  for (size_t i = 0; i < m_indices.size(); i += 3) {
-    wireframeIndices.push_back(m_indices[i]);
-    wireframeIndices.push_back(m_indices[i + 1]);
-    wireframeIndices.push_back(m_indices[i + 1]);
-    wireframeIndices.push_back(m_indices[i + 2]);
-    wireframeIndices.push_back(m_indices[i + 2]);
-    wireframeIndices.push_back(m_indices[i]);
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    wireframeIndices.push_back(indices[i]);
+    wireframeIndices.push_back(indices[i + 1]);
+    wireframeIndices.push_back(indices[i + 1]);
+    wireframeIndices.push_back(indices[i + 2]);
+    wireframeIndices.push_back(indices[i + 2]);
+    wireframeIndices.push_back(indices[i]);
   }
 
+  auto const packedWireframeIndices{
+      abcg::packIndices(wireframeIndices, vertices.size())};
   abcg::glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                     sizeof(wireframeIndices.at(0)) * wireframeIndices.size(),
-                     wireframeIndices.data(), GL_STATIC_DRAW);
+                     packedWireframeIndices.data.size(),
+                     packedWireframeIndices.data.data(), GL_STATIC_DRAW);
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 void Cube::loadObj(std::string_view path) {
-  tinyobj::ObjReader reader;
-
-  if (!reader.ParseFromFile(path.data())) {
-    if (!reader.Error().empty()) {
-      throw abcg::RuntimeError(
-          fmt::format("Failed to load model {} ({})", path, reader.Error()));
-    }
-    throw abcg::RuntimeError(fmt::format("Failed to load model {}", path));
-  }
-
-  if (!reader.Warning().empty()) {
-    fmt::print("Warning: {}\n", reader.Warning());
+  // Usa o cache binário, se estiver atualizado. O cache já contém os níveis
+  // de detalhe, então os arrays mapeados vão direto para os buffers
+  abcg::MeshCache cache;
+  if (cache.load<Vertex>(path) && !cache.getLods().empty()) {
+    m_lods.assign(cache.getLods().begin(), cache.getLods().end());
+    m_bounds = cache.getBounds();
+    createBuffers(cache.getVertices<Vertex>(), cache.getIndices());
+    return;
   }
 
-  auto const &attrib{reader.GetAttrib()};
-  auto const &shapes{reader.GetShapes()};
+  auto const model{abcg::loadObjModel(path)};
+  auto const &attrib{model.attrib};
+  auto const &shapes{model.shapes};
 
-  m_vertices.clear();
-  m_indices.clear();
+  std::vector<Vertex> vertices;
+  std::vector<GLuint> indices;
 
   // Um mapa key:value com key=Vertex e value=index
   std::unordered_map<Vertex, GLuint> hash{};
@@ -102,20 +102,41 @@ void Cube::loadObj(std::string_view path) {
 
       // Se hash não contém este vértice
       if (!hash.contains(vertex)) {
-        // Adiciona este índice (tamanho de m_vertices)
-        hash[vertex] = m_vertices.size();
+        // Adiciona este índice (tamanho de vertices)
+        hash[vertex] = vertices.size();
         // Adiciona este vértice
-        m_vertices.push_back(vertex);
+        vertices.push_back(vertex);
       }
 
-      m_indices.push_back(hash[vertex]);
+      indices.push_back(hash[vertex]);
     }
   }
 
-  createBuffers();
+  // Reordena triângulos e vértices para reduzir as invocações do vertex
+  // shader, o overdraw e as faltas de cache na busca de vértices
+  auto const statistics{
+      abcg::optimizeMesh(std::span{vertices}, std::span{indices})};
+  fmt::print("{}: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}\n", path,
+             statistics.before.acmr, statistics.after.acmr,
+             statistics.before.atvr, statistics.after.atvr);
+
+  // Gera os níveis de detalhe, que compartilham o mesmo VBO
+  auto const chain{
+      abcg::generateMeshLods(std::span<Vertex const>{vertices}, indices, {})};
+  m_lods = chain.lods;
+  m_bounds = chain.bounds;
+
+  // Grava o cache para os próximos carregamentos
+  try {
+    cache.save<Vertex>(path, vertices, chain);
+  } catch (abcg::Exception const &exception) {
+    fmt::print("Warning: {}\n", exception.what());
+  }
+
+  createBuffers(vertices, chain.indices);
 }
 
-void Cube::paint() {
+void Cube::paint(glm::mat4 const &projMatrix, float viewportHeight) {
   // Configura as variáveis uniformes para o cubo
   m_positionMatrix = glm::translate(glm::mat4{1.0f}, m_position);
   m_modelMatrix = m_positionMatrix * m_animationMatrix;
@@ -135,26 +156,35 @@ void Cube::paint() {
 
   abcg::glUniformMatrix4fv(m_modelMatrixLoc, 1, GL_FALSE, &m_modelMatrix[0][0]);
 
+  // Seleciona o nível de detalhe pelo erro projetado na tela
+  auto const lodIndex{abcg::selectMeshLod(m_lods, m_bounds,
+                                          m_viewMatrix * m_modelMatrix,
+                                          projMatrix, viewportHeight)};
+  auto const &lod{m_lods.at(lodIndex)};
+  auto const indexCount{gsl::narrow<GLsizei>(lod.indexCount)};
+  auto const indexType{abcg::getOpenGLIndexType(m_indexFormat)};
+  auto const firstIndex{lod.firstIndex * abcg::getIndexSize(m_indexFormat)};
+
   abcg::glBindVertexArray(m_VAO);
 
   // Filled render
   abcg::glUniform4f(m_colorLoc, 0.36f, 0.26f, 0.56f, 0.8f); // Cor
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-  abcg::glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT,
-                       nullptr);
+  abcg::glDrawElements(GL_TRIANGLES, indexCount, indexType,
+                       reinterpret_cast<void const *>(firstIndex));
 
   // Wireframe render
   abcg::glUniform4f(m_colorLoc, 0.0f, 0.0f, 0.0f,
                     1.0f); // Cor das arestas (preto)
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_wireframeEBO);
-  abcg::glDrawElements(GL_LINES, m_indices.size() * 2, GL_UNSIGNED_INT,
-                       nullptr);
+  abcg::glDrawElements(GL_LINES, indexCount * 2, indexType,
+                       reinterpret_cast<void const *>(firstIndex * 2));
 
   abcg::glBindVertexArray(0);
 }
 
-void Cube::create(GLuint program, GLint modelMatrixLoc, GLint colorLoc,
-                  glm::mat4 viewMatrix, float scale, int N) {
+void Cube::create(abcg::OpenGLProgram const &program, glm::mat4 viewMatrix,
+                  float scale, int N) {
   // Libera o VAO anterior
   abcg::glDeleteVertexArrays(1, &m_VAO);
 
@@ -166,22 +196,16 @@ void Cube::create(GLuint program, GLint modelMatrixLoc, GLint colorLoc,
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
-  // Vincula os atributos de vértice
-  auto const positionAttribute{
-      abcg::glGetAttribLocation(program, "inPosition")};
-  if (positionAttribute >= 0) {
-    abcg::glEnableVertexAttribArray(positionAttribute);
-    abcg::glVertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE,
-                                sizeof(Vertex), nullptr);
-  }
+  // Vincula os atributos de vértice a partir do layout de Vertex
+  abcg::setupOpenGLVertexAttributes<Vertex>();
 
   // Fim da vinculação
   abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
   abcg::glBindVertexArray(0);
 
-  m_modelMatrixLoc = modelMatrixLoc;
+  m_modelMatrixLoc = program.getUniformLocation("modelMatrix");
   m_viewMatrix = viewMatrix;
-  m_colorLoc = colorLoc;
+  m_colorLoc = program.getUniformLocation("color");
   m_scale = scale;
   m_maxPos = m_scale * N;
 }
@@ -5,14 +5,15 @@
 #include "ground.hpp"
 #include "vertex.hpp"
 #include <random>
+#include <span>
 
 class Cube {
 public:
   void loadObj(std::string_view path);
-  void paint();
+  void paint(glm::mat4 const &projMatrix, float viewportHeight);
   void update(float deltaTime);
-  void create(GLuint program, GLint modelMatrixLoc, GLint colorLoc,
-              glm::mat4 viewMatrix, float scale, int N);
+  void create(abcg::OpenGLProgram const &program, glm::mat4 viewMatrix,
+              float scale, int N);
   void destroy() const;
   void moveLeft();
   void moveRight();
@@ -37,11 +38,13 @@ private:
   GLint m_colorLoc;
   GLuint m_wireframeEBO;
 
-  std::vector<Vertex> m_vertices;
-  std::vector<GLuint> m_indices;
+  std::vector<abcg::MeshLod> m_lods;
+  abcg::IndexFormat m_indexFormat{abcg::IndexFormat::Uint32};
+  abcg::BoundingSphere m_bounds;
   std::vector<GLuint> m_edgeIndices;
 
-  void createBuffers();
+  void createBuffers(std::span<Vertex const> vertices,
+                     std::span<GLuint const> indices);
 
   enum class Orientation { DOWN, RIGHT, UP, LEFT };
   enum class State { STANDING, LAYING_X, LAYING_Z };
@@ -1,7 +1,7 @@
 #include "ground.hpp"
 #include <random>
 
-void Ground::create(GLuint program, GLint modelMatrixLoc, GLint colorLoc, float scale, int N) {
+void Ground::create(abcg::OpenGLProgram const &program, float scale, int N) {
   // Define um quadrado unitário no plano xz
   m_vertices = {{
     {.position = {+0.5f, 0.0f, -0.5f}}, // Vértice 1
@@ -23,8 +23,7 @@ void Ground::create(GLuint program, GLint modelMatrixLoc, GLint colorLoc, float
   abcg::glBindVertexArray(m_VAO);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
   // Vincula os atributos de vértice
-  auto const positionAttribute{
-      abcg::glGetAttribLocation(program, "inPosition")};
+  auto const positionAttribute{program.getAttributeLocation("inPosition")};
   if (positionAttribute >= 0) {
     abcg::glEnableVertexAttribArray(positionAttribute);
     abcg::glVertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE,
@@ -37,17 +36,46 @@ void Ground::create(GLuint program, GLint modelMatrixLoc, GLint colorLoc, float
   // Initialize the grid with all tiles present
   m_N = N;
   m_scale = scale;
-  m_grid.resize(2 * m_N + 1, std::vector<bool>(2 * m_N + 1, true));
+  m_tiles.resize(2 * m_N + 1, 2 * m_N + 1, true);
+
+  // Per-tile instance buffer, attached to the same VAO
+  createInstances(program);
 
   // Randomize hole position on creation
   randomizeHole();
 
   // Carrega a localização das variáveis uniformes do shader
-  m_modelMatrixLoc = modelMatrixLoc;
-  m_colorLoc = colorLoc;
+  m_modelMatrixLoc = program.getUniformLocation("modelMatrix");
+  m_colorLoc = program.getUniformLocation("color");
 }
 
 void Ground::paint() {
+  if (m_instanced) {
+    paintInstanced();
+  } else {
+    paintPerTile();
+  }
+}
+
+void Ground::paintInstanced() {
+  uploadInstances();
+
+  abcg::glBindVertexArray(m_VAO);
+
+  // Tile offsets are given in grid units, so the model matrix only scales
+  auto const model{glm::scale(glm::mat4{1.0f}, glm::vec3(m_scale))};
+  abcg::glUniformMatrix4fv(m_modelMatrixLoc, 1, GL_FALSE, &model[0][0]);
+
+  // Holes are collapsed in the vertex shader
+  abcg::glUniform1i(m_instancedLoc, GL_TRUE);
+  abcg::glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4,
+                              gsl::narrow<GLsizei>(m_instances.size()));
+  abcg::glUniform1i(m_instancedLoc, GL_FALSE);
+
+  abcg::glBindVertexArray(0);
+}
+
+void Ground::paintPerTile() {
   abcg::glBindVertexArray(m_VAO);
 
   for (auto const z : iter::range(-m_N, m_N + 1)) {
@@ -74,6 +102,7 @@ void Ground::paint() {
 }
 
 void Ground::destroy() {
+  abcg::glDeleteBuffers(1, &m_instanceVBO);
   abcg::glDeleteBuffers(1, &m_VBO);
   abcg::glDeleteVertexArrays(1, &m_VAO);
 }
@@ -83,22 +112,16 @@ void Ground::setHole(int x, int z) {
   int gridX = x + m_N;
   int gridZ = z + m_N;
 
-  if (gridX >= 0 && gridX < 2 * m_N + 1 && gridZ >= 0 && gridZ < 2 * m_N + 1) {
-    m_grid[gridX][gridZ] = false; // Set tile as hole
+  if (m_tiles.contains(gridX, gridZ)) {
+    // Set tile as hole
+    if (m_tiles.set(gridX, gridZ, false)) {
+      updateInstance(x, z, false);
+    }
     m_holeX = x;
     m_holeZ = z;
   }
 }
 
-bool Ground::isTile(int x, int z) const {
-  int gridX = x + m_N;
-  int gridZ = z + m_N;
-  if (gridX >= 0 && gridX < 2 * m_N + 1 && gridZ >= 0 && gridZ < 2 * m_N + 1) {
-    return m_grid[gridX][gridZ];
-  }
-  return false; // Outside grid bounds
-}
-
 void Ground::getHolePosition(int& x, int& z) const {
   x = m_holeX;
   z = m_holeZ;
@@ -115,8 +138,16 @@ void Ground::randomizeHole() {
     newHoleZ = zDist(m_gen);
   } while (newHoleX == 0 && newHoleZ == 0); // Avoid placing hole at the center
 
-  // Clear previous grid and set hole
-  m_grid = std::vector<std::vector<bool>>(2 * m_N + 1, std::vector<bool>(2 * m_N + 1, true));
+  // Refill the previous holes, flipping only the bits that change. The new
+  // hole is left untouched if it is already a hole.
+  m_tiles.forEachHole([this, newHoleX, newHoleZ](int gridX, int gridZ) {
+    auto const x{gridX - m_N};
+    auto const z{gridZ - m_N};
+    if (x == newHoleX && z == newHoleZ)
+      return;
+    m_tiles.set(gridX, gridZ, true);
+    updateInstance(x, z, true);
+  });
   setHole(newHoleX, newHoleZ);
 }
 
@@ -127,4 +158,87 @@ bool Ground::isGameOver() const {
 void Ground::reset() {
   // Reset grid and randomize hole
   randomizeHole();
-}
\ No newline at end of file
+}
+
+void Ground::createInstances(abcg::OpenGLProgram const &program) {
+  // One instance per tile, row-major in z
+  m_instances.clear();
+  m_instances.reserve(gsl::narrow<std::size_t>((2 * m_N + 1) * (2 * m_N + 1)));
+  for (auto const z : iter::range(-m_N, m_N + 1)) {
+    for (auto const x : iter::range(-m_N, m_N + 1)) {
+      // Same checkerboard pattern as the per-tile path
+      auto const gray{(z + x) % 2 == 0 ? 0.5f : 1.0f};
+      m_instances.push_back({.offset = {gsl::narrow<float>(x),
+                                        gsl::narrow<float>(z)},
+                             .gray = gray,
+                             .hole = 0.0f});
+    }
+  }
+  m_dirtyBegin = std::numeric_limits<std::size_t>::max();
+  m_dirtyEnd = 0;
+
+  abcg::glGenBuffers(1, &m_instanceVBO);
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+  abcg::glBufferData(GL_ARRAY_BUFFER,
+                     sizeof(m_instances.at(0)) * m_instances.size(),
+                     m_instances.data(), GL_DYNAMIC_DRAW);
+
+  abcg::glBindVertexArray(m_VAO);
+  auto const tileAttribute{program.getAttributeLocation("inTile")};
+  if (tileAttribute >= 0) {
+    abcg::glEnableVertexAttribArray(tileAttribute);
+    abcg::glVertexAttribPointer(tileAttribute, 4, GL_FLOAT, GL_FALSE,
+                                sizeof(TileInstance), nullptr);
+    abcg::glVertexAttribDivisor(tileAttribute, 1);
+  }
+  abcg::glBindVertexArray(0);
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  m_instancedLoc = program.getUniformLocation("instanced");
+}
+
+void Ground::updateInstance(int x, int z, bool tile) {
+  if (m_instances.empty())
+    return;
+
+  auto const index{
+      gsl::narrow<std::size_t>((z + m_N) * (2 * m_N + 1) + (x + m_N))};
+  auto &instance{m_instances.at(index)};
+  if ((instance.hole > 0.5f) == !tile)
+    return;
+
+  instance.hole = tile ? 0.0f : 1.0f;
+  m_dirtyBegin = std::min(m_dirtyBegin, index);
+  m_dirtyEnd = std::max(m_dirtyEnd, index + 1);
+}
+
+void Ground::uploadInstances() {
+  if (m_dirtyBegin >= m_dirtyEnd)
+    return;
+
+  // Upload only the span of tiles touched since the last paint
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+  abcg::glBufferSubData(
+      GL_ARRAY_BUFFER,
+      gsl::narrow<GLintptr>(m_dirtyBegin * sizeof(TileInstance)),
+      gsl::narrow<GLsizeiptr>((m_dirtyEnd - m_dirtyBegin) *
+                              sizeof(TileInstance)),
+      &m_instances.at(m_dirtyBegin));
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  m_dirtyBegin = std::numeric_limits<std::size_t>::max();
+  m_dirtyEnd = 0;
+}
+
+int Ground::countTiles(int x0, int z0, int x1, int z1) const {
+  return m_tiles.countTiles(x0 + m_N, z0 + m_N, x1 - x0 + 1, z1 - z0 + 1);
+}
+
+std::optional<int> Ground::firstHoleInRow(int z,
+                                          std::optional<int> fromX) const {
+  if (auto const col{
+          m_tiles.firstHoleInRow(z + m_N, fromX.value_or(-m_N) + m_N)}) {
+    return *col - m_N;
+  }
+  return std::nullopt;
+}
@@ -2,21 +2,36 @@
 #define GROUND_HPP_
 
 #include "abcgOpenGL.hpp"
+#include "tilemap.hpp"
 #include "vertex.hpp"
+#include <limits>
+#include <optional>
 #include <vector>
 #include <random>
 
+// Per-tile data consumed by the instanced renderer
+struct TileInstance {
+  glm::vec2 offset{}; // Tile position in grid units (x, z)
+  float gray{};       // Checkerboard gray level
+  float hole{};       // 1 if the tile is a hole, 0 otherwise
+};
+
 class Ground {
 public:
-  void create(GLuint program, GLint modelMatrixLoc, GLint colorLoc, float scale, int N);
+  void create(abcg::OpenGLProgram const &program, float scale, int N);
   void paint();
   void destroy();
 
   // Add functions to manage the hole
   void setHole(int x, int z);
-  bool isTile(int x, int z) const;
+  bool isTile(int x, int z) const {
+    auto const gridX{x + m_N};
+    auto const gridZ{z + m_N};
+    // Outside grid bounds is not a tile
+    return m_tiles.contains(gridX, gridZ) && m_tiles.get(gridX, gridZ);
+  }
   void getHolePosition(int& x, int& z) const;
-  
+
   // New methods
   void randomizeHole(); // Método para gerar buraco aleatório
   bool isGameOver() const; // Verifica se o jogo terminou
@@ -26,6 +41,19 @@ public:
   int getHoleZ() const { return m_holeZ; }
   int getN() const { return m_N; }
 
+  // Bulk queries, in grid coordinates ([-N, N] on both axes)
+  // Number of tiles in the inclusive rectangle [x0, x1] x [z0, z1]
+  int countTiles(int x0, int z0, int x1, int z1) const;
+  // x of the first hole at or after fromX (default -N) in row z
+  std::optional<int> firstHoleInRow(int z,
+                                    std::optional<int> fromX = {}) const;
+  TileMap const &getTiles() const { return m_tiles; }
+
+  // Draw the whole board with a single instanced call (default), or fall back
+  // to one draw call per tile
+  void setInstanced(bool instanced) { m_instanced = instanced; }
+  bool isInstanced() const { return m_instanced; }
+
 
 private:
   std::vector<Vertex> m_vertices;
@@ -33,12 +61,21 @@ private:
   int m_N; // The grid size will be (2N+1) x (2N+1)
   GLuint m_VAO{};
   GLuint m_VBO{};
+  GLuint m_instanceVBO{};
 
   GLint m_modelMatrixLoc{};
   GLint m_colorLoc{};
+  GLint m_instancedLoc{};
+
+  // Bit-packed grid; column is x + N, row is z + N
+  TileMap m_tiles;
 
-  // 2D vector to represent the grid
-  std::vector<std::vector<bool>> m_grid;
+  // Instance data mirrored from m_tiles. Only the range [m_dirtyBegin,
+  // m_dirtyEnd) is uploaded on the next paint.
+  std::vector<TileInstance> m_instances;
+  std::size_t m_dirtyBegin{std::numeric_limits<std::size_t>::max()};
+  std::size_t m_dirtyEnd{};
+  bool m_instanced{true};
 
   // Coordinates of the hole
   int m_holeX{-1};
@@ -48,7 +85,11 @@ private:
   std::random_device m_rd;
   std::mt19937 m_gen{m_rd()};
 
-  
+  void createInstances(abcg::OpenGLProgram const &program);
+  void updateInstance(int x, int z, bool tile);
+  void uploadInstances();
+  void paintInstanced();
+  void paintPerTile();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,88 @@
+#include "tilemap.hpp"
+
+#include <algorithm>
+
+void TileMap::resize(int width, int height, bool tile) {
+  m_width = std::max(width, 0);
+  m_height = std::max(height, 0);
+  m_wordsPerRow =
+      (static_cast<std::size_t>(m_width) + wordBits - 1) / wordBits;
+
+  // Single allocation for the whole map
+  m_words.assign(m_wordsPerRow * static_cast<std::size_t>(m_height), 0U);
+  if (!tile)
+    return;
+
+  for (int row{}; row < m_height; ++row) {
+    auto const rowStart{static_cast<std::size_t>(row) * m_wordsPerRow};
+    for (std::size_t index{}; index < m_wordsPerRow; ++index) {
+      m_words[rowStart + index] = validMask(index);
+    }
+  }
+}
+
+bool TileMap::set(int col, int row, bool tile) {
+  if (!contains(col, row))
+    return false;
+
+  auto &word{m_words[wordIndex(col, row)]};
+  auto const mask{std::uint64_t{1} << bitIndex(col)};
+  auto const previous{word};
+  word = tile ? (word | mask) : (word & ~mask);
+  return word != previous;
+}
+
+int TileMap::countTiles(int col, int row, int width, int height) const {
+  // Clip to the map
+  auto const colBegin{std::max(col, 0)};
+  auto const colEnd{std::min(col + width, m_width)};
+  auto const rowBegin{std::max(row, 0)};
+  auto const rowEnd{std::min(row + height, m_height)};
+  if (colBegin >= colEnd || rowBegin >= rowEnd)
+    return 0;
+
+  auto const firstWord{static_cast<std::size_t>(colBegin) / wordBits};
+  auto const lastWord{static_cast<std::size_t>(colEnd - 1) / wordBits};
+  auto const headMask{~std::uint64_t{0} << bitIndex(colBegin)};
+  auto const tailMask{~std::uint64_t{0} >>
+                      (wordBits - 1 - bitIndex(colEnd - 1))};
+
+  int count{};
+  for (auto currentRow{rowBegin}; currentRow < rowEnd; ++currentRow) {
+    auto const rowStart{static_cast<std::size_t>(currentRow) * m_wordsPerRow};
+    for (auto index{firstWord}; index <= lastWord; ++index) {
+      auto word{m_words[rowStart + index]};
+      if (index == firstWord)
+        word &= headMask;
+      if (index == lastWord)
+        word &= tailMask;
+      count += std::popcount(word);
+    }
+  }
+  return count;
+}
+
+std::optional<int> TileMap::firstHoleInRow(int row, int fromCol) const {
+  fromCol = std::max(fromCol, 0);
+  if (row < 0 || row >= m_height || fromCol >= m_width)
+    return std::nullopt;
+
+  auto const rowStart{static_cast<std::size_t>(row) * m_wordsPerRow};
+  auto index{static_cast<std::size_t>(fromCol) / wordBits};
+  auto holes{~m_words[rowStart + index] & validMask(index) &
+             (~std::uint64_t{0} << bitIndex(fromCol))};
+  while (holes == 0U) {
+    if (++index == m_wordsPerRow)
+      return std::nullopt;
+    holes = ~m_words[rowStart + index] & validMask(index);
+  }
+  return static_cast<int>(index * wordBits) + std::countr_zero(holes);
+}
+
+std::uint64_t TileMap::validMask(std::size_t index) const noexcept {
+  auto const firstCol{index * wordBits};
+  auto const remaining{static_cast<std::size_t>(m_width) - firstCol};
+  if (remaining >= wordBits)
+    return ~std::uint64_t{0};
+  return (std::uint64_t{1} << remaining) - 1U;
+}
@@ -0,0 +1,76 @@
+#ifndef TILEMAP_HPP_
+#define TILEMAP_HPP_
+
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Flat, bit-packed map of tiles (bit set = tile, bit clear = hole).
+// Rows are stored contiguously, each one padded to a whole number of 64-bit
+// words so that row queries never straddle two rows. Padding bits are always
+// clear.
+class TileMap {
+public:
+  void resize(int width, int height, bool tile = true);
+
+  int getWidth() const noexcept { return m_width; }
+  int getHeight() const noexcept { return m_height; }
+
+  bool contains(int col, int row) const noexcept {
+    return col >= 0 && col < m_width && row >= 0 && row < m_height;
+  }
+
+  // Unchecked access; use contains() first for coordinates that may be out of
+  // bounds
+  bool get(int col, int row) const noexcept {
+    auto const word{m_words[wordIndex(col, row)]};
+    return ((word >> bitIndex(col)) & 1U) != 0U;
+  }
+
+  // Returns true if the tile changed
+  bool set(int col, int row, bool tile);
+
+  // Number of tiles (not holes) in the rectangle [col, col + width) x
+  // [row, row + height), clipped to the map
+  int countTiles(int col, int row, int width, int height) const;
+
+  // Column of the first hole at or after fromCol in the given row
+  std::optional<int> firstHoleInRow(int row, int fromCol = 0) const;
+
+  // Calls fun(col, row) for every hole. Cost is proportional to the number of
+  // words plus the number of holes.
+  template <typename TFun> void forEachHole(TFun &&fun) const {
+    for (int row{}; row < m_height; ++row) {
+      auto const rowStart{static_cast<std::size_t>(row) * m_wordsPerRow};
+      for (std::size_t index{}; index < m_wordsPerRow; ++index) {
+        auto holes{~m_words[rowStart + index] & validMask(index)};
+        while (holes != 0U) {
+          auto const bit{std::countr_zero(holes)};
+          fun(static_cast<int>(index * wordBits) + bit, row);
+          holes &= holes - 1U;
+        }
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t wordBits{64};
+
+  std::size_t wordIndex(int col, int row) const noexcept {
+    return static_cast<std::size_t>(row) * m_wordsPerRow +
+           static_cast<std::size_t>(col) / wordBits;
+  }
+  static unsigned bitIndex(int col) noexcept {
+    return static_cast<unsigned>(col) % wordBits;
+  }
+  // Mask of the bits of the index-th word of a row that map to actual columns
+  std::uint64_t validMask(std::size_t index) const noexcept;
+
+  std::vector<std::uint64_t> m_words;
+  std::size_t m_wordsPerRow{};
+  int m_width{};
+  int m_height{};
+};
+
+#endif
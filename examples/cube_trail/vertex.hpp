@@ -11,4 +11,11 @@ struct Vertex {
   friend bool operator==(Vertex const &, Vertex const &) = default;
 };
 
+// Layout do vértice (inPosition no shader)
+template <> struct abcg::VertexLayout<Vertex> {
+  static constexpr std::array attributes{
+      VertexAttribute::of<decltype(Vertex::position)>(
+          0, offsetof(Vertex, position))};
+};
+
 #endif
\ No newline at end of file
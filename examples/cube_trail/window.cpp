@@ -12,6 +12,9 @@ void Window::onEvent(SDL_Event const &event) {
       m_cube.moveLeft();
     if (event.key.keysym.sym == SDLK_d || event.key.keysym.sym == SDLK_RIGHT)
       m_cube.moveRight();
+    // Alterna entre o desenho instanciado e o desenho por tile do chão
+    if (event.key.keysym.sym == SDLK_i)
+      m_ground.setInstanced(!m_ground.isInstanced());
   }
 }
 
@@ -25,21 +28,17 @@ void Window::onCreate() {
       glm::lookAt(glm::vec3(1.9f, 1.9f, 1.9f), glm::vec3(0.0f, 0.0f, 0.0f),
                   glm::vec3(0.0f, 1.0f, 0.0f));
 
-  m_program =
-      abcg::createOpenGLProgram({{.source = assetsPath + "cube_trail.vert",
-                                  .stage = abcg::ShaderStage::Vertex},
-                                 {.source = assetsPath + "cube_trail.frag",
-                                  .stage = abcg::ShaderStage::Fragment}});
+  m_program.create({{.source = assetsPath + "cube_trail.vert",
+                     .stage = abcg::ShaderStage::Vertex},
+                    {.source = assetsPath + "cube_trail.frag",
+                     .stage = abcg::ShaderStage::Fragment}});
 
-  m_viewMatrixLoc = abcg::glGetUniformLocation(m_program, "viewMatrix");
-  m_projMatrixLoc = abcg::glGetUniformLocation(m_program, "projMatrix");
-  m_modelMatrixLoc = abcg::glGetUniformLocation(m_program, "modelMatrix");
-  m_colorLoc = abcg::glGetUniformLocation(m_program, "color");
+  m_viewMatrixLoc = m_program.getUniformLocation("viewMatrix");
+  m_projMatrixLoc = m_program.getUniformLocation("projMatrix");
 
-  m_ground.create(m_program, m_modelMatrixLoc, m_colorLoc, m_scale, m_N);
+  m_ground.create(m_program, m_scale, m_N);
   m_cube.loadObj(assetsPath + "box.obj");
-  m_cube.create(m_program, m_modelMatrixLoc, m_colorLoc, m_viewMatrix, m_scale,
-                m_N);
+  m_cube.create(m_program, m_viewMatrix, m_scale, m_N);
 
   // Vincula a instância de Ground ao Cube
   m_cube.setGround(&m_ground);
@@ -54,7 +53,7 @@ void Window::onPaint() {
 
   abcg::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   abcg::glViewport(0, 0, m_viewportSize.x, m_viewportSize.y);
-  abcg::glUseProgram(m_program);
+  m_program.use();
 
   // Set uniform variables that have the same value for every model
   auto const aspect{gsl::narrow<float>(m_viewportSize.x) /
@@ -62,10 +61,10 @@ void Window::onPaint() {
 
   m_projMatrix = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 5.0f);
 
-  abcg::glUniformMatrix4fv(m_viewMatrixLoc, 1, GL_FALSE, &m_viewMatrix[0][0]);
-  abcg::glUniformMatrix4fv(m_projMatrixLoc, 1, GL_FALSE, &m_projMatrix[0][0]);
+  m_program.setUniform(m_viewMatrixLoc, m_viewMatrix);
+  m_program.setUniform(m_projMatrixLoc, m_projMatrix);
 
-  m_cube.paint();
+  m_cube.paint(m_projMatrix, gsl::narrow<float>(m_viewportSize.y));
   m_ground.paint();
 
   abcg::glUseProgram(0);
@@ -76,5 +75,5 @@ void Window::onResize(glm::ivec2 const &size) { m_viewportSize = size; }
 void Window::onDestroy() {
   m_ground.destroy();
   m_cube.destroy();
-  abcg::glDeleteProgram(m_program);
+  m_program.destroy();
 }
@@ -19,17 +19,14 @@ private:
   float m_scale{0.2f};
   int m_N{3}; // Número de tiles do chão, 2N+1 x 2N+1
 
-  GLint m_modelMatrixLoc{};
   glm::mat4 m_viewMatrix{1.0f};
   GLint m_viewMatrixLoc{};
   glm::mat4 m_projMatrix{1.0f};
   GLint m_projMatrixLoc{};
 
-  GLint m_colorLoc{};
-
   Ground m_ground;
   Cube m_cube;
-  GLuint m_program{};
+  abcg::OpenGLProgram m_program;
 };
 
 #endif